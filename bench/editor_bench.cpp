@@ -0,0 +1,570 @@
+// benchmarks the parts of the editor that a key press (or loading and saving) goes through, on generated files from
+// 1KB up to 1GB. The results come out as pretty printed json with the keys sorted and the results always in the same
+// order, so the output of two commits can be diffed directly:
+//
+//     editor_bench --max-size 32m --output before.json
+//     editor_bench --max-size 32m --output after.json
+//     diff before.json after.json
+//
+// every benchmark runs its operation in samples, a sample is a batch of operations that's just long enough for the
+// clock to be accurate and the time per operation of each sample goes into a latency histogram. Samples are taken
+// until --min-time has passed (and at least MIN_NUM_SAMPLES were taken), anything an operation needs that shouldn't be
+// timed (a fresh buffer, edits to undo) gets set up between samples.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../src/graphics/viewport/viewport.hpp"
+#include "../src/utility/allocation_tracker/allocation_tracker.hpp"
+#include "../src/utility/fuzzy_file_matcher/fuzzy_file_matcher.hpp"
+#include "../src/utility/latency_histogram/latency_histogram.hpp"
+#include "../src/utility/search_pattern/search_pattern.hpp"
+#include "../src/utility/text_buffer/text_buffer.hpp"
+#include "../src/utility/undo_journal/undo_journal.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t KILOBYTE = 1024;
+constexpr size_t MEGABYTE = 1024 * KILOBYTE;
+constexpr size_t GIGABYTE = 1024 * MEGABYTE;
+
+// every 32 times bigger, which puts a step right below and above the size where loading switches to memory mapping
+const std::vector<size_t> FILE_SIZES = {KILOBYTE, 32 * KILOBYTE, MEGABYTE, 32 * MEGABYTE, GIGABYTE};
+
+constexpr size_t MIN_NUM_SAMPLES = 3;
+constexpr size_t MAX_NUM_SAMPLES = 100000;
+// a sample has to take at least this long, otherwise reading the clock is a noticeable part of it
+constexpr Clock::duration MIN_SAMPLE_DURATION = std::chrono::microseconds(100);
+constexpr size_t NUM_RANDOM_POSITIONS = 4096;
+
+constexpr int VIEWPORT_NUM_LINES = 50;
+constexpr int VIEWPORT_NUM_COLS = 200;
+// the file list grows with the file size (one path per this many bytes of file) but stops at MAX_NUM_FILES, a list
+// of a million paths is already far bigger than any project
+constexpr size_t BYTES_PER_FILE_IN_FILE_LIST = 64;
+constexpr size_t MAX_NUM_FILES = 1 << 20;
+constexpr size_t FILE_MATCH_RESULT_LIMIT = 10;
+
+struct BenchOptions {
+    size_t max_file_size = GIGABYTE;
+    std::chrono::milliseconds min_time{200};
+    // only benchmarks with this in their name run
+    std::string filter;
+    std::string output_path;
+    std::string label;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tbx_edit_bench";
+};
+
+struct Benchmark {
+    std::string name;
+    // gets things ready for a sample of this many operations, isn't timed
+    std::function<void(size_t)> prepare_sample = [](size_t) {};
+    // the operation being measured, the index goes from 0 to the number of operations in the sample
+    std::function<void(size_t)> run_operation;
+    // for operations that use something up (deleting lines from a small file)
+    size_t max_operations_per_sample = 1 << 16;
+    // when set the throughput is reported as well
+    size_t bytes_per_operation = 0;
+    // anything else worth knowing about the run, goes into the result as is
+    nlohmann::json parameters = nlohmann::json::object();
+};
+
+// keeps the compiler from throwing away results that are otherwise unused
+static volatile size_t result_sink = 0;
+static void consume(size_t value) { result_sink = result_sink + value; }
+
+static bool parse_size(const std::string &text, size_t &size) {
+    size_t num_digits = 0;
+    unsigned long long value = 0;
+    try {
+        value = std::stoull(text, &num_digits);
+    } catch (const std::exception &) {
+        return false;
+    }
+    std::string suffix = text.substr(num_digits);
+    if (suffix.empty() or suffix == "b") {
+        size = value;
+    } else if (suffix == "k" or suffix == "kb") {
+        size = value * KILOBYTE;
+    } else if (suffix == "m" or suffix == "mb") {
+        size = value * MEGABYTE;
+    } else if (suffix == "g" or suffix == "gb") {
+        size = value * GIGABYTE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void print_usage(const char *program_name) {
+    std::cerr << "usage: " << program_name << " [options]\n"
+              << "  --max-size <size>     largest file to benchmark on, like 32m or 1g (default 1g)\n"
+              << "  --min-time <ms>       how long each benchmark runs for at least (default 200)\n"
+              << "  --filter <text>       only run the benchmarks with this in their name\n"
+              << "  --output <path>       write the json here instead of to stdout\n"
+              << "  --label <text>        stored in the json, for telling runs apart (a commit hash)\n"
+              << "  --directory <path>    where the generated files go (default a directory in the temp directory)\n";
+}
+
+static bool parse_options(int argc, char *argv[], BenchOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--help" or argument == "-h") {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << argument << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (argument == "--max-size") {
+            if (not parse_size(value, options.max_file_size)) {
+                std::cerr << "invalid size: " << value << "\n";
+                return false;
+            }
+        } else if (argument == "--min-time") {
+            try {
+                options.min_time = std::chrono::milliseconds(std::stoll(value));
+            } catch (const std::exception &) {
+                std::cerr << "invalid time: " << value << "\n";
+                return false;
+            }
+        } else if (argument == "--filter") {
+            options.filter = value;
+        } else if (argument == "--output") {
+            options.output_path = value;
+        } else if (argument == "--label") {
+            options.label = value;
+        } else if (argument == "--directory") {
+            options.directory = value;
+        } else {
+            std::cerr << "unknown option: " << argument << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// writes made up c++ of about the given size, functions with nested blocks so that indentation and word motions have
+// something to work with, and a TODO(bench) comment every so often for the search to find. The same size always gives
+// the same file.
+static bool generate_source_file(const std::filesystem::path &file_path, size_t target_size) {
+    std::ofstream file(file_path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (not file.is_open()) {
+        return false;
+    }
+
+    std::mt19937 random_engine(1234);
+    std::string block;
+    size_t num_bytes_written = 0;
+    for (size_t block_index = 0; num_bytes_written < target_size; ++block_index) {
+        std::string index = std::to_string(block_index);
+        std::string factor = std::to_string(random_engine() % 100);
+
+        block.clear();
+        if (block_index % 64 == 0) {
+            block += "// TODO(bench): look at function_" + index + " again\n";
+        }
+        block += "int function_" + index + "(int value, const std::vector<int> &values) {\n";
+        block += "    int total_" + index + " = value * " + factor + ";\n";
+        block += "    for (int other_value : values) {\n";
+        block += "        if (other_value > total_" + index + ") {\n";
+        block += "            total_" + index + " += other_value - " + factor + ";\n";
+        block += "        }\n";
+        block += "    }\n";
+        block += "    return total_" + index + ";\n";
+        block += "}\n\n";
+
+        // the last block gets cut off so that the file comes out at exactly the size asked for
+        size_t num_bytes_to_write = std::min(block.size(), target_size - num_bytes_written);
+        file.write(block.data(), static_cast<std::streamsize>(num_bytes_to_write));
+        num_bytes_written += num_bytes_to_write;
+    }
+    return static_cast<bool>(file);
+}
+
+static std::vector<std::string> generate_file_list(size_t num_files) {
+    const std::vector<std::string> directories = {"src/graphics", "src/utility", "src/modal_editor", "include/detail",
+                                                  "tests/unit", "third_party/lib"};
+    const std::vector<std::string> words = {"text", "buffer", "view", "port", "search", "pattern", "undo", "journal",
+                                            "file", "matcher", "thread", "pool", "render", "input", "event", "queue"};
+    const std::vector<std::string> extensions = {".cpp", ".hpp", ".txt", ".json"};
+
+    std::mt19937 random_engine(5678);
+    std::vector<std::string> files;
+    files.reserve(num_files);
+    for (size_t i = 0; i < num_files; ++i) {
+        std::string name = words[random_engine() % words.size()] + "_" + words[random_engine() % words.size()];
+        files.push_back(directories[random_engine() % directories.size()] + "/" + name + "_" + std::to_string(i) +
+                        "/" + name + extensions[random_engine() % extensions.size()]);
+    }
+    return files;
+}
+
+// loads the file into a new buffer as if it was opened for the first time, the journal a previous load left behind
+// would otherwise get replayed into the undo history
+static std::shared_ptr<LineTextBuffer> load_untouched_buffer(const std::filesystem::path &file_path,
+                                                             bool wait_until_indexed) {
+    std::error_code error_code;
+    std::filesystem::remove(UndoJournal::get_journal_path(file_path.string()), error_code);
+
+    auto buffer = std::make_shared<LineTextBuffer>();
+    if (not buffer->load_file(file_path.string())) {
+        return nullptr;
+    }
+    while (wait_until_indexed and buffer->is_still_indexing()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return buffer;
+}
+
+struct Position {
+    int line;
+    int col;
+};
+
+static std::vector<Position> pick_random_positions(const LineTextBuffer &buffer) {
+    std::mt19937 random_engine(91011);
+    std::vector<Position> positions(NUM_RANDOM_POSITIONS);
+    for (Position &position : positions) {
+        position.line = static_cast<int>(random_engine() % static_cast<size_t>(buffer.line_count()));
+        position.col = static_cast<int>(random_engine() % (buffer.get_line(position.line).size() + 1));
+    }
+    return positions;
+}
+
+static nlohmann::json run_benchmark(const Benchmark &benchmark, const BenchOptions &options) {
+    // the first call can be a lot slower than the rest (lazily built indices, cold caches), timing it would stop the
+    // batch below from growing
+    benchmark.prepare_sample(1);
+    benchmark.run_operation(0);
+
+    // doubles the batch until a single sample takes long enough to time
+    size_t num_operations_per_sample = 1;
+    while (num_operations_per_sample < benchmark.max_operations_per_sample) {
+        benchmark.prepare_sample(num_operations_per_sample);
+        auto start = Clock::now();
+        for (size_t i = 0; i < num_operations_per_sample; ++i) {
+            benchmark.run_operation(i);
+        }
+        if (Clock::now() - start >= MIN_SAMPLE_DURATION) {
+            break;
+        }
+        num_operations_per_sample = std::min(num_operations_per_sample * 2, benchmark.max_operations_per_sample);
+    }
+
+    LatencyHistogram histogram;
+    Clock::duration total_duration{0};
+    size_t num_samples = 0;
+    AllocationCounts allocations;
+    while ((total_duration < options.min_time or num_samples < MIN_NUM_SAMPLES) and num_samples < MAX_NUM_SAMPLES) {
+        benchmark.prepare_sample(num_operations_per_sample);
+
+        AllocationCounts allocations_before = get_current_thread_allocation_counts();
+        auto start = Clock::now();
+        for (size_t i = 0; i < num_operations_per_sample; ++i) {
+            benchmark.run_operation(i);
+        }
+        Clock::duration sample_duration = Clock::now() - start;
+        AllocationCounts sample_allocations = get_current_thread_allocation_counts() - allocations_before;
+
+        histogram.record(std::chrono::duration_cast<LatencyHistogram::Duration>(sample_duration) /
+                         num_operations_per_sample);
+        total_duration += sample_duration;
+        allocations.num_allocations += sample_allocations.num_allocations;
+        allocations.num_bytes += sample_allocations.num_bytes;
+        ++num_samples;
+    }
+
+    size_t num_operations = num_samples * num_operations_per_sample;
+    nlohmann::json result = {
+        {"name", benchmark.name},
+        {"num_samples", num_samples},
+        {"num_operations", num_operations},
+        {"ns_per_operation",
+         {{"min", histogram.get_min().count()},
+          {"median", histogram.get_percentile(50).count()},
+          {"mean", histogram.get_mean().count()},
+          {"p90", histogram.get_percentile(90).count()},
+          {"p99", histogram.get_percentile(99).count()},
+          {"max", histogram.get_max().count()}}},
+    };
+    if (benchmark.bytes_per_operation > 0 and histogram.get_percentile(50).count() > 0) {
+        double seconds_per_operation = std::chrono::duration<double>(histogram.get_percentile(50)).count();
+        result["megabytes_per_second"] =
+            static_cast<double>(benchmark.bytes_per_operation) / static_cast<double>(MEGABYTE) / seconds_per_operation;
+    }
+    if constexpr (ALLOCATION_TRACKING_ENABLED) {
+        result["allocations_per_operation"] = static_cast<double>(allocations.num_allocations) / num_operations;
+        result["allocated_bytes_per_operation"] = static_cast<double>(allocations.num_bytes) / num_operations;
+    }
+    if (not benchmark.parameters.empty()) {
+        result["parameters"] = benchmark.parameters;
+    }
+    return result;
+}
+
+// NOTE: the order matters, everything up to save_file leaves the buffer as it was loaded and the ones after it edit
+// the buffer, so they go last
+static std::vector<Benchmark> create_benchmarks(const std::filesystem::path &file_path, size_t file_size,
+                                                std::shared_ptr<LineTextBuffer> &buffer,
+                                                std::shared_ptr<LineTextBuffer> &loaded_buffer,
+                                                std::shared_ptr<Viewport> &viewport,
+                                                std::shared_ptr<FuzzyFileMatcher> &file_matcher,
+                                                std::shared_ptr<const FuzzyFileMatcher::FileList> &files,
+                                                const std::vector<Position> &positions) {
+    // the benchmarks copy these, they outlive this function
+    auto position_at = [&positions](size_t i) { return positions[i % positions.size()]; };
+    // edits can make a line shorter than it was when the position was picked
+    auto clamped_position_at = [&buffer, position_at](size_t i) {
+        Position position = position_at(i);
+        position.line = std::min(position.line, buffer->line_count() - 1);
+        position.col = std::min(position.col, static_cast<int>(buffer->get_line(position.line).size()));
+        return position;
+    };
+
+    std::vector<Benchmark> benchmarks;
+
+    benchmarks.push_back({.name = "load_file",
+                          .prepare_sample = [&](size_t) { loaded_buffer.reset(); },
+                          .run_operation = [&](size_t) { loaded_buffer = load_untouched_buffer(file_path, false); },
+                          .max_operations_per_sample = 1,
+                          .bytes_per_operation = file_size});
+
+    // for big files load_file returns before the lines are indexed, this is how long it takes until they are
+    benchmarks.push_back({.name = "load_file_until_indexed",
+                          .prepare_sample = [&](size_t) { loaded_buffer.reset(); },
+                          .run_operation = [&](size_t) { loaded_buffer = load_untouched_buffer(file_path, true); },
+                          .max_operations_per_sample = 1,
+                          .bytes_per_operation = file_size});
+
+    auto search_pattern = std::make_shared<SearchPattern>("TODO\\(bench\\)");
+    benchmarks.push_back({.name = "find_forward_matches",
+                          .run_operation =
+                              [&, position_at, search_pattern](size_t i) {
+                                  Position position = position_at(i);
+                                  consume(buffer->find_forward_matches(position.line, 0, *search_pattern).size());
+                              },
+                          .bytes_per_operation = file_size / 2});
+
+    benchmarks.push_back({.name = "find_forward_by_word_index", .run_operation = [&, position_at](size_t i) {
+                              Position position = position_at(i);
+                              consume(buffer->find_forward_by_word_index(position.line, position.col));
+                          }});
+    benchmarks.push_back({.name = "find_forward_to_end_of_word", .run_operation = [&, position_at](size_t i) {
+                              Position position = position_at(i);
+                              consume(buffer->find_forward_to_end_of_word(position.line, position.col));
+                          }});
+    benchmarks.push_back({.name = "find_backward_by_word_index", .run_operation = [&, position_at](size_t i) {
+                              Position position = position_at(i);
+                              consume(buffer->find_backward_by_word_index(position.line, position.col));
+                          }});
+    benchmarks.push_back({.name = "find_backward_to_start_of_word", .run_operation = [&, position_at](size_t i) {
+                              Position position = position_at(i);
+                              consume(buffer->find_backward_to_start_of_word(position.line, position.col));
+                          }});
+
+    benchmarks.push_back({.name = "get_indentation_level", .run_operation = [&, position_at](size_t i) {
+                              Position position = position_at(i);
+                              consume(buffer->get_indentation_level(position.line, position.col));
+                          }});
+
+    // a full frame drawn cell by cell the way the renderer used to, and row by row the way it does now
+    benchmarks.push_back({.name = "viewport_get_symbol_at_full_frame", .run_operation = [&, position_at](size_t i) {
+                              viewport->set_active_buffer_line_col_under_cursor(position_at(i).line, 0, false);
+                              size_t checksum = 0;
+                              for (int line = 0; line < viewport->num_lines; ++line) {
+                                  for (int col = 0; col < viewport->num_cols; ++col) {
+                                      checksum += viewport->get_symbol_at(line, col);
+                                  }
+                              }
+                              consume(checksum);
+                          }});
+    auto rows = std::make_shared<std::vector<ViewportRow>>();
+    benchmarks.push_back({.name = "viewport_get_visible_rows_full_frame",
+                          .run_operation =
+                              [&, position_at, rows](size_t i) {
+                                  viewport->set_active_buffer_line_col_under_cursor(position_at(i).line, 0, false);
+                                  viewport->get_visible_rows(*rows);
+                                  consume(rows->size());
+                              }});
+
+    // the queries don't extend each other, so every one of them searches through the whole list
+    auto queries = std::make_shared<std::vector<std::string>>(
+        std::vector<std::string>{"txtbuf", "viewhpp", "undojrn", "srchcpp", "pooljson", "matchtxt"});
+    benchmarks.push_back(
+        {.name = "find_matching_files",
+         .run_operation =
+             [&, queries](size_t i) {
+                 const std::string &query = (*queries)[i % queries->size()];
+                 consume(file_matcher->find_best_matches(query, files, FILE_MATCH_RESULT_LIMIT).size());
+             },
+         .parameters = {{"num_files", files->size()}, {"result_limit", FILE_MATCH_RESULT_LIMIT}}});
+
+    benchmarks.push_back({.name = "save_file",
+                          .run_operation =
+                              [&](size_t) {
+                                  buffer->save_file();
+                                  buffer->wait_until_saved();
+                                  buffer->update_save();
+                              },
+                          .max_operations_per_sample = 1,
+                          .bytes_per_operation = file_size});
+
+    benchmarks.push_back({.name = "insert_character", .run_operation = [&, clamped_position_at](size_t i) {
+                              Position position = clamped_position_at(i);
+                              buffer->insert_character(position.line, position.col, 'x');
+                          }});
+
+    // every edit is its own undo group, so every undo and redo takes back or puts back exactly one character
+    benchmarks.push_back({.name = "undo",
+                          .prepare_sample =
+                              [&, clamped_position_at](size_t num_operations) {
+                                  for (size_t i = 0; i < num_operations; ++i) {
+                                      Position position = clamped_position_at(i);
+                                      buffer->begin_undo_group();
+                                      buffer->insert_character(position.line, position.col, 'x');
+                                  }
+                              },
+                          .run_operation = [&](size_t) { buffer->undo(); }});
+    benchmarks.push_back({.name = "redo",
+                          .prepare_sample =
+                              [&, clamped_position_at](size_t num_operations) {
+                                  for (size_t i = 0; i < num_operations; ++i) {
+                                      Position position = clamped_position_at(i);
+                                      buffer->begin_undo_group();
+                                      buffer->insert_character(position.line, position.col, 'x');
+                                  }
+                                  for (size_t i = 0; i < num_operations; ++i) {
+                                      buffer->undo();
+                                  }
+                              },
+                          .run_operation = [&](size_t) { buffer->redo(); }});
+
+    // a small file runs out of lines, it gets loaded again before that happens
+    size_t num_lines = static_cast<size_t>(buffer->line_count());
+    benchmarks.push_back({.name = "delete_line",
+                          .prepare_sample =
+                              [&](size_t num_operations) {
+                                  if (static_cast<size_t>(buffer->line_count()) <= num_operations) {
+                                      buffer = load_untouched_buffer(file_path, true);
+                                  }
+                              },
+                          .run_operation =
+                              [&, position_at](size_t i) {
+                                  buffer->delete_line(position_at(i).line % buffer->line_count());
+                              },
+                          .max_operations_per_sample = std::max<size_t>(num_lines / 2, 1)});
+
+    return benchmarks;
+}
+
+static bool run_benchmarks_on_file_size(size_t file_size, const BenchOptions &options, nlohmann::json &results) {
+    std::filesystem::path file_path = options.directory / ("generated_" + std::to_string(file_size) + ".cpp");
+    std::cerr << "generating " << file_path.string() << "\n";
+    if (not generate_source_file(file_path, file_size)) {
+        std::cerr << "couldn't write " << file_path.string() << "\n";
+        return false;
+    }
+
+    std::shared_ptr<LineTextBuffer> buffer = load_untouched_buffer(file_path, true);
+    if (buffer == nullptr) {
+        std::cerr << "couldn't load " << file_path.string() << "\n";
+        return false;
+    }
+    int num_lines = buffer->line_count();
+    std::vector<Position> positions = pick_random_positions(*buffer);
+
+    std::shared_ptr<LineTextBuffer> loaded_buffer;
+    auto viewport = std::make_shared<Viewport>(buffer, VIEWPORT_NUM_LINES, VIEWPORT_NUM_COLS, VIEWPORT_NUM_LINES / 2,
+                                               VIEWPORT_NUM_COLS / 2);
+    auto file_matcher = std::make_shared<FuzzyFileMatcher>();
+    std::shared_ptr<const FuzzyFileMatcher::FileList> files = std::make_shared<const FuzzyFileMatcher::FileList>(
+        generate_file_list(std::clamp<size_t>(file_size / BYTES_PER_FILE_IN_FILE_LIST, 1, MAX_NUM_FILES)));
+
+    std::vector<Benchmark> benchmarks =
+        create_benchmarks(file_path, file_size, buffer, loaded_buffer, viewport, file_matcher, files, positions);
+    for (const Benchmark &benchmark : benchmarks) {
+        if (benchmark.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        std::cerr << "  " << benchmark.name << " on " << file_size << " bytes\n";
+        nlohmann::json result = run_benchmark(benchmark, options);
+        result["file_size"] = file_size;
+        result["num_lines"] = num_lines;
+        results.push_back(std::move(result));
+    }
+
+    // the viewport holds onto the buffer, let go of both before the file goes away
+    viewport.reset();
+    loaded_buffer.reset();
+    buffer.reset();
+    std::error_code error_code;
+    std::filesystem::remove(UndoJournal::get_journal_path(file_path.string()), error_code);
+    std::filesystem::remove(file_path, error_code);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    if (not parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::error_code error_code;
+    std::filesystem::create_directories(options.directory, error_code);
+    if (error_code) {
+        std::cerr << "couldn't create " << options.directory.string() << ": " << error_code.message() << "\n";
+        return 1;
+    }
+
+    // the undo journals of the generated files go next to them instead of into the real state directory
+    std::string state_directory = (options.directory / "state").string();
+#if defined(_WIN32) || defined(_WIN64)
+    _putenv_s("XDG_STATE_HOME", state_directory.c_str());
+#else
+    setenv("XDG_STATE_HOME", state_directory.c_str(), 1);
+#endif
+
+    nlohmann::json results = nlohmann::json::array();
+    for (size_t file_size : FILE_SIZES) {
+        if (file_size > options.max_file_size) {
+            break;
+        }
+        if (not run_benchmarks_on_file_size(file_size, options, results)) {
+            return 1;
+        }
+    }
+    std::filesystem::remove_all(options.directory / "state", error_code);
+
+    nlohmann::json output = {{"label", options.label},
+                             {"min_time_ms", options.min_time.count()},
+                             {"allocation_tracking", ALLOCATION_TRACKING_ENABLED},
+                             {"results", std::move(results)}};
+
+    if (options.output_path.empty()) {
+        std::cout << output.dump(4) << "\n";
+        return 0;
+    }
+    std::ofstream file(options.output_path, std::ios::out | std::ios::trunc);
+    if (not file.is_open()) {
+        std::cerr << "couldn't write " << options.output_path << "\n";
+        return 1;
+    }
+    file << output.dump(4) << "\n";
+    return 0;
+}
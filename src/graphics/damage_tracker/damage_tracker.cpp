@@ -0,0 +1,82 @@
+#include "damage_tracker.hpp"
+
+#include <algorithm>
+
+void DamageTracker::resize(int num_rows) {
+    num_rows = std::max(num_rows, 0);
+    if (num_rows != static_cast<int>(dirty_rows.size())) {
+        dirty_rows.assign(num_rows, true);
+    }
+}
+
+void DamageTracker::mark_all_rows_dirty() { std::fill(dirty_rows.begin(), dirty_rows.end(), true); }
+
+void DamageTracker::mark_rows_dirty(int start_row, int end_row) {
+    start_row = std::max(start_row, 0);
+    end_row = std::min(end_row, static_cast<int>(dirty_rows.size()));
+    for (int row = start_row; row < end_row; ++row) {
+        dirty_rows[row] = true;
+    }
+}
+
+void DamageTracker::mark_text_modification_dirty(const TextModification &modification, int first_visible_buffer_line) {
+    const TextRange &range = modification.text_range_to_replace;
+
+    bool changes_line_count = range.start_line != range.end_line or
+                              modification.new_content.find('\n') != std::string::npos;
+
+    int start_row = std::min(range.start_line, range.end_line) - first_visible_buffer_line;
+    if (changes_line_count) {
+        mark_rows_dirty(start_row, static_cast<int>(dirty_rows.size()));
+    } else {
+        mark_rows_dirty(start_row, start_row + 1);
+    }
+}
+
+void DamageTracker::set_view_origin(int first_visible_buffer_line, int first_visible_buffer_col) {
+    bool view_moved = not view_origin_is_known or first_visible_buffer_line != last_first_visible_buffer_line or
+                      first_visible_buffer_col != last_first_visible_buffer_col;
+    if (view_moved) {
+        mark_all_rows_dirty();
+    }
+    view_origin_is_known = true;
+    last_first_visible_buffer_line = first_visible_buffer_line;
+    last_first_visible_buffer_col = first_visible_buffer_col;
+}
+
+void DamageTracker::set_cursor_position(int row, int col) {
+    if (row != last_cursor_row or col != last_cursor_col) {
+        mark_rows_dirty(last_cursor_row, last_cursor_row + 1);
+        mark_rows_dirty(row, row + 1);
+    }
+    last_cursor_row = row;
+    last_cursor_col = col;
+}
+
+bool DamageTracker::is_row_dirty(int row) const {
+    return row >= 0 and row < static_cast<int>(dirty_rows.size()) and dirty_rows[row];
+}
+
+bool DamageTracker::has_dirty_rows() const {
+    return std::find(dirty_rows.begin(), dirty_rows.end(), true) != dirty_rows.end();
+}
+
+std::vector<RowSpan> DamageTracker::get_dirty_row_spans() const {
+    std::vector<RowSpan> spans;
+    int num_rows = static_cast<int>(dirty_rows.size());
+    int row = 0;
+    while (row < num_rows) {
+        if (not dirty_rows[row]) {
+            ++row;
+            continue;
+        }
+        int span_start = row;
+        while (row < num_rows and dirty_rows[row]) {
+            ++row;
+        }
+        spans.push_back({span_start, row});
+    }
+    return spans;
+}
+
+void DamageTracker::clear() { std::fill(dirty_rows.begin(), dirty_rows.end(), false); }
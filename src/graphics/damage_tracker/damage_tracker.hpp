@@ -0,0 +1,55 @@
+#ifndef DAMAGE_TRACKER_HPP
+#define DAMAGE_TRACKER_HPP
+
+#include <vector>
+
+#include "../../utility/text_diff/text_diff.hpp"
+
+// a run of rows on the screen, [start_row, end_row)
+struct RowSpan {
+    int start_row;
+    int end_row;
+};
+
+// keeps track of which rows of the screen no longer show what was last drawn, so the frontend only has to redraw
+// those instead of the whole screen.
+//
+// rows get damaged in three ways, an edit changes the lines it touched, the cursor moves which changes the row it left
+// and the row it went to, or the view moves in which case every row shows something different
+class DamageTracker {
+  public:
+    // changing the number of rows damages everything
+    void resize(int num_rows);
+
+    void mark_all_rows_dirty();
+    void mark_rows_dirty(int start_row, int end_row);
+
+    // first_visible_buffer_line is the buffer line shown in row 0, when the modification can change the number of
+    // lines every row from its start down to the bottom of the screen is damaged because those lines get shifted
+    void mark_text_modification_dirty(const TextModification &modification, int first_visible_buffer_line);
+
+    // the buffer position shown in the top left of the screen, every row is damaged when it differs from the last
+    // call
+    void set_view_origin(int first_visible_buffer_line, int first_visible_buffer_col);
+
+    // where on the screen the cursor is drawn, when it differs from the last call the row it was drawn on and the row
+    // it's on now are damaged
+    void set_cursor_position(int row, int col);
+
+    bool is_row_dirty(int row) const;
+    bool has_dirty_rows() const;
+    std::vector<RowSpan> get_dirty_row_spans() const;
+
+    // call once everything dirty has been redrawn
+    void clear();
+
+  private:
+    std::vector<bool> dirty_rows;
+    bool view_origin_is_known = false;
+    int last_first_visible_buffer_line = 0;
+    int last_first_visible_buffer_col = 0;
+    int last_cursor_row = -1;
+    int last_cursor_col = -1;
+};
+
+#endif // DAMAGE_TRACKER_HPP
@@ -1,6 +1,9 @@
 #include "viewport.hpp"
 
+#include <algorithm>
 #include <cctype> // For std::isalnum
+#include <charconv>
+#include <string_view>
 
 Viewport::Viewport(std::shared_ptr<LineTextBuffer> initial_buffer, int num_lines, int num_cols, int cursor_line_offset,
                    int cursor_col_offset)
@@ -8,9 +11,8 @@ Viewport::Viewport(std::shared_ptr<LineTextBuffer> initial_buffer, int num_lines
       half_num_cols(cursor_col_offset), active_buffer_line_under_cursor(0), active_buffer_col_under_cursor(0),
       selection_mode_on(false) {
 
-    // Initialize the previous_state with the same dimensions as the viewport
-    previous_viewport_screen.resize(num_lines, std::vector<char>(num_cols, ' '));
     active_file_buffers.push_back(initial_buffer);
+    center_view_on_cursor();
 }
 
 void Viewport::switch_buffers_and_adjust_viewport_position(std::shared_ptr<LineTextBuffer> ltb,
@@ -22,6 +24,8 @@ void Viewport::switch_buffers_and_adjust_viewport_position(std::shared_ptr<LineT
     }
 
     buffer = ltb;
+    // whatever was on screen belonged to the other buffer
+    damage_tracker.mark_all_rows_dirty();
 
     auto it_buffer = std::find_if(
         active_file_buffers.begin(), active_file_buffers.end(),
@@ -39,45 +43,27 @@ void Viewport::switch_buffers_and_adjust_viewport_position(std::shared_ptr<LineT
     } else {
         set_active_buffer_line_col_under_cursor(0, 0, store_movement_to_history);
     }
+    center_view_on_cursor();
 }
 
-void Viewport::tick() {
-    // Update the previous state with the current content
-    save_previous_viewport_screen();
-}
-
-bool Viewport::has_cell_changed(int line, int col) const {
-    // Check if the given cell has changed by comparing current symbol with the previous state
-    if (line >= 0 && line < num_lines && col >= 0 && col < num_cols) {
-        return get_symbol_at(line, col) != previous_viewport_screen[line][col];
-    }
-    return false; // If the line/col are out of bounds, return false
-}
-
-std::vector<std::pair<int, int>> Viewport::get_changed_cells_since_last_tick() const {
-    std::vector<std::pair<int, int>> changed_cells;
+std::vector<RowSpan> Viewport::get_dirty_row_spans() {
+    damage_tracker.resize(num_lines);
 
-    // Iterate over the visible area of the buffer and compare with the previous state
-    for (int line = 0; line < num_lines; ++line) {
-        for (int col = 0; col < num_cols; ++col) {
-            char current_symbol = get_symbol_at(line, col);
+    // the screen may have been resized since the cursor last moved
+    keep_cursor_in_view();
+    damage_tracker.set_view_origin(first_visible_buffer_line, first_visible_buffer_col);
+    auto [cursor_row, cursor_col] = get_cursor_viewport_idx();
+    damage_tracker.set_cursor_position(cursor_row, cursor_col);
 
-            // If the symbol has changed, mark this cell as changed
-            if (current_symbol != previous_viewport_screen[line][col]) {
-                changed_cells.emplace_back(line, col);
-            }
-        }
+    bool all_lines_modified;
+    for (const auto &modification : buffer->take_unrendered_modifications(all_lines_modified)) {
+        damage_tracker.mark_text_modification_dirty(modification, first_visible_buffer_line);
     }
-
-    return changed_cells;
-}
-
-void Viewport::save_previous_viewport_screen() {
-    for (int line = 0; line < num_lines; ++line) {
-        for (int col = 0; col < num_cols; ++col) {
-            previous_viewport_screen[line][col] = get_symbol_at(line, col);
-        }
+    if (all_lines_modified) {
+        damage_tracker.mark_all_rows_dirty();
     }
+
+    return damage_tracker.get_dirty_row_spans();
 }
 
 void Viewport::scroll(int line_delta, int col_delta) {
@@ -104,6 +90,7 @@ void Viewport::scroll_right() {
 void Viewport::set_active_buffer_line_col_under_cursor(int line, int col, bool store_pos_to_history) {
     active_buffer_line_under_cursor = line;
     active_buffer_col_under_cursor = col;
+    keep_cursor_in_view();
     moved_signal.toggle_state();
     if (store_pos_to_history) {
         history.add_flc_to_history(buffer->current_file_path, active_buffer_line_under_cursor,
@@ -119,29 +106,40 @@ void Viewport::set_active_buffer_col_under_cursor(int col, bool store_pos_to_his
     set_active_buffer_line_col_under_cursor(active_buffer_line_under_cursor, col, store_pos_to_history);
 }
 
-// the active buffer line under cursor is where the cursor currently is inside of the buffer,
-// our goal is to always have that at the center of the screen, in order to make this occur we need to place the
-// cursor position in the middle,
-//
+void Viewport::center_view_on_cursor() {
+    first_visible_buffer_line = active_buffer_line_under_cursor - half_num_lines;
+    first_visible_buffer_col = active_buffer_col_under_cursor - half_num_cols;
+}
+
+// NOTE: jumping back to the center instead of scrolling one row at a time means holding j redraws the screen once
+// every quarter of a screen instead of on every press
+void Viewport::keep_cursor_in_view() {
+    int margin_lines = num_lines / 4;
+    int margin_cols = num_cols / 4;
+    auto [cursor_row, cursor_col] = get_cursor_viewport_idx();
+    if (cursor_row < margin_lines or cursor_row >= num_lines - margin_lines) {
+        first_visible_buffer_line = active_buffer_line_under_cursor - half_num_lines;
+    }
+    if (cursor_col < margin_cols or cursor_col >= num_cols - margin_cols) {
+        first_visible_buffer_col = active_buffer_col_under_cursor - half_num_cols;
+    }
+}
+
+std::pair<int, int> Viewport::get_cursor_viewport_idx() const {
+    return {active_buffer_line_under_cursor - first_visible_buffer_line,
+            active_buffer_col_under_cursor - first_visible_buffer_col};
+}
+
 // The arguments to this function come in with the following indexing method: top left is (0, 0) and rightward and
-// downward movement is positive
-//
-// That means when the argument (half_num_lines, half_num_cols) comse in, we're requesting what character should be
-// rendered in the middle of the screen, based off what we discussed above, we would assume that we should get the
-// character at position (0, 0) in the file, because that's the current (abluc, abcuc) pair. To do this we just have
-// to subtract the half dimensions to make this occur
-//
-// when (0, 0) is passed in, it will be in some non-visible part of the buffer because we start the buffer with (0, 0)
-// in the middle of the screen
-std::pair<int, int> Viewport::viewport_idx_to_centered_buffer_idx(int line, int col) const {
-    return {(line - half_num_lines) + active_buffer_line_under_cursor,
-            (col - half_num_cols) + active_buffer_col_under_cursor};
+// downward movement is positive, the view origin is what sits at (0, 0)
+std::pair<int, int> Viewport::viewport_idx_to_buffer_idx(int line, int col) const {
+    return {line + first_visible_buffer_line, col + first_visible_buffer_col};
 }
 
 // the passed in coordinates are those from top left down to bottom right
 char Viewport::get_symbol_at(int line, int col) const {
 
-    auto [buffer_line_idx, buffer_col_idx] = viewport_idx_to_centered_buffer_idx(line, col);
+    auto [buffer_line_idx, buffer_col_idx] = viewport_idx_to_buffer_idx(line, col);
 
     // Check if the line index is within bounds
     if (buffer_line_idx < buffer->line_count() && buffer_line_idx >= 0) {
@@ -157,7 +155,7 @@ char Viewport::get_symbol_at(int line, int col) const {
             }
         } else {
             // Handle non-negative column indices: Render buffer content
-            const std::string &line_content = buffer->get_line(buffer_line_idx);
+            std::string_view line_content = buffer->get_line(buffer_line_idx);
             if (buffer_col_idx < line_content.size()) {
                 return line_content[buffer_col_idx];
             }
@@ -166,6 +164,52 @@ char Viewport::get_symbol_at(int line, int col) const {
     return ' '; // Placeholder for out-of-bounds positions
 }
 
+// NOTE: this produces exactly what calling get_symbol_at on every cell would, but the index math and the line number
+// formatting only happen once per row instead of once per cell
+void Viewport::get_visible_rows(std::vector<ViewportRow> &rows) const { get_visible_rows(rows, 0, num_lines); }
+
+void Viewport::get_visible_rows(std::vector<ViewportRow> &rows, int start_row, int end_row) const {
+    rows.resize(std::max(num_lines, 0));
+    start_row = std::max(start_row, 0);
+    end_row = std::min(end_row, num_lines);
+
+    for (int line = start_row; line < end_row; ++line) {
+        auto [buffer_line_idx, first_buffer_col] = viewport_idx_to_buffer_idx(line, 0);
+
+        ViewportRow &row = rows[line];
+        row.buffer_line = buffer_line_idx;
+        row.first_buffer_col = first_buffer_col;
+        row.text.assign(num_cols, ' ');
+
+        if (buffer_line_idx < 0 or buffer_line_idx >= buffer->line_count()) {
+            continue;
+        }
+
+        // the gutter holds the line number followed by a bar and ends right before buffer column 0
+        int gutter_width = std::clamp(-first_buffer_col, 0, num_cols);
+        if (gutter_width > 0) {
+            char line_number[16];
+            auto [line_number_end, error] = std::to_chars(line_number, line_number + sizeof(line_number) - 1,
+                                                          buffer_line_idx + 1);
+            *line_number_end++ = '|';
+            int line_number_length = static_cast<int>(line_number_end - line_number);
+
+            // the gutter can be cut off on the right when the viewport is narrower than the gutter
+            int start_col = -first_buffer_col - line_number_length;
+            for (int i = std::max(0, -start_col); i < line_number_length and start_col + i < gutter_width; ++i) {
+                row.text[start_col + i] = line_number[i];
+            }
+        }
+
+        std::string_view line_content = buffer->get_line(buffer_line_idx);
+        int first_content_col = std::max(first_buffer_col, 0);
+        if (first_content_col < static_cast<int>(line_content.size()) and gutter_width < num_cols) {
+            std::string_view visible_content = line_content.substr(first_content_col, num_cols - gutter_width);
+            row.text.replace(gutter_width, visible_content.size(), visible_content);
+        }
+    }
+}
+
 TextModification Viewport::delete_character_at_active_position() {
     return buffer->delete_character(active_buffer_line_under_cursor, active_buffer_col_under_cursor);
 }
@@ -192,33 +236,39 @@ TextModification Viewport::insert_character_at(int line, int col, char character
 void Viewport::move_cursor_forward_until_end_of_word() {
     active_buffer_col_under_cursor =
         buffer->find_forward_to_end_of_word(active_buffer_line_under_cursor, active_buffer_col_under_cursor);
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 void Viewport::move_cursor_forward_until_next_right_bracket() {
     active_buffer_col_under_cursor = buffer->find_column_index_of_next_right_bracket(active_buffer_line_under_cursor,
                                                                                      active_buffer_col_under_cursor);
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 void Viewport::move_cursor_backward_until_next_left_bracket() {
     active_buffer_col_under_cursor = buffer->find_column_index_of_previous_left_bracket(active_buffer_line_under_cursor,
                                                                                         active_buffer_col_under_cursor);
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 void Viewport::move_cursor_forward_by_word() {
     active_buffer_col_under_cursor =
         buffer->find_forward_by_word_index(active_buffer_line_under_cursor, active_buffer_col_under_cursor);
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 
 void Viewport::move_cursor_backward_until_start_of_word() {
     active_buffer_col_under_cursor =
         buffer->find_backward_to_start_of_word(active_buffer_line_under_cursor, active_buffer_col_under_cursor);
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 
 void Viewport::move_cursor_backward_by_word() {
     active_buffer_col_under_cursor =
         buffer->find_backward_by_word_index(active_buffer_line_under_cursor, active_buffer_col_under_cursor);
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 
@@ -251,6 +301,7 @@ void Viewport::move_cursor_to_start_of_line() {
         active_buffer_col_under_cursor = 0; // Move the cursor to the start of the line
     }
 
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 
@@ -280,10 +331,11 @@ void Viewport::move_cursor_to_end_of_line() {
     int line_index = active_buffer_line_under_cursor;
 
     if (line_index < buffer->line_count()) {
-        const std::string &line = buffer->get_line(line_index);
+        std::string_view line = buffer->get_line(line_index);
         active_buffer_col_under_cursor = line.size(); // Move the cursor to the end of the line
     }
 
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 
@@ -291,10 +343,11 @@ void Viewport::move_cursor_to_middle_of_line() {
     int line_index = active_buffer_line_under_cursor;
 
     if (line_index < buffer->line_count()) {
-        const std::string &line = buffer->get_line(line_index);
+        std::string_view line = buffer->get_line(line_index);
         active_buffer_col_under_cursor = line.size() / 2; // Move the cursor to the middle of the line
     }
 
+    keep_cursor_in_view();
     moved_signal.toggle_state();
 }
 
@@ -332,7 +385,15 @@ TextModification Viewport::insert_string_at_cursor(const std::string &str) {
     auto tm = buffer->insert_string(active_buffer_line_under_cursor, active_buffer_col_under_cursor, str);
 
     if (tm != EMPTY_TEXT_DIFF) {
-        scroll(0, str.size());
+        // the cursor ends up right behind the inserted text, which is further down when the text spans lines
+        size_t last_newline = str.rfind('\n');
+        if (last_newline == std::string::npos) {
+            scroll(0, str.size());
+        } else {
+            int num_newlines = static_cast<int>(std::count(str.begin(), str.end(), '\n'));
+            set_active_buffer_line_col_under_cursor(active_buffer_line_under_cursor + num_newlines,
+                                                    static_cast<int>(str.size() - last_newline - 1));
+        }
     }
 
     return tm;
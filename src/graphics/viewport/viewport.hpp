@@ -3,10 +3,23 @@
 
 #include "../../utility/text_buffer/text_buffer.hpp"
 #include "../../utility/hierarchical_history/hierarchical_history.hpp"
+#include "../damage_tracker/damage_tracker.hpp"
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
+// one row of the screen as it should be drawn, this is what get_symbol_at would return for every column of the row
+struct ViewportRow {
+    // may be outside of the buffer, in which case the row is blank
+    int buffer_line;
+    // the buffer column that shows up in the first column of the row, it is negative while the line number gutter is
+    // visible, in that case the first -first_buffer_col characters are the gutter
+    int first_buffer_col;
+    // always exactly num_cols characters long
+    std::string text;
+};
+
 class Viewport {
   public:
     /**
@@ -36,6 +49,11 @@ class Viewport {
     void scroll_right();
 
     char get_symbol_at(int line, int col) const;
+    // lays out every visible row in one pass, the rows are written into the passed in vector so that its strings can
+    // be reused from frame to frame instead of being reallocated
+    void get_visible_rows(std::vector<ViewportRow> &rows) const;
+    // same as above but only lays out the rows in [start_row, end_row), the others are left as they were
+    void get_visible_rows(std::vector<ViewportRow> &rows, int start_row, int end_row) const;
     void move_cursor_forward_until_end_of_word();
     void move_cursor_forward_until_next_right_bracket();
     void move_cursor_backward_until_next_left_bracket();
@@ -65,12 +83,11 @@ class Viewport {
     void set_active_buffer_col_under_cursor(int col, bool store_pos_to_history = true);
 
     /**
-     * @brief Updates the viewport and checks if any cell has changed since the last tick.
+     * @brief Collects the damage since the last frame, the edits made to the buffer and whether the view moved.
+     * @return The rows that have to be redrawn, once they are call damage_tracker.clear().
      */
-    void tick();
-    void save_previous_viewport_screen();
-    std::vector<std::pair<int, int>> get_changed_cells_since_last_tick() const;
-    bool has_cell_changed(int line, int col) const;
+    std::vector<RowSpan> get_dirty_row_spans();
+    DamageTracker damage_tracker;
 
     std::shared_ptr<LineTextBuffer> buffer;
     TemporalBinarySignal moved_signal;
@@ -84,13 +101,22 @@ class Viewport {
     int half_num_lines;
     int half_num_cols;
 
-    std::pair<int, int> viewport_idx_to_centered_buffer_idx(int line, int col) const;
+    // the buffer position shown in the top left of the screen, the column is negative while the line number gutter is
+    // visible. The view doesn't follow the cursor around, it stays put while the cursor is in the middle half of the
+    // screen and only once the cursor leaves that does it jump so that the cursor is back in the center. Keeping it
+    // still is what lets a key press redraw only the rows it changed instead of every row
+    int first_visible_buffer_line;
+    int first_visible_buffer_col;
+    void center_view_on_cursor();
+    // recenters when the cursor left the middle half of the screen, every cursor move goes through this
+    void keep_cursor_in_view();
+    // the row and column of the screen that the cursor is on
+    std::pair<int, int> get_cursor_viewport_idx() const;
+
+    std::pair<int, int> viewport_idx_to_buffer_idx(int line, int col) const;
 
     // this is pretty much constant unless you change the dimensions of your viewport
     // it is only for placing the center of the screen where the cursor is
-
-  private:
-    std::vector<std::vector<char>> previous_viewport_screen; ///< Stores the previous state of the viewport.
 };
 
 #endif // VIEWPORT_HPP
@@ -30,13 +30,22 @@
 #include "utility/lsp_client/lsp_client.hpp"
 #include "utility/resource_path/resource_path.hpp"
 #include "utility/text_diff/text_diff.hpp"
+#include "utility/frame_scheduler/frame_scheduler.hpp"
+#include "utility/project_file_index/project_file_index.hpp"
+#include "utility/allocation_tracker/allocation_tracker.hpp"
+#include "utility/perf_probes/perf_probes.hpp"
+#include "utility/ring_logger/ring_logger.hpp"
+#include "utility/trace_recorder/trace_recorder.hpp"
 
 #include <cstdio>
 #include <cstdlib>
 
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <regex>
+#include <optional>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <stdexcept>
@@ -113,6 +122,7 @@ bool starts_with_any_prefix(const std::string &str, const std::vector<std::strin
 }
 
 void go_to_definition(JSON lsp_response, Viewport &viewport, LSPClient &lsp_client) {
+    ScopedTraceSpan span("lsp go to definition", "lsp");
     try {
         if (!lsp_response.contains("result") || lsp_response["result"].empty()) {
             std::cerr << "LSP go_to_definition: No result found in response." << std::endl;
@@ -167,7 +177,7 @@ void go_to_definition_dummy() {
 // code to make sure the cursor stays within the lines
 void snap_to_end_of_line_while_navigating(Viewport &viewport, int &saved, int &saved_last_col, int &saved_last_line) {
 
-    const std::string &line = viewport.buffer->get_line(viewport.active_buffer_line_under_cursor);
+    std::string_view line = viewport.buffer->get_line(viewport.active_buffer_line_under_cursor);
 
     if (line.size() < saved_last_col) {
         if (saved == 0) {
@@ -207,234 +217,237 @@ bool is_integer(const std::string &str) {
 // deprecated in terminal verison
 InputKeyState create_input_key_state(InputState &input_state) {
     InputKeyState iks;
+    auto set_pressed = [&](InputKey key, bool is_pressed) {
+        iks.pressed.set(InputKeyState::bit_index(key), is_pressed);
+    };
+    // a key counts as just pressed when it wasn't down at the end of the last tick
+    auto set_just_pressed = [&](InputKey key, bool is_just_pressed) {
+        iks.pressed_at_end_of_last_tick.set(InputKeyState::bit_index(key), not is_just_pressed);
+    };
 
-    iks.input_key_to_is_pressed[InputKey::a] = input_state.is_pressed(EKey::a);
-    iks.input_key_to_is_pressed[InputKey::b] = input_state.is_pressed(EKey::b);
-    iks.input_key_to_is_pressed[InputKey::c] = input_state.is_pressed(EKey::c);
-    iks.input_key_to_is_pressed[InputKey::d] = input_state.is_pressed(EKey::d);
-    iks.input_key_to_is_pressed[InputKey::e] = input_state.is_pressed(EKey::e);
-    iks.input_key_to_is_pressed[InputKey::f] = input_state.is_pressed(EKey::f);
-    iks.input_key_to_is_pressed[InputKey::g] = input_state.is_pressed(EKey::g);
-    iks.input_key_to_is_pressed[InputKey::h] = input_state.is_pressed(EKey::h);
-    iks.input_key_to_is_pressed[InputKey::i] = input_state.is_pressed(EKey::i);
-    iks.input_key_to_is_pressed[InputKey::j] = input_state.is_pressed(EKey::j);
-    iks.input_key_to_is_pressed[InputKey::k] = input_state.is_pressed(EKey::k);
-    iks.input_key_to_is_pressed[InputKey::l] = input_state.is_pressed(EKey::l);
-    iks.input_key_to_is_pressed[InputKey::m] = input_state.is_pressed(EKey::m);
-    iks.input_key_to_is_pressed[InputKey::n] = input_state.is_pressed(EKey::n);
-    iks.input_key_to_is_pressed[InputKey::o] = input_state.is_pressed(EKey::o);
-    iks.input_key_to_is_pressed[InputKey::p] = input_state.is_pressed(EKey::p);
-    iks.input_key_to_is_pressed[InputKey::q] = input_state.is_pressed(EKey::q);
-    iks.input_key_to_is_pressed[InputKey::r] = input_state.is_pressed(EKey::r);
-    iks.input_key_to_is_pressed[InputKey::s] = input_state.is_pressed(EKey::s);
-    iks.input_key_to_is_pressed[InputKey::t] = input_state.is_pressed(EKey::t);
-    iks.input_key_to_is_pressed[InputKey::u] = input_state.is_pressed(EKey::u);
-    iks.input_key_to_is_pressed[InputKey::v] = input_state.is_pressed(EKey::v);
-    iks.input_key_to_is_pressed[InputKey::w] = input_state.is_pressed(EKey::w);
-    iks.input_key_to_is_pressed[InputKey::x] = input_state.is_pressed(EKey::x);
-    iks.input_key_to_is_pressed[InputKey::y] = input_state.is_pressed(EKey::y);
-    iks.input_key_to_is_pressed[InputKey::z] = input_state.is_pressed(EKey::z);
-
-    iks.input_key_to_is_pressed[InputKey::SPACE] = input_state.is_pressed(EKey::SPACE);
-    iks.input_key_to_is_pressed[InputKey::GRAVE_ACCENT] = input_state.is_pressed(EKey::GRAVE_ACCENT);
-    iks.input_key_to_is_pressed[InputKey::TILDE] = input_state.is_pressed(EKey::TILDE);
-
-    iks.input_key_to_is_pressed[InputKey::ONE] = input_state.is_pressed(EKey::ONE);
-    iks.input_key_to_is_pressed[InputKey::TWO] = input_state.is_pressed(EKey::TWO);
-    iks.input_key_to_is_pressed[InputKey::THREE] = input_state.is_pressed(EKey::THREE);
-    iks.input_key_to_is_pressed[InputKey::FOUR] = input_state.is_pressed(EKey::FOUR);
-    iks.input_key_to_is_pressed[InputKey::FIVE] = input_state.is_pressed(EKey::FIVE);
-    iks.input_key_to_is_pressed[InputKey::SIX] = input_state.is_pressed(EKey::SIX);
-    iks.input_key_to_is_pressed[InputKey::SEVEN] = input_state.is_pressed(EKey::SEVEN);
-    iks.input_key_to_is_pressed[InputKey::EIGHT] = input_state.is_pressed(EKey::EIGHT);
-    iks.input_key_to_is_pressed[InputKey::NINE] = input_state.is_pressed(EKey::NINE);
-    iks.input_key_to_is_pressed[InputKey::ZERO] = input_state.is_pressed(EKey::ZERO);
-    iks.input_key_to_is_pressed[InputKey::MINUS] = input_state.is_pressed(EKey::MINUS);
-    iks.input_key_to_is_pressed[InputKey::EQUAL] = input_state.is_pressed(EKey::EQUAL);
-
-    iks.input_key_to_is_pressed[InputKey::EXCLAMATION_POINT] = input_state.is_pressed(EKey::EXCLAMATION_POINT);
-    iks.input_key_to_is_pressed[InputKey::AT_SIGN] = input_state.is_pressed(EKey::AT_SIGN);
-    iks.input_key_to_is_pressed[InputKey::NUMBER_SIGN] = input_state.is_pressed(EKey::NUMBER_SIGN);
-    iks.input_key_to_is_pressed[InputKey::DOLLAR_SIGN] = input_state.is_pressed(EKey::DOLLAR_SIGN);
-    iks.input_key_to_is_pressed[InputKey::PERCENT_SIGN] = input_state.is_pressed(EKey::PERCENT_SIGN);
-    iks.input_key_to_is_pressed[InputKey::CARET] = input_state.is_pressed(EKey::CARET);
-    iks.input_key_to_is_pressed[InputKey::AMPERSAND] = input_state.is_pressed(EKey::AMPERSAND);
-    iks.input_key_to_is_pressed[InputKey::ASTERISK] = input_state.is_pressed(EKey::ASTERISK);
-    iks.input_key_to_is_pressed[InputKey::LEFT_PARENTHESIS] = input_state.is_pressed(EKey::LEFT_PARENTHESIS);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_PARENTHESIS] = input_state.is_pressed(EKey::RIGHT_PARENTHESIS);
-    iks.input_key_to_is_pressed[InputKey::UNDERSCORE] = input_state.is_pressed(EKey::UNDERSCORE);
-    iks.input_key_to_is_pressed[InputKey::PLUS] = input_state.is_pressed(EKey::PLUS);
-
-    iks.input_key_to_is_pressed[InputKey::LEFT_SQUARE_BRACKET] = input_state.is_pressed(EKey::LEFT_SQUARE_BRACKET);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_SQUARE_BRACKET] = input_state.is_pressed(EKey::RIGHT_SQUARE_BRACKET);
-    iks.input_key_to_is_pressed[InputKey::LEFT_CURLY_BRACKET] = input_state.is_pressed(EKey::LEFT_CURLY_BRACKET);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_CURLY_BRACKET] = input_state.is_pressed(EKey::RIGHT_CURLY_BRACKET);
-
-    iks.input_key_to_is_pressed[InputKey::COMMA] = input_state.is_pressed(EKey::COMMA);
-    iks.input_key_to_is_pressed[InputKey::PERIOD] = input_state.is_pressed(EKey::PERIOD);
-    iks.input_key_to_is_pressed[InputKey::LESS_THAN] = input_state.is_pressed(EKey::LESS_THAN);
-    iks.input_key_to_is_pressed[InputKey::GREATER_THAN] = input_state.is_pressed(EKey::GREATER_THAN);
-
-    iks.input_key_to_is_pressed[InputKey::CAPS_LOCK] = input_state.is_pressed(EKey::CAPS_LOCK);
-    iks.input_key_to_is_pressed[InputKey::ESCAPE] = input_state.is_pressed(EKey::ESCAPE);
-    iks.input_key_to_is_pressed[InputKey::ENTER] = input_state.is_pressed(EKey::ENTER);
-    iks.input_key_to_is_pressed[InputKey::TAB] = input_state.is_pressed(EKey::TAB);
-    iks.input_key_to_is_pressed[InputKey::BACKSPACE] = input_state.is_pressed(EKey::BACKSPACE);
-    iks.input_key_to_is_pressed[InputKey::INSERT] = input_state.is_pressed(EKey::INSERT);
-    iks.input_key_to_is_pressed[InputKey::DELETE] = input_state.is_pressed(EKey::DELETE);
-
-    iks.input_key_to_is_pressed[InputKey::RIGHT] = input_state.is_pressed(EKey::RIGHT);
-    iks.input_key_to_is_pressed[InputKey::LEFT] = input_state.is_pressed(EKey::LEFT);
-    iks.input_key_to_is_pressed[InputKey::UP] = input_state.is_pressed(EKey::UP);
-    iks.input_key_to_is_pressed[InputKey::DOWN] = input_state.is_pressed(EKey::DOWN);
-
-    iks.input_key_to_is_pressed[InputKey::SLASH] = input_state.is_pressed(EKey::SLASH);
-    iks.input_key_to_is_pressed[InputKey::QUESTION_MARK] = input_state.is_pressed(EKey::QUESTION_MARK);
-    iks.input_key_to_is_pressed[InputKey::BACKSLASH] = input_state.is_pressed(EKey::BACKSLASH);
-    iks.input_key_to_is_pressed[InputKey::PIPE] = input_state.is_pressed(EKey::PIPE);
-    iks.input_key_to_is_pressed[InputKey::COLON] = input_state.is_pressed(EKey::COLON);
-    iks.input_key_to_is_pressed[InputKey::SEMICOLON] = input_state.is_pressed(EKey::SEMICOLON);
-    iks.input_key_to_is_pressed[InputKey::SINGLE_QUOTE] = input_state.is_pressed(EKey::SINGLE_QUOTE);
-    iks.input_key_to_is_pressed[InputKey::DOUBLE_QUOTE] = input_state.is_pressed(EKey::DOUBLE_QUOTE);
-
-    iks.input_key_to_is_pressed[InputKey::LEFT_SHIFT] = input_state.is_pressed(EKey::LEFT_SHIFT);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_SHIFT] = input_state.is_pressed(EKey::RIGHT_SHIFT);
-    iks.input_key_to_is_pressed[InputKey::LEFT_CONTROL] = input_state.is_pressed(EKey::LEFT_CONTROL);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_CONTROL] = input_state.is_pressed(EKey::RIGHT_CONTROL);
-    iks.input_key_to_is_pressed[InputKey::LEFT_ALT] = input_state.is_pressed(EKey::LEFT_ALT);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_ALT] = input_state.is_pressed(EKey::RIGHT_ALT);
-    iks.input_key_to_is_pressed[InputKey::LEFT_SUPER] = input_state.is_pressed(EKey::LEFT_SUPER);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_SUPER] = input_state.is_pressed(EKey::RIGHT_SUPER);
-
-    iks.input_key_to_is_pressed[InputKey::FUNCTION_KEY] = input_state.is_pressed(EKey::FUNCTION_KEY);
-    iks.input_key_to_is_pressed[InputKey::MENU_KEY] = input_state.is_pressed(EKey::MENU_KEY);
-
-    iks.input_key_to_is_pressed[InputKey::LEFT_MOUSE_BUTTON] = input_state.is_pressed(EKey::LEFT_MOUSE_BUTTON);
-    iks.input_key_to_is_pressed[InputKey::RIGHT_MOUSE_BUTTON] = input_state.is_pressed(EKey::RIGHT_MOUSE_BUTTON);
-    iks.input_key_to_is_pressed[InputKey::MIDDLE_MOUSE_BUTTON] = input_state.is_pressed(EKey::MIDDLE_MOUSE_BUTTON);
-    iks.input_key_to_is_pressed[InputKey::SCROLL_UP] = input_state.is_pressed(EKey::SCROLL_UP);
+    set_pressed(InputKey::a, input_state.is_pressed(EKey::a));
+    set_pressed(InputKey::b, input_state.is_pressed(EKey::b));
+    set_pressed(InputKey::c, input_state.is_pressed(EKey::c));
+    set_pressed(InputKey::d, input_state.is_pressed(EKey::d));
+    set_pressed(InputKey::e, input_state.is_pressed(EKey::e));
+    set_pressed(InputKey::f, input_state.is_pressed(EKey::f));
+    set_pressed(InputKey::g, input_state.is_pressed(EKey::g));
+    set_pressed(InputKey::h, input_state.is_pressed(EKey::h));
+    set_pressed(InputKey::i, input_state.is_pressed(EKey::i));
+    set_pressed(InputKey::j, input_state.is_pressed(EKey::j));
+    set_pressed(InputKey::k, input_state.is_pressed(EKey::k));
+    set_pressed(InputKey::l, input_state.is_pressed(EKey::l));
+    set_pressed(InputKey::m, input_state.is_pressed(EKey::m));
+    set_pressed(InputKey::n, input_state.is_pressed(EKey::n));
+    set_pressed(InputKey::o, input_state.is_pressed(EKey::o));
+    set_pressed(InputKey::p, input_state.is_pressed(EKey::p));
+    set_pressed(InputKey::q, input_state.is_pressed(EKey::q));
+    set_pressed(InputKey::r, input_state.is_pressed(EKey::r));
+    set_pressed(InputKey::s, input_state.is_pressed(EKey::s));
+    set_pressed(InputKey::t, input_state.is_pressed(EKey::t));
+    set_pressed(InputKey::u, input_state.is_pressed(EKey::u));
+    set_pressed(InputKey::v, input_state.is_pressed(EKey::v));
+    set_pressed(InputKey::w, input_state.is_pressed(EKey::w));
+    set_pressed(InputKey::x, input_state.is_pressed(EKey::x));
+    set_pressed(InputKey::y, input_state.is_pressed(EKey::y));
+    set_pressed(InputKey::z, input_state.is_pressed(EKey::z));
+
+    set_pressed(InputKey::SPACE, input_state.is_pressed(EKey::SPACE));
+    set_pressed(InputKey::GRAVE_ACCENT, input_state.is_pressed(EKey::GRAVE_ACCENT));
+    set_pressed(InputKey::TILDE, input_state.is_pressed(EKey::TILDE));
+
+    set_pressed(InputKey::ONE, input_state.is_pressed(EKey::ONE));
+    set_pressed(InputKey::TWO, input_state.is_pressed(EKey::TWO));
+    set_pressed(InputKey::THREE, input_state.is_pressed(EKey::THREE));
+    set_pressed(InputKey::FOUR, input_state.is_pressed(EKey::FOUR));
+    set_pressed(InputKey::FIVE, input_state.is_pressed(EKey::FIVE));
+    set_pressed(InputKey::SIX, input_state.is_pressed(EKey::SIX));
+    set_pressed(InputKey::SEVEN, input_state.is_pressed(EKey::SEVEN));
+    set_pressed(InputKey::EIGHT, input_state.is_pressed(EKey::EIGHT));
+    set_pressed(InputKey::NINE, input_state.is_pressed(EKey::NINE));
+    set_pressed(InputKey::ZERO, input_state.is_pressed(EKey::ZERO));
+    set_pressed(InputKey::MINUS, input_state.is_pressed(EKey::MINUS));
+    set_pressed(InputKey::EQUAL, input_state.is_pressed(EKey::EQUAL));
+
+    set_pressed(InputKey::EXCLAMATION_POINT, input_state.is_pressed(EKey::EXCLAMATION_POINT));
+    set_pressed(InputKey::AT_SIGN, input_state.is_pressed(EKey::AT_SIGN));
+    set_pressed(InputKey::NUMBER_SIGN, input_state.is_pressed(EKey::NUMBER_SIGN));
+    set_pressed(InputKey::DOLLAR_SIGN, input_state.is_pressed(EKey::DOLLAR_SIGN));
+    set_pressed(InputKey::PERCENT_SIGN, input_state.is_pressed(EKey::PERCENT_SIGN));
+    set_pressed(InputKey::CARET, input_state.is_pressed(EKey::CARET));
+    set_pressed(InputKey::AMPERSAND, input_state.is_pressed(EKey::AMPERSAND));
+    set_pressed(InputKey::ASTERISK, input_state.is_pressed(EKey::ASTERISK));
+    set_pressed(InputKey::LEFT_PARENTHESIS, input_state.is_pressed(EKey::LEFT_PARENTHESIS));
+    set_pressed(InputKey::RIGHT_PARENTHESIS, input_state.is_pressed(EKey::RIGHT_PARENTHESIS));
+    set_pressed(InputKey::UNDERSCORE, input_state.is_pressed(EKey::UNDERSCORE));
+    set_pressed(InputKey::PLUS, input_state.is_pressed(EKey::PLUS));
+
+    set_pressed(InputKey::LEFT_SQUARE_BRACKET, input_state.is_pressed(EKey::LEFT_SQUARE_BRACKET));
+    set_pressed(InputKey::RIGHT_SQUARE_BRACKET, input_state.is_pressed(EKey::RIGHT_SQUARE_BRACKET));
+    set_pressed(InputKey::LEFT_CURLY_BRACKET, input_state.is_pressed(EKey::LEFT_CURLY_BRACKET));
+    set_pressed(InputKey::RIGHT_CURLY_BRACKET, input_state.is_pressed(EKey::RIGHT_CURLY_BRACKET));
+
+    set_pressed(InputKey::COMMA, input_state.is_pressed(EKey::COMMA));
+    set_pressed(InputKey::PERIOD, input_state.is_pressed(EKey::PERIOD));
+    set_pressed(InputKey::LESS_THAN, input_state.is_pressed(EKey::LESS_THAN));
+    set_pressed(InputKey::GREATER_THAN, input_state.is_pressed(EKey::GREATER_THAN));
+
+    set_pressed(InputKey::CAPS_LOCK, input_state.is_pressed(EKey::CAPS_LOCK));
+    set_pressed(InputKey::ESCAPE, input_state.is_pressed(EKey::ESCAPE));
+    set_pressed(InputKey::ENTER, input_state.is_pressed(EKey::ENTER));
+    set_pressed(InputKey::TAB, input_state.is_pressed(EKey::TAB));
+    set_pressed(InputKey::BACKSPACE, input_state.is_pressed(EKey::BACKSPACE));
+    set_pressed(InputKey::INSERT, input_state.is_pressed(EKey::INSERT));
+    set_pressed(InputKey::DELETE, input_state.is_pressed(EKey::DELETE));
+
+    set_pressed(InputKey::RIGHT, input_state.is_pressed(EKey::RIGHT));
+    set_pressed(InputKey::LEFT, input_state.is_pressed(EKey::LEFT));
+    set_pressed(InputKey::UP, input_state.is_pressed(EKey::UP));
+    set_pressed(InputKey::DOWN, input_state.is_pressed(EKey::DOWN));
+
+    set_pressed(InputKey::SLASH, input_state.is_pressed(EKey::SLASH));
+    set_pressed(InputKey::QUESTION_MARK, input_state.is_pressed(EKey::QUESTION_MARK));
+    set_pressed(InputKey::BACKSLASH, input_state.is_pressed(EKey::BACKSLASH));
+    set_pressed(InputKey::PIPE, input_state.is_pressed(EKey::PIPE));
+    set_pressed(InputKey::COLON, input_state.is_pressed(EKey::COLON));
+    set_pressed(InputKey::SEMICOLON, input_state.is_pressed(EKey::SEMICOLON));
+    set_pressed(InputKey::SINGLE_QUOTE, input_state.is_pressed(EKey::SINGLE_QUOTE));
+    set_pressed(InputKey::DOUBLE_QUOTE, input_state.is_pressed(EKey::DOUBLE_QUOTE));
+
+    set_pressed(InputKey::LEFT_SHIFT, input_state.is_pressed(EKey::LEFT_SHIFT));
+    set_pressed(InputKey::RIGHT_SHIFT, input_state.is_pressed(EKey::RIGHT_SHIFT));
+    set_pressed(InputKey::LEFT_CONTROL, input_state.is_pressed(EKey::LEFT_CONTROL));
+    set_pressed(InputKey::RIGHT_CONTROL, input_state.is_pressed(EKey::RIGHT_CONTROL));
+    set_pressed(InputKey::LEFT_ALT, input_state.is_pressed(EKey::LEFT_ALT));
+    set_pressed(InputKey::RIGHT_ALT, input_state.is_pressed(EKey::RIGHT_ALT));
+    set_pressed(InputKey::LEFT_SUPER, input_state.is_pressed(EKey::LEFT_SUPER));
+    set_pressed(InputKey::RIGHT_SUPER, input_state.is_pressed(EKey::RIGHT_SUPER));
+
+    set_pressed(InputKey::FUNCTION_KEY, input_state.is_pressed(EKey::FUNCTION_KEY));
+    set_pressed(InputKey::MENU_KEY, input_state.is_pressed(EKey::MENU_KEY));
+
+    set_pressed(InputKey::LEFT_MOUSE_BUTTON, input_state.is_pressed(EKey::LEFT_MOUSE_BUTTON));
+    set_pressed(InputKey::RIGHT_MOUSE_BUTTON, input_state.is_pressed(EKey::RIGHT_MOUSE_BUTTON));
+    set_pressed(InputKey::MIDDLE_MOUSE_BUTTON, input_state.is_pressed(EKey::MIDDLE_MOUSE_BUTTON));
+    set_pressed(InputKey::SCROLL_UP, input_state.is_pressed(EKey::SCROLL_UP));
     // NOTE: the following one is causing out of range, instead of bug fixing this, I'm just not going to because we're
     // probably not going to use scroll for a while and fix the bug later
-    // iks.input_key_to_is_pressed[InputKey::SCROLL_DOWN] = input_state.is_pressed(EKey::SCROLL_DOWN);
+    // set_pressed(InputKey::SCROLL_DOWN, input_state.is_pressed(EKey::SCROLL_DOWN));
 
     // not required
-    // iks.input_key_to_is_pressed[InputKey::DUMMY] = input_state.is_pressed(EKey::DUMMY);
-
-    iks.input_key_to_just_pressed[InputKey::a] = input_state.is_just_pressed(EKey::a);
-    iks.input_key_to_just_pressed[InputKey::b] = input_state.is_just_pressed(EKey::b);
-    iks.input_key_to_just_pressed[InputKey::c] = input_state.is_just_pressed(EKey::c);
-    iks.input_key_to_just_pressed[InputKey::d] = input_state.is_just_pressed(EKey::d);
-    iks.input_key_to_just_pressed[InputKey::e] = input_state.is_just_pressed(EKey::e);
-    iks.input_key_to_just_pressed[InputKey::f] = input_state.is_just_pressed(EKey::f);
-    iks.input_key_to_just_pressed[InputKey::g] = input_state.is_just_pressed(EKey::g);
-    iks.input_key_to_just_pressed[InputKey::h] = input_state.is_just_pressed(EKey::h);
-    iks.input_key_to_just_pressed[InputKey::i] = input_state.is_just_pressed(EKey::i);
-    iks.input_key_to_just_pressed[InputKey::j] = input_state.is_just_pressed(EKey::j);
-    iks.input_key_to_just_pressed[InputKey::k] = input_state.is_just_pressed(EKey::k);
-    iks.input_key_to_just_pressed[InputKey::l] = input_state.is_just_pressed(EKey::l);
-    iks.input_key_to_just_pressed[InputKey::m] = input_state.is_just_pressed(EKey::m);
-    iks.input_key_to_just_pressed[InputKey::n] = input_state.is_just_pressed(EKey::n);
-    iks.input_key_to_just_pressed[InputKey::o] = input_state.is_just_pressed(EKey::o);
-    iks.input_key_to_just_pressed[InputKey::p] = input_state.is_just_pressed(EKey::p);
-    iks.input_key_to_just_pressed[InputKey::q] = input_state.is_just_pressed(EKey::q);
-    iks.input_key_to_just_pressed[InputKey::r] = input_state.is_just_pressed(EKey::r);
-    iks.input_key_to_just_pressed[InputKey::s] = input_state.is_just_pressed(EKey::s);
-    iks.input_key_to_just_pressed[InputKey::t] = input_state.is_just_pressed(EKey::t);
-    iks.input_key_to_just_pressed[InputKey::u] = input_state.is_just_pressed(EKey::u);
-    iks.input_key_to_just_pressed[InputKey::v] = input_state.is_just_pressed(EKey::v);
-    iks.input_key_to_just_pressed[InputKey::w] = input_state.is_just_pressed(EKey::w);
-    iks.input_key_to_just_pressed[InputKey::x] = input_state.is_just_pressed(EKey::x);
-    iks.input_key_to_just_pressed[InputKey::y] = input_state.is_just_pressed(EKey::y);
-    iks.input_key_to_just_pressed[InputKey::z] = input_state.is_just_pressed(EKey::z);
-
-    iks.input_key_to_just_pressed[InputKey::SPACE] = input_state.is_just_pressed(EKey::SPACE);
-    iks.input_key_to_just_pressed[InputKey::GRAVE_ACCENT] = input_state.is_just_pressed(EKey::GRAVE_ACCENT);
-    iks.input_key_to_just_pressed[InputKey::TILDE] = input_state.is_just_pressed(EKey::TILDE);
-
-    iks.input_key_to_just_pressed[InputKey::ONE] = input_state.is_just_pressed(EKey::ONE);
-    iks.input_key_to_just_pressed[InputKey::TWO] = input_state.is_just_pressed(EKey::TWO);
-    iks.input_key_to_just_pressed[InputKey::THREE] = input_state.is_just_pressed(EKey::THREE);
-    iks.input_key_to_just_pressed[InputKey::FOUR] = input_state.is_just_pressed(EKey::FOUR);
-    iks.input_key_to_just_pressed[InputKey::FIVE] = input_state.is_just_pressed(EKey::FIVE);
-    iks.input_key_to_just_pressed[InputKey::SIX] = input_state.is_just_pressed(EKey::SIX);
-    iks.input_key_to_just_pressed[InputKey::SEVEN] = input_state.is_just_pressed(EKey::SEVEN);
-    iks.input_key_to_just_pressed[InputKey::EIGHT] = input_state.is_just_pressed(EKey::EIGHT);
-    iks.input_key_to_just_pressed[InputKey::NINE] = input_state.is_just_pressed(EKey::NINE);
-    iks.input_key_to_just_pressed[InputKey::ZERO] = input_state.is_just_pressed(EKey::ZERO);
-    iks.input_key_to_just_pressed[InputKey::MINUS] = input_state.is_just_pressed(EKey::MINUS);
-    iks.input_key_to_just_pressed[InputKey::EQUAL] = input_state.is_just_pressed(EKey::EQUAL);
-
-    iks.input_key_to_just_pressed[InputKey::EXCLAMATION_POINT] = input_state.is_just_pressed(EKey::EXCLAMATION_POINT);
-    iks.input_key_to_just_pressed[InputKey::AT_SIGN] = input_state.is_just_pressed(EKey::AT_SIGN);
-    iks.input_key_to_just_pressed[InputKey::NUMBER_SIGN] = input_state.is_just_pressed(EKey::NUMBER_SIGN);
-    iks.input_key_to_just_pressed[InputKey::DOLLAR_SIGN] = input_state.is_just_pressed(EKey::DOLLAR_SIGN);
-    iks.input_key_to_just_pressed[InputKey::PERCENT_SIGN] = input_state.is_just_pressed(EKey::PERCENT_SIGN);
-    iks.input_key_to_just_pressed[InputKey::CARET] = input_state.is_just_pressed(EKey::CARET);
-    iks.input_key_to_just_pressed[InputKey::AMPERSAND] = input_state.is_just_pressed(EKey::AMPERSAND);
-    iks.input_key_to_just_pressed[InputKey::ASTERISK] = input_state.is_just_pressed(EKey::ASTERISK);
-    iks.input_key_to_just_pressed[InputKey::LEFT_PARENTHESIS] = input_state.is_just_pressed(EKey::LEFT_PARENTHESIS);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_PARENTHESIS] = input_state.is_just_pressed(EKey::RIGHT_PARENTHESIS);
-    iks.input_key_to_just_pressed[InputKey::UNDERSCORE] = input_state.is_just_pressed(EKey::UNDERSCORE);
-    iks.input_key_to_just_pressed[InputKey::PLUS] = input_state.is_just_pressed(EKey::PLUS);
-
-    iks.input_key_to_just_pressed[InputKey::LEFT_SQUARE_BRACKET] =
-        input_state.is_just_pressed(EKey::LEFT_SQUARE_BRACKET);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_SQUARE_BRACKET] =
-        input_state.is_just_pressed(EKey::RIGHT_SQUARE_BRACKET);
-    iks.input_key_to_just_pressed[InputKey::LEFT_CURLY_BRACKET] = input_state.is_just_pressed(EKey::LEFT_CURLY_BRACKET);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_CURLY_BRACKET] =
-        input_state.is_just_pressed(EKey::RIGHT_CURLY_BRACKET);
-
-    iks.input_key_to_just_pressed[InputKey::COMMA] = input_state.is_just_pressed(EKey::COMMA);
-    iks.input_key_to_just_pressed[InputKey::PERIOD] = input_state.is_just_pressed(EKey::PERIOD);
-    iks.input_key_to_just_pressed[InputKey::LESS_THAN] = input_state.is_just_pressed(EKey::LESS_THAN);
-    iks.input_key_to_just_pressed[InputKey::GREATER_THAN] = input_state.is_just_pressed(EKey::GREATER_THAN);
-
-    iks.input_key_to_just_pressed[InputKey::CAPS_LOCK] = input_state.is_just_pressed(EKey::CAPS_LOCK);
-    iks.input_key_to_just_pressed[InputKey::ESCAPE] = input_state.is_just_pressed(EKey::ESCAPE);
-    iks.input_key_to_just_pressed[InputKey::ENTER] = input_state.is_just_pressed(EKey::ENTER);
-    iks.input_key_to_just_pressed[InputKey::TAB] = input_state.is_just_pressed(EKey::TAB);
-    iks.input_key_to_just_pressed[InputKey::BACKSPACE] = input_state.is_just_pressed(EKey::BACKSPACE);
-    iks.input_key_to_just_pressed[InputKey::INSERT] = input_state.is_just_pressed(EKey::INSERT);
-    iks.input_key_to_just_pressed[InputKey::DELETE] = input_state.is_just_pressed(EKey::DELETE);
-
-    iks.input_key_to_just_pressed[InputKey::RIGHT] = input_state.is_just_pressed(EKey::RIGHT);
-    iks.input_key_to_just_pressed[InputKey::LEFT] = input_state.is_just_pressed(EKey::LEFT);
-    iks.input_key_to_just_pressed[InputKey::UP] = input_state.is_just_pressed(EKey::UP);
-    iks.input_key_to_just_pressed[InputKey::DOWN] = input_state.is_just_pressed(EKey::DOWN);
-
-    iks.input_key_to_just_pressed[InputKey::SLASH] = input_state.is_just_pressed(EKey::SLASH);
-    iks.input_key_to_just_pressed[InputKey::QUESTION_MARK] = input_state.is_just_pressed(EKey::QUESTION_MARK);
-    iks.input_key_to_just_pressed[InputKey::BACKSLASH] = input_state.is_just_pressed(EKey::BACKSLASH);
-    iks.input_key_to_just_pressed[InputKey::PIPE] = input_state.is_just_pressed(EKey::PIPE);
-    iks.input_key_to_just_pressed[InputKey::COLON] = input_state.is_just_pressed(EKey::COLON);
-    iks.input_key_to_just_pressed[InputKey::SEMICOLON] = input_state.is_just_pressed(EKey::SEMICOLON);
-    iks.input_key_to_just_pressed[InputKey::SINGLE_QUOTE] = input_state.is_just_pressed(EKey::SINGLE_QUOTE);
-    iks.input_key_to_just_pressed[InputKey::DOUBLE_QUOTE] = input_state.is_just_pressed(EKey::DOUBLE_QUOTE);
-
-    iks.input_key_to_just_pressed[InputKey::LEFT_SHIFT] = input_state.is_just_pressed(EKey::LEFT_SHIFT);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_SHIFT] = input_state.is_just_pressed(EKey::RIGHT_SHIFT);
-    iks.input_key_to_just_pressed[InputKey::LEFT_CONTROL] = input_state.is_just_pressed(EKey::LEFT_CONTROL);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_CONTROL] = input_state.is_just_pressed(EKey::RIGHT_CONTROL);
-    iks.input_key_to_just_pressed[InputKey::LEFT_ALT] = input_state.is_just_pressed(EKey::LEFT_ALT);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_ALT] = input_state.is_just_pressed(EKey::RIGHT_ALT);
-    iks.input_key_to_just_pressed[InputKey::LEFT_SUPER] = input_state.is_just_pressed(EKey::LEFT_SUPER);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_SUPER] = input_state.is_just_pressed(EKey::RIGHT_SUPER);
-
-    iks.input_key_to_just_pressed[InputKey::FUNCTION_KEY] = input_state.is_just_pressed(EKey::FUNCTION_KEY);
-    iks.input_key_to_just_pressed[InputKey::MENU_KEY] = input_state.is_just_pressed(EKey::MENU_KEY);
-
-    iks.input_key_to_just_pressed[InputKey::LEFT_MOUSE_BUTTON] = input_state.is_just_pressed(EKey::LEFT_MOUSE_BUTTON);
-    iks.input_key_to_just_pressed[InputKey::RIGHT_MOUSE_BUTTON] = input_state.is_just_pressed(EKey::RIGHT_MOUSE_BUTTON);
-    iks.input_key_to_just_pressed[InputKey::MIDDLE_MOUSE_BUTTON] =
-        input_state.is_just_pressed(EKey::MIDDLE_MOUSE_BUTTON);
-    iks.input_key_to_just_pressed[InputKey::SCROLL_UP] = input_state.is_just_pressed(EKey::SCROLL_UP);
+    // set_pressed(InputKey::DUMMY, input_state.is_pressed(EKey::DUMMY));
+
+    set_just_pressed(InputKey::a, input_state.is_just_pressed(EKey::a));
+    set_just_pressed(InputKey::b, input_state.is_just_pressed(EKey::b));
+    set_just_pressed(InputKey::c, input_state.is_just_pressed(EKey::c));
+    set_just_pressed(InputKey::d, input_state.is_just_pressed(EKey::d));
+    set_just_pressed(InputKey::e, input_state.is_just_pressed(EKey::e));
+    set_just_pressed(InputKey::f, input_state.is_just_pressed(EKey::f));
+    set_just_pressed(InputKey::g, input_state.is_just_pressed(EKey::g));
+    set_just_pressed(InputKey::h, input_state.is_just_pressed(EKey::h));
+    set_just_pressed(InputKey::i, input_state.is_just_pressed(EKey::i));
+    set_just_pressed(InputKey::j, input_state.is_just_pressed(EKey::j));
+    set_just_pressed(InputKey::k, input_state.is_just_pressed(EKey::k));
+    set_just_pressed(InputKey::l, input_state.is_just_pressed(EKey::l));
+    set_just_pressed(InputKey::m, input_state.is_just_pressed(EKey::m));
+    set_just_pressed(InputKey::n, input_state.is_just_pressed(EKey::n));
+    set_just_pressed(InputKey::o, input_state.is_just_pressed(EKey::o));
+    set_just_pressed(InputKey::p, input_state.is_just_pressed(EKey::p));
+    set_just_pressed(InputKey::q, input_state.is_just_pressed(EKey::q));
+    set_just_pressed(InputKey::r, input_state.is_just_pressed(EKey::r));
+    set_just_pressed(InputKey::s, input_state.is_just_pressed(EKey::s));
+    set_just_pressed(InputKey::t, input_state.is_just_pressed(EKey::t));
+    set_just_pressed(InputKey::u, input_state.is_just_pressed(EKey::u));
+    set_just_pressed(InputKey::v, input_state.is_just_pressed(EKey::v));
+    set_just_pressed(InputKey::w, input_state.is_just_pressed(EKey::w));
+    set_just_pressed(InputKey::x, input_state.is_just_pressed(EKey::x));
+    set_just_pressed(InputKey::y, input_state.is_just_pressed(EKey::y));
+    set_just_pressed(InputKey::z, input_state.is_just_pressed(EKey::z));
+
+    set_just_pressed(InputKey::SPACE, input_state.is_just_pressed(EKey::SPACE));
+    set_just_pressed(InputKey::GRAVE_ACCENT, input_state.is_just_pressed(EKey::GRAVE_ACCENT));
+    set_just_pressed(InputKey::TILDE, input_state.is_just_pressed(EKey::TILDE));
+
+    set_just_pressed(InputKey::ONE, input_state.is_just_pressed(EKey::ONE));
+    set_just_pressed(InputKey::TWO, input_state.is_just_pressed(EKey::TWO));
+    set_just_pressed(InputKey::THREE, input_state.is_just_pressed(EKey::THREE));
+    set_just_pressed(InputKey::FOUR, input_state.is_just_pressed(EKey::FOUR));
+    set_just_pressed(InputKey::FIVE, input_state.is_just_pressed(EKey::FIVE));
+    set_just_pressed(InputKey::SIX, input_state.is_just_pressed(EKey::SIX));
+    set_just_pressed(InputKey::SEVEN, input_state.is_just_pressed(EKey::SEVEN));
+    set_just_pressed(InputKey::EIGHT, input_state.is_just_pressed(EKey::EIGHT));
+    set_just_pressed(InputKey::NINE, input_state.is_just_pressed(EKey::NINE));
+    set_just_pressed(InputKey::ZERO, input_state.is_just_pressed(EKey::ZERO));
+    set_just_pressed(InputKey::MINUS, input_state.is_just_pressed(EKey::MINUS));
+    set_just_pressed(InputKey::EQUAL, input_state.is_just_pressed(EKey::EQUAL));
+
+    set_just_pressed(InputKey::EXCLAMATION_POINT, input_state.is_just_pressed(EKey::EXCLAMATION_POINT));
+    set_just_pressed(InputKey::AT_SIGN, input_state.is_just_pressed(EKey::AT_SIGN));
+    set_just_pressed(InputKey::NUMBER_SIGN, input_state.is_just_pressed(EKey::NUMBER_SIGN));
+    set_just_pressed(InputKey::DOLLAR_SIGN, input_state.is_just_pressed(EKey::DOLLAR_SIGN));
+    set_just_pressed(InputKey::PERCENT_SIGN, input_state.is_just_pressed(EKey::PERCENT_SIGN));
+    set_just_pressed(InputKey::CARET, input_state.is_just_pressed(EKey::CARET));
+    set_just_pressed(InputKey::AMPERSAND, input_state.is_just_pressed(EKey::AMPERSAND));
+    set_just_pressed(InputKey::ASTERISK, input_state.is_just_pressed(EKey::ASTERISK));
+    set_just_pressed(InputKey::LEFT_PARENTHESIS, input_state.is_just_pressed(EKey::LEFT_PARENTHESIS));
+    set_just_pressed(InputKey::RIGHT_PARENTHESIS, input_state.is_just_pressed(EKey::RIGHT_PARENTHESIS));
+    set_just_pressed(InputKey::UNDERSCORE, input_state.is_just_pressed(EKey::UNDERSCORE));
+    set_just_pressed(InputKey::PLUS, input_state.is_just_pressed(EKey::PLUS));
+
+    set_just_pressed(InputKey::LEFT_SQUARE_BRACKET, input_state.is_just_pressed(EKey::LEFT_SQUARE_BRACKET));
+    set_just_pressed(InputKey::RIGHT_SQUARE_BRACKET, input_state.is_just_pressed(EKey::RIGHT_SQUARE_BRACKET));
+    set_just_pressed(InputKey::LEFT_CURLY_BRACKET, input_state.is_just_pressed(EKey::LEFT_CURLY_BRACKET));
+    set_just_pressed(InputKey::RIGHT_CURLY_BRACKET, input_state.is_just_pressed(EKey::RIGHT_CURLY_BRACKET));
+
+    set_just_pressed(InputKey::COMMA, input_state.is_just_pressed(EKey::COMMA));
+    set_just_pressed(InputKey::PERIOD, input_state.is_just_pressed(EKey::PERIOD));
+    set_just_pressed(InputKey::LESS_THAN, input_state.is_just_pressed(EKey::LESS_THAN));
+    set_just_pressed(InputKey::GREATER_THAN, input_state.is_just_pressed(EKey::GREATER_THAN));
+
+    set_just_pressed(InputKey::CAPS_LOCK, input_state.is_just_pressed(EKey::CAPS_LOCK));
+    set_just_pressed(InputKey::ESCAPE, input_state.is_just_pressed(EKey::ESCAPE));
+    set_just_pressed(InputKey::ENTER, input_state.is_just_pressed(EKey::ENTER));
+    set_just_pressed(InputKey::TAB, input_state.is_just_pressed(EKey::TAB));
+    set_just_pressed(InputKey::BACKSPACE, input_state.is_just_pressed(EKey::BACKSPACE));
+    set_just_pressed(InputKey::INSERT, input_state.is_just_pressed(EKey::INSERT));
+    set_just_pressed(InputKey::DELETE, input_state.is_just_pressed(EKey::DELETE));
+
+    set_just_pressed(InputKey::RIGHT, input_state.is_just_pressed(EKey::RIGHT));
+    set_just_pressed(InputKey::LEFT, input_state.is_just_pressed(EKey::LEFT));
+    set_just_pressed(InputKey::UP, input_state.is_just_pressed(EKey::UP));
+    set_just_pressed(InputKey::DOWN, input_state.is_just_pressed(EKey::DOWN));
+
+    set_just_pressed(InputKey::SLASH, input_state.is_just_pressed(EKey::SLASH));
+    set_just_pressed(InputKey::QUESTION_MARK, input_state.is_just_pressed(EKey::QUESTION_MARK));
+    set_just_pressed(InputKey::BACKSLASH, input_state.is_just_pressed(EKey::BACKSLASH));
+    set_just_pressed(InputKey::PIPE, input_state.is_just_pressed(EKey::PIPE));
+    set_just_pressed(InputKey::COLON, input_state.is_just_pressed(EKey::COLON));
+    set_just_pressed(InputKey::SEMICOLON, input_state.is_just_pressed(EKey::SEMICOLON));
+    set_just_pressed(InputKey::SINGLE_QUOTE, input_state.is_just_pressed(EKey::SINGLE_QUOTE));
+    set_just_pressed(InputKey::DOUBLE_QUOTE, input_state.is_just_pressed(EKey::DOUBLE_QUOTE));
+
+    set_just_pressed(InputKey::LEFT_SHIFT, input_state.is_just_pressed(EKey::LEFT_SHIFT));
+    set_just_pressed(InputKey::RIGHT_SHIFT, input_state.is_just_pressed(EKey::RIGHT_SHIFT));
+    set_just_pressed(InputKey::LEFT_CONTROL, input_state.is_just_pressed(EKey::LEFT_CONTROL));
+    set_just_pressed(InputKey::RIGHT_CONTROL, input_state.is_just_pressed(EKey::RIGHT_CONTROL));
+    set_just_pressed(InputKey::LEFT_ALT, input_state.is_just_pressed(EKey::LEFT_ALT));
+    set_just_pressed(InputKey::RIGHT_ALT, input_state.is_just_pressed(EKey::RIGHT_ALT));
+    set_just_pressed(InputKey::LEFT_SUPER, input_state.is_just_pressed(EKey::LEFT_SUPER));
+    set_just_pressed(InputKey::RIGHT_SUPER, input_state.is_just_pressed(EKey::RIGHT_SUPER));
+
+    set_just_pressed(InputKey::FUNCTION_KEY, input_state.is_just_pressed(EKey::FUNCTION_KEY));
+    set_just_pressed(InputKey::MENU_KEY, input_state.is_just_pressed(EKey::MENU_KEY));
+
+    set_just_pressed(InputKey::LEFT_MOUSE_BUTTON, input_state.is_just_pressed(EKey::LEFT_MOUSE_BUTTON));
+    set_just_pressed(InputKey::RIGHT_MOUSE_BUTTON, input_state.is_just_pressed(EKey::RIGHT_MOUSE_BUTTON));
+    set_just_pressed(InputKey::MIDDLE_MOUSE_BUTTON, input_state.is_just_pressed(EKey::MIDDLE_MOUSE_BUTTON));
+    set_just_pressed(InputKey::SCROLL_UP, input_state.is_just_pressed(EKey::SCROLL_UP));
     // NOTE: the following one is causing out of range, instead of bug fixing this, I'm just not going to because we're
     // probably not going to use scroll for a while and fix the bug later
-    // iks.input_key_to_is_pressed[InputKey::SCROLL_DOWN] = input_state.is_pressed(EKey::SCROLL_DOWN);
+    // set_pressed(InputKey::SCROLL_DOWN, input_state.is_pressed(EKey::SCROLL_DOWN));
 
     // not required
-    // iks.input_key_to_is_pressed[InputKey::DUMMY] = input_state.is_pressed(EKey::DUMMY);
+    // set_pressed(InputKey::DUMMY, input_state.is_pressed(EKey::DUMMY));
 
     return iks;
 }
@@ -702,35 +715,73 @@ const std::unordered_map<Event, std::vector<InputKey>, EventHasher> &get_event_t
     return event_to_input_keys;
 }
 
-class FileLogger {
-  public:
-    FileLogger(const std::string &filename) {
-        // Open and truncate the file on start
-        file_.open(filename, std::ios::out | std::ios::trunc);
-    }
+// splits a row into runs of cells that share a style, so a row turns into a handful of text elements instead of one
+// draw call per cell. The selection covers [selection_start, selection_end) and a cursor_col of -1 means no cursor
+Element render_viewport_row(const std::string &row_text, int selection_start, int selection_end, int cursor_col) {
+    int row_length = static_cast<int>(row_text.size());
 
-    ~FileLogger() {
-        if (file_.is_open()) {
-            file_.close();
+    std::vector<int> style_boundaries = {0, row_length};
+    for (int boundary : {selection_start, selection_end, cursor_col, cursor_col + 1}) {
+        if (0 < boundary and boundary < row_length) {
+            style_boundaries.push_back(boundary);
         }
     }
-
-    template <typename T> FileLogger &operator<<(const T &value) {
-        file_ << value;
-        file_.flush(); // Optional: flush immediately
-        return *this;
+    std::sort(style_boundaries.begin(), style_boundaries.end());
+    style_boundaries.erase(std::unique(style_boundaries.begin(), style_boundaries.end()), style_boundaries.end());
+
+    Elements runs;
+    for (size_t i = 0; i + 1 < style_boundaries.size(); ++i) {
+        int run_start = style_boundaries[i];
+        int run_end = style_boundaries[i + 1];
+        auto run = text(row_text.substr(run_start, run_end - run_start));
+
+        if (run_start == cursor_col) {
+            run |= bgcolor(Color::White);
+            run |= color(Color::Black);
+        } else if (selection_start <= run_start and run_start < selection_end) {
+            run |= bgcolor(Color::Grey63);
+        } else {
+            run |= color(Color::White);
+        }
+        runs.push_back(std::move(run));
     }
+    return hbox(std::move(runs));
+}
 
-    // Support std::endl and other manipulators
-    FileLogger &operator<<(std::ostream &(*manip)(std::ostream &)) {
-        file_ << manip;
-        file_.flush();
-        return *this;
+// bytes in the biggest unit that keeps the number at or above one, like 12.3 MB
+std::string format_byte_count(double num_bytes) {
+    const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+    int unit = 0;
+    while (num_bytes >= 1024 and unit < 4) {
+        num_bytes /= 1024;
+        unit++;
     }
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << num_bytes << " " << units[unit];
+    return stream.str();
+}
 
-  private:
-    std::ofstream file_;
-};
+// how far along the save of the buffer is, and how fast it went once it's done
+std::string get_save_status_string(const SaveJob &save_job) {
+    switch (save_job.get_state()) {
+    case SaveJob::State::IDLE:
+        return "";
+    case SaveJob::State::RUNNING: {
+        size_t num_bytes_total = std::max<size_t>(save_job.get_num_bytes_total(), 1);
+        size_t percentage = save_job.get_num_bytes_written() * 100 / num_bytes_total;
+        return " saving " + std::to_string(percentage) + "% (" + format_byte_count(save_job.get_bytes_per_second()) +
+               "/s) ";
+    }
+    case SaveJob::State::SUCCEEDED: {
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(save_job.get_elapsed_time()).count();
+        return " saved " + format_byte_count(save_job.get_num_bytes_total()) + " in " + std::to_string(elapsed_ms) +
+               "ms (" + format_byte_count(save_job.get_bytes_per_second()) + "/s) ";
+    }
+    case SaveJob::State::FAILED:
+        return " save failed ";
+    }
+    return "";
+}
 
 Element generate_status_bar(ModalEditor &modal_editor, const std::string &filename) {
     // Status Bar
@@ -751,8 +802,9 @@ Element generate_status_bar(ModalEditor &modal_editor, const std::string &filena
         break;
     }
 
-    // std::string save_str = show_saved_msg ? "✅ Saved" : "";
-    std::string save_str = "save placeholder";
+    const SaveJob &save_job = modal_editor.viewport.buffer->get_save_job();
+    std::string save_str = get_save_status_string(save_job);
+    Color save_color = save_job.get_state() == SaveJob::State::FAILED ? Color::Red : Color::Green;
     // Clock Stuff v
     auto now = std::chrono::system_clock::now();
     std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
@@ -779,10 +831,20 @@ Element generate_status_bar(ModalEditor &modal_editor, const std::string &filena
     // int percentage_horizontal_scroll = (modal_editor.viewport.active_buffer_col_under_cursor + 1) * 100 /
     // (lines[cursor_row].size() + 1);
     int percentage_horizontal_scroll = 0;
+
+    // the match count keeps going up while the search is still going through the file
+    std::string search_str;
+    const SearchJob &file_search_job = modal_editor.file_search_job;
+    if (file_search_job.is_active()) {
+        search_str = " /" + file_search_job.get_query() + " " + std::to_string(file_search_job.get_num_matches()) +
+                     (file_search_job.is_complete() ? "" : "+") + " matches ";
+    }
+
     auto status = hbox({
         text(mode_str) | color(Color::Cyan),
         text("  "),
-        text(save_str) | color(Color::Green),
+        text(save_str) | color(save_color),
+        text(search_str) | color(Color::Yellow),
         text(" "),
         text(std::to_string(percentage_vertical_scroll)) | color(Color::Cyan),
         text("% "),
@@ -806,6 +868,94 @@ Element generate_status_bar(ModalEditor &modal_editor, const std::string &filena
     return status;
 }
 
+// like 12.3us or 4.5ms
+std::string format_duration(std::chrono::nanoseconds duration) {
+    double microseconds = static_cast<double>(duration.count()) / 1000.0;
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(1);
+    if (microseconds < 1000.0) {
+        stream << microseconds << "us";
+    } else {
+        stream << microseconds / 1000.0 << "ms";
+    }
+    return stream.str();
+}
+
+// p50, p99 and max of every timed stage (and the allocation counts in builds that track them), shown in the corner
+// of the viewport after :perf
+Element generate_perf_overlay() {
+    const PerfProbes &perf_probes = global_perf_probes();
+
+    Elements stage_names = {text("stage") | bold};
+    Elements p50s = {text("p50") | bold};
+    Elements p99s = {text("p99") | bold};
+    Elements maxes = {text("max") | bold};
+    Elements counts = {text("n") | bold};
+    for (size_t i = 0; i < PerfProbes::NUM_STAGES; ++i) {
+        auto stage = static_cast<PerfStage>(i);
+        const LatencyHistogram &histogram = perf_probes.get_histogram(stage);
+        stage_names.push_back(text(perf_stage_to_string(stage)));
+        p50s.push_back(text(format_duration(histogram.get_percentile(50))) | color(Color::Green));
+        p99s.push_back(text(format_duration(histogram.get_percentile(99))) | color(Color::Yellow));
+        maxes.push_back(text(format_duration(histogram.get_max())) | color(Color::Red));
+        counts.push_back(text(std::to_string(histogram.get_count())));
+    }
+
+    auto column = [](Elements rows) {
+        for (auto &row : rows) {
+            row = row | align_right;
+        }
+        return vbox(std::move(rows));
+    };
+    Element timings = hbox({
+        vbox(std::move(stage_names)),
+        text("  "),
+        column(std::move(p50s)),
+        text("  "),
+        column(std::move(p99s)),
+        text("  "),
+        column(std::move(maxes)),
+        text("  "),
+        column(std::move(counts)),
+    });
+
+    if constexpr (not ALLOCATION_TRACKING_ENABLED) {
+        return timings | border | clear_under;
+    }
+
+    // only there in builds with allocation tracking
+    Elements tag_names = {text("allocations") | bold};
+    Elements allocation_counts = {text("n") | bold};
+    Elements byte_counts = {text("bytes") | bold};
+    for (size_t i = 0; i < static_cast<size_t>(AllocationTag::DUMMY); ++i) {
+        auto tag = static_cast<AllocationTag>(i);
+        AllocationCounts counts = get_allocation_counts(tag);
+        tag_names.push_back(text(allocation_tag_to_string(tag)));
+        allocation_counts.push_back(text(std::to_string(counts.num_allocations)));
+        byte_counts.push_back(text(format_byte_count(counts.num_bytes)));
+    }
+    auto add_summary_row = [&](const std::string &name, const AllocationSummary &summary) {
+        std::ostringstream average_num_allocations;
+        average_num_allocations << std::fixed << std::setprecision(1) << summary.get_average_num_allocations();
+        tag_names.push_back(text(name));
+        allocation_counts.push_back(text(average_num_allocations.str() + " avg " +
+                                         std::to_string(summary.max_num_allocations) + " max"));
+        byte_counts.push_back(text(format_byte_count(summary.get_average_num_bytes()) + " avg"));
+    };
+    const AllocationSummaries &allocation_summaries = global_allocation_summaries();
+    add_summary_row("per key press", allocation_summaries.per_key_press);
+    add_summary_row("per frame", allocation_summaries.per_frame);
+
+    Element allocations = hbox({
+        vbox(std::move(tag_names)),
+        text("  "),
+        column(std::move(allocation_counts)),
+        text("  "),
+        column(std::move(byte_counts)),
+    });
+    return vbox({timings, separator(), allocations}) | border | clear_under;
+}
+
 Component create_fuzzy_file_selection_modal(std::function<void()> do_nothing, std::function<void()> hide_modal,
                                             ModalEditor &modal_editor) {
 
@@ -912,9 +1062,12 @@ int main(int argc, char *argv[]) {
     // auto screen = ScreenInteractive::TerminalOutput();
     auto screen = ScreenInteractive::Fullscreen();
 
-    FileLogger fl("logs.txt");
+    // NOTE: nothing in the editor writes to the terminal or a file directly while it's running, it all goes through
+    // the logger which writes it out from its own thread
+    global_logger().start("logs.txt");
+    global_trace_recorder().set_current_thread_name("ui");
 
-    fl << "screen dimx: " << screen.dimx() << " screen dimy: " << screen.dimy() << std::endl;
+    LOG_INFO("screen dimx: {} screen dimy: {}", screen.dimx(), screen.dimy());
 
     int saved_for_automatic_column_adjustment = 0;
     int saved_last_col_for_automatic_column_adjustment = 0;
@@ -929,19 +1082,17 @@ int main(int argc, char *argv[]) {
     // numbers must be odd to have a center
     int num_lines = 41;
     int num_cols = 121;
-    int center_line = num_lines / 2;
-    int center_col = num_cols / 2;
 
     bool start_in_fullscreen = false;
 
     std::filesystem::path config_path = "~/.tbx_cfg.ini";
     // Configuration config(config_path, section_key_to_config_logic);
 
-    std::cout << username << std::endl;
+    LOG_DEBUG("username: {}", username);
 
     PeriodicSignal one_second_signal_for_status_bar_time_update(2);
 
-    std::cout << get_executable_path(argv) << std::endl;
+    LOG_DEBUG("executable path: {}", get_executable_path(argv));
 
     auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
     console_sink->set_level(spdlog::level::debug);
@@ -949,18 +1100,15 @@ int main(int argc, char *argv[]) {
     file_sink->set_level(spdlog::level::info);
     std::vector<spdlog::sink_ptr> sinks = {console_sink, file_sink};
 
-    std::string search_dir = ".";
-    std::vector<std::string> ignore_dirs = {"build", ".git", "__pycache__"};
-    std::vector<std::filesystem::path> searchable_files = rec_get_all_files(search_dir, ignore_dirs);
-    /*for (const auto &file : searchable_files) {*/
-    /*    std::cout << file.string() << '\n';*/
-    /*}*/
+    // walked once in the background and then kept up to date, so finding files never touches the disk per key
+    ProjectFileIndex project_file_index(".", {"build", ".git", "__pycache__"});
+    project_file_index.start();
 
     // FS BROWSER UI START
     std::vector<int> doids_for_textboxes_for_active_directory_for_later_removal;
 
     // InputState input_state;
-    std::cout << "after constructor" << std::endl;
+    LOG_DEBUG("after constructor");
 
     int line_where_selection_mode_started = -1;
     int col_where_selection_mode_started = -1;
@@ -986,21 +1134,19 @@ int main(int argc, char *argv[]) {
     ModalEditor modal_editor(viewport);
     modal_editor.switch_files(filename, true);
 
-    InputKeyState input_key_state = InputKeyState();
-
-    fl << "initial iks size: " << input_key_state.input_key_to_is_pressed.size() << std::endl;
+    LOG_DEBUG("initial iks size: {}", InputKeyState::NUM_KEYS);
 
     auto event_to_input_keys = get_event_to_input_keys();
 
     auto it = event_to_input_keys.find(Event::a);
     if (it != event_to_input_keys.end()) {
-        fl << "we have 'a'" << std::endl;
+        LOG_DEBUG("we have 'a'");
     } else {
-        fl << "we do not have 'a'" << std::endl;
+        LOG_DEBUG("we do not have 'a'");
     }
 
-    fl << "lookup input: " << Event::a.input() << std::endl;
-    fl << "key input: " << event_to_input_keys.begin()->first.input() << std::endl;
+    LOG_DEBUG("lookup input: {}", Event::a.input());
+    LOG_DEBUG("key input: {}", event_to_input_keys.begin()->first.input());
 
     // TODO: Terrible, I don't know why the above reports back a size 2, which makes no sense
     // therefore I just "fix" it here, something is really wrong with get_event_to_input_keys function.
@@ -1008,36 +1154,54 @@ int main(int argc, char *argv[]) {
 
     it = event_to_input_keys.find(Event::Return);
     if (it != event_to_input_keys.end()) {
-        fl << "Found mapping for Return key" << std::endl;
-        fl << "Number of keys in mapping: " << it->second.size() << std::endl;
+        LOG_DEBUG("Found mapping for Return key");
+        LOG_DEBUG("Number of keys in mapping: {}", it->second.size());
 
         if (it->second.size() == 1 && it->second[0] == InputKey::ENTER) {
-            fl << "Return is correctly mapped to exactly one key: InputKey::ENTER" << std::endl;
+            LOG_DEBUG("Return is correctly mapped to exactly one key: InputKey::ENTER");
         } else {
-            fl << "Unexpected mapping for Return key:" << std::endl;
+            LOG_WARNING("Unexpected mapping for Return key:");
             for (const auto &key : it->second) {
-                fl << "  - Key: " << input_key_to_string(key, true) << std::endl;
+                LOG_WARNING("  - Key: {}", input_key_to_string(key, true));
             }
         }
     } else {
-        fl << "No mapping found for Return key" << std::endl;
+        LOG_WARNING("No mapping found for Return key");
     }
 
     // auto c = Canvas(num_cols, num_lines);
     // c.DrawPointCircle(5, 5, 5);
 
-    std::thread animation_thread([&] {
-        while (not modal_editor.requested_quit) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100)); // ~60 FPS
-            screen.PostEvent(Event::Custom);
-        }
-        screen.Exit(); // triggers exit from screen.Loop
-    });
+    // frames are only drawn when something changed, input always gets a frame from ftxui itself, everything else
+    // (the clock, files that are still being indexed) asks the scheduler for one
+    FrameScheduler frame_scheduler([&] { screen.PostEvent(Event::Custom); });
+    // a search over a big file is spread out over frames, this is how much of each frame it gets
+    const std::chrono::microseconds file_search_time_budget_per_frame(4000);
 
-    std::vector<Event> keys;
+    // kept around between frames, only the rows the damage tracker reports as dirty get laid out and rebuilt again
+    // NOTE: ftxui still writes the whole frame out to the terminal, what this saves is the work of building it
+    std::vector<ViewportRow> visible_rows;
+    Elements row_elements;
+    EditorMode last_drawn_mode = modal_editor.current_mode;
+    bool last_drawn_cursor_visibility = true;
+    std::pair<int, int> last_drawn_cursor_position;
 
     auto component = Container::Vertical({
         Renderer([&] {
+            ScopedTraceSpan render_span("render", "render");
+            ScopedAllocationSample frame_allocation_sample(global_allocation_summaries().per_frame);
+            // every key that came in since the last frame is applied before anything else looks at the editor
+            auto oldest_key_press_received_at = modal_editor.input_events.get_oldest_received_at();
+            modal_editor.run_queued_input_events(project_file_index);
+            if (modal_editor.requested_quit) {
+                screen.Exit(); // triggers exit from screen.Loop
+            }
+
+            // NOTE: this goes first, finding the match that n was waiting on moves the cursor
+            bool file_search_has_work_left = modal_editor.run_file_search_for(file_search_time_budget_per_frame);
+            bool file_save_is_running = modal_editor.update_file_saves();
+            modal_editor.submit_undo_journals();
+
             num_lines = screen.dimy() - 2 * 4; // space for status bar
             num_cols = screen.dimx();
 
@@ -1047,72 +1211,107 @@ int main(int argc, char *argv[]) {
             modal_editor.viewport.half_num_cols = num_cols / 2;
             modal_editor.viewport.half_num_lines = num_lines / 2;
 
-            center_line = num_lines / 2;
-            center_col = num_cols / 2;
-
-            auto c = Canvas(num_cols * 2, num_lines * 4); // Match canvas size to your drawing area
-
-            unsigned int vsel_min_buf_col = std::min(modal_editor.buffer_col_where_selection_mode_started,
-                                                     modal_editor.viewport.active_buffer_col_under_cursor);
-            unsigned int vsel_max_buf_col = std::max(modal_editor.buffer_col_where_selection_mode_started,
-                                                     modal_editor.viewport.active_buffer_col_under_cursor);
-            unsigned int vsel_min_buf_line = std::min(modal_editor.buffer_line_where_selection_mode_started,
-                                                      modal_editor.viewport.active_buffer_line_under_cursor);
-            unsigned int vsel_max_buf_line = std::max(modal_editor.buffer_line_where_selection_mode_started,
-                                                      modal_editor.viewport.active_buffer_line_under_cursor);
-
-            for (int vp_line = 0; vp_line < num_lines; vp_line++) {
-                for (int vp_col = 0; vp_col < num_cols; vp_col++) {
-
-                    bool line_in_visual_selection = false;
-                    bool col_in_visual_selection = false;
-                    bool cell_should_be_selected = false;
-
-                    if (modal_editor.current_mode == VISUAL_SELECT) {
-                        auto [buf_line, buf_col] =
-                            modal_editor.viewport.viewport_idx_to_centered_buffer_idx(vp_line, vp_col);
-                        line_in_visual_selection = vsel_min_buf_line <= buf_line and buf_line <= vsel_max_buf_line;
-                        col_in_visual_selection = vsel_min_buf_col <= buf_col and buf_col <= vsel_max_buf_col;
-                        cell_should_be_selected = line_in_visual_selection and col_in_visual_selection;
-                    }
-
-                    bool position_is_within_selection_column_wise =
-                        modal_editor.buffer_col_where_selection_mode_started <= vp_line and
-                        vp_line <= modal_editor.viewport.active_buffer_col_under_cursor;
-
-                    std::string cell_char(1, viewport.get_symbol_at(vp_line, vp_col));
-                    c.DrawText(vp_col * 2, vp_line * 4, cell_char, [&](Pixel &p) {
-                        bool at_center = vp_line == center_line and vp_col == center_col;
-                        // the modal editor will always cover up the thing so in that case don't draw it
-                        if (at_center and not modal_editor.fuzzy_file_selection_modal.active) {
-                            p.background_color = Color::White;
-                            p.foreground_color = Color::Black;
-                        } else if (cell_should_be_selected) {
-                            p.background_color = Color::Grey63;
-                        } else {
-                            p.foreground_color = Color::White;
-                        }
-                    });
-                }
+            std::optional<ScopedPerfProbe> viewport_render_probe(std::in_place, PerfStage::VIEWPORT_RENDER);
+            ScopedAllocationTag render_allocation_tag(AllocationTag::RENDER);
+
+            int vsel_min_buf_col = std::min(modal_editor.buffer_col_where_selection_mode_started,
+                                            modal_editor.viewport.active_buffer_col_under_cursor);
+            int vsel_max_buf_col = std::max(modal_editor.buffer_col_where_selection_mode_started,
+                                            modal_editor.viewport.active_buffer_col_under_cursor);
+            int vsel_min_buf_line = std::min(modal_editor.buffer_line_where_selection_mode_started,
+                                             modal_editor.viewport.active_buffer_line_under_cursor);
+            int vsel_max_buf_line = std::max(modal_editor.buffer_line_where_selection_mode_started,
+                                             modal_editor.viewport.active_buffer_line_under_cursor);
+
+            // the mode and the modal change how every row is styled, which doesn't show up as an edit or a move
+            bool cursor_is_drawn = not modal_editor.fuzzy_file_selection_modal.active;
+            if (modal_editor.current_mode != last_drawn_mode or cursor_is_drawn != last_drawn_cursor_visibility) {
+                modal_editor.viewport.damage_tracker.mark_all_rows_dirty();
+                last_drawn_mode = modal_editor.current_mode;
+                last_drawn_cursor_visibility = cursor_is_drawn;
+            }
+            // the selection follows the cursor and can cover any of the rows
+            std::pair<int, int> cursor_position = {modal_editor.viewport.active_buffer_line_under_cursor,
+                                                   modal_editor.viewport.active_buffer_col_under_cursor};
+            if (modal_editor.current_mode == VISUAL_SELECT and cursor_position != last_drawn_cursor_position) {
+                modal_editor.viewport.damage_tracker.mark_all_rows_dirty();
             }
+            last_drawn_cursor_position = cursor_position;
 
-            if (modal_editor.fuzzy_file_selection_modal.active) {
+            auto dirty_row_spans = modal_editor.viewport.get_dirty_row_spans();
+            auto [cursor_row, cursor_col] = modal_editor.viewport.get_cursor_viewport_idx();
+            row_elements.resize(num_lines);
+
+            for (const auto &dirty_row_span : dirty_row_spans) {
+                modal_editor.viewport.get_visible_rows(visible_rows, dirty_row_span.start_row, dirty_row_span.end_row);
             }
 
-            auto just_pressed_keys = input_key_state.get_keys_just_pressed_this_tick();
-            fl << "in Renderer Just pressed keys this tick:";
-            for (const auto &key_str : just_pressed_keys) {
-                fl << " " << key_str;
+            for (int vp_line = 0; vp_line < visible_rows.size(); vp_line++) {
+                if (not modal_editor.viewport.damage_tracker.is_row_dirty(vp_line)) {
+                    continue;
+                }
+                const ViewportRow &row = visible_rows[vp_line];
+
+                int selection_start = -1;
+                int selection_end = -1;
+                bool line_in_visual_selection = vsel_min_buf_line <= row.buffer_line and
+                                                row.buffer_line <= vsel_max_buf_line and row.buffer_line >= 0;
+                if (modal_editor.current_mode == VISUAL_SELECT and line_in_visual_selection) {
+                    // the gutter is never part of the selection, so the selection can't start left of column 0
+                    selection_start = std::max(vsel_min_buf_col, 0) - row.first_buffer_col;
+                    selection_end = vsel_max_buf_col + 1 - row.first_buffer_col;
+                }
+
+                // the modal editor will always cover up the thing so in that case don't draw it
+                bool row_has_cursor = vp_line == cursor_row and cursor_is_drawn;
+
+                row_elements[vp_line] =
+                    render_viewport_row(row.text, selection_start, selection_end, row_has_cursor ? cursor_col : -1);
             }
-            fl << std::endl;
+            modal_editor.viewport.damage_tracker.clear();
 
-            input_key_state.process_input_state();
+            if (modal_editor.fuzzy_file_selection_modal.active) {
+            }
 
             auto command_and_update_bar = text(modal_editor.command_bar_input);
 
             auto status = generate_status_bar(modal_editor, modal_editor.viewport.buffer->current_file_path);
 
-            return vbox(canvas(std::move(c)) | border, status, command_and_update_bar);
+            Element viewport_element = vbox(row_elements) | border;
+            if (modal_editor.show_perf_overlay) {
+                viewport_element =
+                    dbox({viewport_element, vbox({hbox({filler(), generate_perf_overlay()}), filler()})});
+            }
+
+            viewport_render_probe.reset();
+            if (oldest_key_press_received_at) {
+                global_perf_probes().record(PerfStage::KEY_TO_FRAME,
+                                            std::chrono::steady_clock::now() - *oldest_key_press_received_at);
+            }
+            frame_scheduler.notify_frame_rendered();
+            // the clock in the status bar changes every second
+            auto now = std::chrono::system_clock::now();
+            auto time_until_next_second =
+                std::chrono::ceil<std::chrono::seconds>(now + std::chrono::milliseconds(1)) - now;
+            frame_scheduler.request_frame_at(FrameScheduler::Clock::now() + time_until_next_second);
+            // more lines keep showing up while a big file is being indexed
+            if (modal_editor.viewport.buffer->is_still_indexing()) {
+                frame_scheduler.request_frame_at(FrameScheduler::Clock::now() + std::chrono::milliseconds(100));
+            }
+            if (file_search_has_work_left) {
+                frame_scheduler.request_frame();
+            }
+            // the save progress in the status bar moves along while nothing else happens
+            if (file_save_is_running) {
+                frame_scheduler.request_frame_at(FrameScheduler::Clock::now() + std::chrono::milliseconds(100));
+            }
+
+            // signals fired outside of input handling (a search jumping to its match, a save finishing) only happen
+            // on the ui thread during a frame, and the changes behind them were drawn above, so they are done with
+            // here instead of waiting for the next key press
+            TemporalBinarySignal::process_all();
+
+            return vbox(viewport_element, status, command_and_update_bar);
         }),
     });
 
@@ -1123,59 +1322,105 @@ int main(int argc, char *argv[]) {
 
     component |= Modal(modal_component, &modal_editor.fuzzy_file_selection_modal.active);
 
+    // with bracketed paste on the terminal wraps pasted text in these, so a paste can go into the buffer in one go
+    // instead of being typed out key by key (which would also run every character outside of insert mode as a command)
+    const std::string bracketed_paste_start = "\x1b[200~";
+    const std::string bracketed_paste_end = "\x1b[201~";
+    bool receiving_paste = false;
+    std::string pasted_text;
+
     component |= CatchEvent([&](Event event) {
-        keys.push_back(event);
+        ScopedAllocationTag allocation_tag(AllocationTag::INPUT);
+
+        if (event.input() == bracketed_paste_start) {
+            receiving_paste = true;
+            pasted_text.clear();
+            return false;
+        }
+
+        if (receiving_paste) {
+            if (event.input() == bracketed_paste_end) {
+                receiving_paste = false;
+                LOG_DEBUG("got paste of {} bytes", pasted_text.size());
+                modal_editor.queue_paste(std::move(pasted_text));
+                pasted_text.clear();
+            } else if (event.is_character()) {
+                pasted_text += event.character();
+            } else if (event == Event::Return) {
+                pasted_text += '\n';
+            } else if (event == Event::Tab) {
+                pasted_text += '\t';
+            }
+            return false;
+        }
 
-        fl << "got event" << std::endl;
+        LOG_TRACE("got event");
 
         if (event == Event::Return) {
-            fl << "got return" << std::endl;
+            LOG_TRACE("got return");
         }
 
         auto it = event_to_input_keys.find(event);
         if (it != event_to_input_keys.end()) {
             for (const auto &key : it->second) {
-                auto str = input_key_to_string(key, false);
-                fl << "got str: " << str << std::endl;
-                input_key_state.input_key_to_is_pressed[key] = true;
-                bool was_pressed = input_key_state.input_key_to_is_pressed_prev[key];
-                input_key_state.input_key_to_just_pressed[key] =
-                    input_key_state.input_key_to_is_pressed[key] && !was_pressed;
-                fl << "in catch, is pressed: " << input_key_state.input_key_to_is_pressed[key]
-                   << " was not pressed: " << !was_pressed << std::endl;
+                LOG_TRACE("got str: {}", input_key_to_string(key, false));
             }
-            fl << std::endl;
+            // applied by the renderer, which the frontend runs right after it's done handing over events
+            modal_editor.queue_key_press(it->second);
         } else {
-            fl << "No mapping found for event: " << std::endl;
+            LOG_TRACE("No mapping found for event: {}", event.input());
         }
 
         // render to the canvas
 
-        // fl << "post event" << std::endl;
+        // LOG_TRACE("post event");
         // screen.PostEvent(Event::Custom);
         // screen.RequestAnimationFrame();
 
-        modal_editor.iks = input_key_state;
-
-        std::string search_dir = ".";
-        std::vector<std::string> ignore_dirs = {"build", ".git", "__pycache__"};
-        std::vector<std::filesystem::path> searchable_files = rec_get_all_files(search_dir, ignore_dirs);
-
-        viewport.save_previous_viewport_screen();
-        modal_editor.run_key_logic(searchable_files);
-
-        auto keys = modal_editor.iks.get_keys_just_pressed_this_tick();
-
-        if (std::find(keys.begin(), keys.end(), " ") != keys.end()) {
-            fl << "GOT SPACE" << std::endl;
-        }
-
-        TemporalBinarySignal::process_all();
         return false;
     });
 
+    std::cout << "\x1b[?2004h" << std::flush;
     screen.Loop(component);
-    animation_thread.join();
+    std::cout << "\x1b[?2004l" << std::flush;
+    frame_scheduler.stop();
+    // :wq quits right away, the file it saved still has to make it to disk
+    modal_editor.wait_for_file_saves();
+
+    auto frame_stats = frame_scheduler.get_stats();
+    LOG_INFO("frames rendered: {} posted: {} skipped: {} merged requests: {}", frame_stats.frames_rendered,
+             frame_stats.frames_posted, frame_stats.frames_skipped, frame_stats.requests_merged);
+    auto input_event_stats = modal_editor.input_events.get_stats();
+    auto to_microseconds = [](auto duration) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    };
+    LOG_INFO("input events applied: {} max queue depth: {} average latency: {}us max latency: {}us",
+             input_event_stats.num_events_applied, input_event_stats.max_depth,
+             to_microseconds(input_event_stats.get_average_latency()), to_microseconds(input_event_stats.max_latency));
+    for (size_t i = 0; i < PerfProbes::NUM_STAGES; ++i) {
+        auto stage = static_cast<PerfStage>(i);
+        const LatencyHistogram &histogram = global_perf_probes().get_histogram(stage);
+        LOG_INFO("{}: p50 {}us p99 {}us max {}us n {}", perf_stage_to_string(stage),
+                 to_microseconds(histogram.get_percentile(50)), to_microseconds(histogram.get_percentile(99)),
+                 to_microseconds(histogram.get_max()), histogram.get_count());
+    }
+    if constexpr (ALLOCATION_TRACKING_ENABLED) {
+        for (size_t i = 0; i < static_cast<size_t>(AllocationTag::DUMMY); ++i) {
+            auto tag = static_cast<AllocationTag>(i);
+            AllocationCounts counts = get_allocation_counts(tag);
+            LOG_INFO("{} allocations: {} bytes: {} frees: {}", allocation_tag_to_string(tag), counts.num_allocations,
+                     counts.num_bytes, counts.num_frees);
+        }
+        const AllocationSummary &per_key_press = global_allocation_summaries().per_key_press;
+        LOG_INFO("key presses: {} without allocations: {} average allocations: {} max allocations: {}",
+                 per_key_press.num_samples, per_key_press.num_samples_without_allocations,
+                 per_key_press.get_average_num_allocations(), per_key_press.max_num_allocations);
+        const AllocationSummary &per_frame = global_allocation_summaries().per_frame;
+        LOG_INFO("frames: {} average allocations: {} average bytes: {} max allocations: {}", per_frame.num_samples,
+                 per_frame.get_average_num_allocations(), per_frame.get_average_num_bytes(),
+                 per_frame.max_num_allocations);
+    }
+    global_logger().stop();
 
     // thread.detach();
 
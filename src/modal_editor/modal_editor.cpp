@@ -1,6 +1,10 @@
 #include "modal_editor.hpp"
 #include <algorithm>
-#include <rapidfuzz/fuzz.hpp>
+
+#include "../utility/allocation_tracker/allocation_tracker.hpp"
+#include "../utility/perf_probes/perf_probes.hpp"
+#include "../utility/ring_logger/ring_logger.hpp"
+#include "../utility/trace_recorder/trace_recorder.hpp"
 
 std::string ModalEditor::get_mode_string() {
     switch (current_mode) {
@@ -20,196 +24,196 @@ std::string ModalEditor::get_mode_string() {
     return "";
 }
 
-// the returned string has length one, guarenteed
-std::string input_key_to_string(InputKey key, bool shift_pressed) {
+char input_key_to_character(InputKey key, bool shift_pressed) {
     switch (key) {
     case InputKey::a:
-        return shift_pressed ? "A" : "a";
+        return shift_pressed ? 'A' : 'a';
     case InputKey::b:
-        return shift_pressed ? "B" : "b";
+        return shift_pressed ? 'B' : 'b';
     case InputKey::c:
-        return shift_pressed ? "C" : "c";
+        return shift_pressed ? 'C' : 'c';
     case InputKey::d:
-        return shift_pressed ? "D" : "d";
+        return shift_pressed ? 'D' : 'd';
     case InputKey::e:
-        return shift_pressed ? "E" : "e";
+        return shift_pressed ? 'E' : 'e';
     case InputKey::f:
-        return shift_pressed ? "F" : "f";
+        return shift_pressed ? 'F' : 'f';
     case InputKey::g:
-        return shift_pressed ? "G" : "g";
+        return shift_pressed ? 'G' : 'g';
     case InputKey::h:
-        return shift_pressed ? "H" : "h";
+        return shift_pressed ? 'H' : 'h';
     case InputKey::i:
-        return shift_pressed ? "I" : "i";
+        return shift_pressed ? 'I' : 'i';
     case InputKey::j:
-        return shift_pressed ? "J" : "j";
+        return shift_pressed ? 'J' : 'j';
     case InputKey::k:
-        return shift_pressed ? "K" : "k";
+        return shift_pressed ? 'K' : 'k';
     case InputKey::l:
-        return shift_pressed ? "L" : "l";
+        return shift_pressed ? 'L' : 'l';
     case InputKey::m:
-        return shift_pressed ? "M" : "m";
+        return shift_pressed ? 'M' : 'm';
     case InputKey::n:
-        return shift_pressed ? "N" : "n";
+        return shift_pressed ? 'N' : 'n';
     case InputKey::o:
-        return shift_pressed ? "O" : "o";
+        return shift_pressed ? 'O' : 'o';
     case InputKey::p:
-        return shift_pressed ? "P" : "p";
+        return shift_pressed ? 'P' : 'p';
     case InputKey::q:
-        return shift_pressed ? "Q" : "q";
+        return shift_pressed ? 'Q' : 'q';
     case InputKey::r:
-        return shift_pressed ? "R" : "r";
+        return shift_pressed ? 'R' : 'r';
     case InputKey::s:
-        return shift_pressed ? "S" : "s";
+        return shift_pressed ? 'S' : 's';
     case InputKey::t:
-        return shift_pressed ? "T" : "t";
+        return shift_pressed ? 'T' : 't';
     case InputKey::u:
-        return shift_pressed ? "U" : "u";
+        return shift_pressed ? 'U' : 'u';
     case InputKey::v:
-        return shift_pressed ? "V" : "v";
+        return shift_pressed ? 'V' : 'v';
     case InputKey::w:
-        return shift_pressed ? "W" : "w";
+        return shift_pressed ? 'W' : 'w';
     case InputKey::x:
-        return shift_pressed ? "X" : "x";
+        return shift_pressed ? 'X' : 'x';
     case InputKey::y:
-        return shift_pressed ? "Y" : "y";
+        return shift_pressed ? 'Y' : 'y';
     case InputKey::z:
-        return shift_pressed ? "Z" : "z";
+        return shift_pressed ? 'Z' : 'z';
 
     case InputKey::ZERO:
-        return shift_pressed ? ")" : "0";
+        return shift_pressed ? ')' : '0';
     case InputKey::ONE:
-        return shift_pressed ? "!" : "1";
+        return shift_pressed ? '!' : '1';
     case InputKey::TWO:
-        return shift_pressed ? "@" : "2";
+        return shift_pressed ? '@' : '2';
     case InputKey::THREE:
-        return shift_pressed ? "#" : "3";
+        return shift_pressed ? '#' : '3';
     case InputKey::FOUR:
-        return shift_pressed ? "$" : "4";
+        return shift_pressed ? '$' : '4';
     case InputKey::FIVE:
-        return shift_pressed ? "%" : "5";
+        return shift_pressed ? '%' : '5';
     case InputKey::SIX:
-        return shift_pressed ? "^" : "6";
+        return shift_pressed ? '^' : '6';
     case InputKey::SEVEN:
-        return shift_pressed ? "&" : "7";
+        return shift_pressed ? '&' : '7';
     case InputKey::EIGHT:
-        return shift_pressed ? "*" : "8";
+        return shift_pressed ? '*' : '8';
     case InputKey::NINE:
-        return shift_pressed ? "(" : "9";
+        return shift_pressed ? '(' : '9';
 
     case InputKey::SPACE:
-        return " ";
+        return ' ';
     case InputKey::ENTER:
-        return "\n";
+        return '\n';
     case InputKey::TAB:
-        return "\t";
+        return '\t';
     case InputKey::COMMA:
-        return shift_pressed ? "<" : ",";
+        return shift_pressed ? '<' : ',';
     case InputKey::PERIOD:
-        return shift_pressed ? ">" : ".";
+        return shift_pressed ? '>' : '.';
     case InputKey::SLASH:
-        return shift_pressed ? "?" : "/";
+        return shift_pressed ? '?' : '/';
     case InputKey::SEMICOLON:
-        return shift_pressed ? ":" : ";";
+        return shift_pressed ? ':' : ';';
     case InputKey::SINGLE_QUOTE:
-        return shift_pressed ? "\"" : "'";
+        return shift_pressed ? '"' : '\'';
     case InputKey::LEFT_SQUARE_BRACKET:
-        return shift_pressed ? "{" : "[";
+        return shift_pressed ? '{' : '[';
     case InputKey::RIGHT_SQUARE_BRACKET:
-        return shift_pressed ? "}" : "]";
+        return shift_pressed ? '}' : ']';
     case InputKey::MINUS:
-        return shift_pressed ? "_" : "-";
+        return shift_pressed ? '_' : '-';
     case InputKey::EQUAL:
-        return shift_pressed ? "+" : "=";
+        return shift_pressed ? '+' : '=';
     case InputKey::BACKSLASH:
-        return shift_pressed ? "|" : "\\";
+        return shift_pressed ? '|' : '\\';
 
     default:
-        return ""; // ignore unknown or non-character keys
+        return '\0'; // ignore unknown or non-character keys
     }
 }
 
+// the returned string has length one, or zero for keys that don't type a character
+std::string input_key_to_string(InputKey key, bool shift_pressed) {
+    char character = input_key_to_character(key, shift_pressed);
+    return character == '\0' ? std::string() : std::string(1, character);
+}
+
 ModalEditor::ModalEditor(Viewport &viewport) : viewport(viewport) {
-    regex_command_runner.add_regex("^x", [&](const std::smatch &m) { delete_at_current_cursor_position_logic(); });
+    keymap.add_binding("x", [&](const KeymapMatch &m) { delete_at_current_cursor_position_logic(); });
 
-    regex_command_runner.add_regex("^<<", [&](const std::smatch &m) { viewport.unindent_at_cursor(); });
+    keymap.add_binding("<<", [&](const KeymapMatch &m) { viewport.unindent_at_cursor(); });
 
-    regex_command_runner.add_regex("^m", [&](const std::smatch &m) {
+    keymap.add_binding("m", [&](const KeymapMatch &m) {
         if (current_mode == MOVE_AND_EDIT || current_mode == VISUAL_SELECT) {
             viewport.move_cursor_to_middle_of_line();
         }
     });
 
-    regex_command_runner.add_regex("^\\$", [&](const std::smatch &m) {
+    keymap.add_binding("$", [&](const KeymapMatch &m) {
         if (current_mode == MOVE_AND_EDIT || current_mode == VISUAL_SELECT) {
             viewport.move_cursor_to_end_of_line();
         }
     });
 
-    regex_command_runner.add_regex("^[pP]", [&](const std::smatch &m) { paste_at_cursor_position_logic(m); });
+    keymap.add_binding("[pP]", [&](const KeymapMatch &m) { paste_at_cursor_position_logic(m); });
 
-    regex_command_runner.add_regex("^0", [&](const std::smatch &m) {
+    keymap.add_binding("0", [&](const KeymapMatch &m) {
         if (current_mode == MOVE_AND_EDIT || current_mode == VISUAL_SELECT) {
             viewport.move_cursor_to_start_of_line();
         }
     });
 
-    regex_command_runner.add_regex("^v", [&](const std::smatch &m) { start_visual_selection(); });
+    keymap.add_binding("v", [&](const KeymapMatch &m) { start_visual_selection(); });
 
-    regex_command_runner.add_regex("^i", [&](const std::smatch &m) { enter_insert_mode(); });
+    keymap.add_binding("i", [&](const KeymapMatch &m) { enter_insert_mode(); });
 
-    regex_command_runner.add_regex("^a", [&](const std::smatch &m) { enter_insert_mode_after_cursor_position(); });
+    keymap.add_binding("a", [&](const KeymapMatch &m) { enter_insert_mode_after_cursor_position(); });
 
-    regex_command_runner.add_regex("^A", [&](const std::smatch &m) { enter_insert_mode_at_end_of_line(); });
+    keymap.add_binding("A", [&](const KeymapMatch &m) { enter_insert_mode_at_end_of_line(); });
 
-    regex_command_runner.add_regex("^I", [&](const std::smatch &m) {
+    keymap.add_binding("I", [&](const KeymapMatch &m) {
         enter_insert_mode_in_front_of_first_non_whitespace_character_on_active_line();
     });
 
-    regex_command_runner.add_regex(
-        "^\\^", [&](const std::smatch &m) { move_cursor_to_first_non_whitespace_character_on_active_line(); });
+    keymap.add_binding("^",
+                       [&](const KeymapMatch &m) { move_cursor_to_first_non_whitespace_character_on_active_line(); });
 
-    regex_command_runner.add_regex(R"(^(\d*)([jklh]))",
-                                   [&](const std::smatch &m) { handle_hjkl_with_number_modifier(m); });
+    keymap.add_binding("[jklh]", [&](const KeymapMatch &m) { handle_hjkl_with_number_modifier(m); });
 
-    regex_command_runner.add_regex(R"(^(\d*)G)", [&](const std::smatch &m) { go_to_specific_line_number(m); });
+    keymap.add_binding("G", [&](const KeymapMatch &m) { go_to_specific_line_number(m); });
 
-    regex_command_runner.add_regex(R"(^([cd]?)([fFtT])(.))",
-                                   [&](const std::smatch &m) { change_or_delete_till_or_find_to_character(m); });
+    keymap.add_binding("[cd]?[fFtT].", [&](const KeymapMatch &m) { change_or_delete_till_or_find_to_character(m); });
 
-    // Regex for [cd][webB] (change/delete with word motions)
-    regex_command_runner.add_regex(R"(^([cd]?)([webB]))",
-                                   [&](const std::smatch &m) { change_or_delete_using_word_motion(m); });
+    // [cd][webB] (change/delete with word motions)
+    keymap.add_binding("[cd]?[webB]", [&](const KeymapMatch &m) { change_or_delete_using_word_motion(m); });
 
     // modification within brackets
-    regex_command_runner.add_regex(R"(^([cd])([ai])([bB]))",
-                                   [&](const std::smatch &m) { change_or_delete_inside_or_around_brackets(m); });
+    keymap.add_binding("[cd][ai][bB]", [&](const KeymapMatch &m) { change_or_delete_inside_or_around_brackets(m); });
 
     // go to top of file
-    regex_command_runner.add_regex("^gg", [&](const std::smatch &m) {
+    keymap.add_binding("gg", [&](const KeymapMatch &m) {
         if (current_mode == MOVE_AND_EDIT) {
             viewport.set_active_buffer_line_under_cursor(0);
         }
     });
 
-    regex_command_runner.add_regex("^[oO]",
-                                   [&](const std::smatch &m) { open_new_line_below_or_above_current_line(m); });
+    keymap.add_binding("[oO]", [&](const KeymapMatch &m) { open_new_line_below_or_above_current_line(m); });
 
-    regex_command_runner.add_regex("^u", [&](const std::smatch &m) { undo(); });
-    regex_command_runner.add_regex("^r", [&](const std::smatch &m) { redo(); });
-    regex_command_runner.add_regex("^ sf", [&](const std::smatch &m) { launch_search_files(); });
-    regex_command_runner.add_regex("^  ", [&](const std::smatch &m) { search_active_buffers(); });
-    // rcr.add_regex("^ gd", [&](const std::smatch &m) { go_to_definition_dummy(); });
+    keymap.add_binding("u", [&](const KeymapMatch &m) { undo(); });
+    keymap.add_binding("r", [&](const KeymapMatch &m) { redo(); });
+    keymap.add_binding(" sf", [&](const KeymapMatch &m) { launch_search_files(); });
+    keymap.add_binding("  ", [&](const KeymapMatch &m) { search_active_buffers(); });
+    // keymap.add_binding(" gd", [&](const KeymapMatch &m) { go_to_definition_dummy(); });
 
-    regex_command_runner.add_regex("^dd", [&](const std::smatch &m) {
+    keymap.add_binding("dd", [&](const KeymapMatch &m) {
         if (current_mode == MOVE_AND_EDIT) {
             viewport.delete_line_at_cursor();
         }
     });
 
-    regex_command_runner.add_regex("^yy", [&](const std::smatch &m) {
+    keymap.add_binding("yy", [&](const KeymapMatch &m) {
         if (current_mode == MOVE_AND_EDIT) {
-            std::string current_line = viewport.buffer->get_line(viewport.active_buffer_line_under_cursor);
+            std::string_view current_line = viewport.buffer->get_line(viewport.active_buffer_line_under_cursor);
             // NOTE: commented out because trying not to depend on the clipboard thing, instead replace with lambda
             // functiont o call or something like that glfwSetClipboardString(window.glfw_window,
             // current_line.c_str());
@@ -218,11 +222,10 @@ ModalEditor::ModalEditor(Viewport &viewport) : viewport(viewport) {
 
     bool editing_a_cpp_project = true;
     if (editing_a_cpp_project) {
-        regex_command_runner.add_regex("^ cc", [&](const std::smatch &m) { switch_to_cpp_source_file(); });
+        keymap.add_binding(" cc", [&](const KeymapMatch &m) { switch_to_cpp_source_file(); });
 
-        regex_command_runner.add_regex("^ hh", [&](const std::smatch &m) { switch_to_hpp_source_file(); });
+        keymap.add_binding(" hh", [&](const KeymapMatch &m) { switch_to_hpp_source_file(); });
     }
-    regex_command_runner_has_been_configured = true;
 };
 
 // this is here because I'm removing the dependency on lsp client
@@ -245,16 +248,16 @@ void ModalEditor::switch_files(const std::string &file_to_open, bool store_movem
 
     bool found_active_file_buffer = false;
     for (auto active_file_buffer : viewport.active_file_buffers) {
-        std::cout << active_file_buffer->current_file_path << std::endl;
+        LOG_TRACE("open buffer: {}", active_file_buffer->current_file_path);
         if (active_file_buffer->current_file_path == file_to_open) {
-            std::cout << "found matching buffer for " << file_to_open << " using it." << std::endl;
+            LOG_DEBUG("found matching buffer for {} using it.", file_to_open);
             viewport.switch_buffers_and_adjust_viewport_position(active_file_buffer, store_movements_to_history);
             found_active_file_buffer = true;
         }
     }
 
     if (not found_active_file_buffer) {
-        std::cout << "didn't find matching buffer creating new buffer for: " << file_to_open << std::endl;
+        LOG_DEBUG("didn't find matching buffer creating new buffer for: {}", file_to_open);
         auto ltb = std::make_shared<LineTextBuffer>();
         // ltb->load_file(lsp_client.get_full_path(file_to_open));
         ltb->load_file(get_full_path(file_to_open));
@@ -323,9 +326,9 @@ void ModalEditor::delete_line_current_cursor_position() {
     }
 }
 
-void ModalEditor::paste_at_cursor_position_logic(const std::smatch &m) {
+void ModalEditor::paste_at_cursor_position_logic(const KeymapMatch &m) {
     if (current_mode == MOVE_AND_EDIT) {
-        if (m.str(0) == "P") {
+        if (m.capture(0) == 'P') {
             // Uppercase 'P' - insert content from the clipboard
             // NOTE: that this needs to be replaced somehow
             // const char *clipboard_content = glfwGetClipboardString(window.glfw_window);
@@ -333,10 +336,11 @@ void ModalEditor::paste_at_cursor_position_logic(const std::smatch &m) {
             //     // TODO: make change request
             //     viewport.insert_string_at_cursor(clipboard_content);
             // }
-        } else if (m.str(0) == "p") {
+        } else if (m.capture(0) == 'p') {
             // Lowercase 'p' - insert the last deleted content
             // TODO: make change request
-            viewport.insert_string_at_cursor(viewport.buffer->get_last_deleted_content());
+            // NOTE: the copy is needed, inserting modifies the buffer which invalidates the view
+            viewport.insert_string_at_cursor(std::string(viewport.buffer->get_last_deleted_content()));
         }
     }
 }
@@ -396,10 +400,10 @@ void ModalEditor::move_cursor_to_first_non_whitespace_character_on_active_line()
     }
 }
 
-void ModalEditor::handle_hjkl_with_number_modifier(const std::smatch &m) {
+void ModalEditor::handle_hjkl_with_number_modifier(const KeymapMatch &m) {
     if (current_mode == MOVE_AND_EDIT or current_mode == VISUAL_SELECT) {
-        int count = m[1].str().empty() ? 1 : std::stoi(m[1].str());
-        char direction = m[2].str()[0];
+        int count = m.count;
+        char direction = m.capture(0);
 
         int line_delta = 0, col_delta = 0;
         switch (direction) {
@@ -419,7 +423,7 @@ void ModalEditor::handle_hjkl_with_number_modifier(const std::smatch &m) {
             }
             break; // Scroll left
         case 'l':
-            const std::string &line = viewport.buffer->get_line(viewport.active_buffer_line_under_cursor);
+            std::string_view line = viewport.buffer->get_line(viewport.active_buffer_line_under_cursor);
 
             // TODO: this is bad because it stops me from being able to scroll rightware
             // if I want to on a blank line which is a real use case because sometimes
@@ -439,48 +443,46 @@ void ModalEditor::handle_hjkl_with_number_modifier(const std::smatch &m) {
     }
 }
 
-void ModalEditor::go_to_specific_line_number(const std::smatch &m) {
-    std::string digits = m[1].str();
-    if (digits.empty()) {
+void ModalEditor::go_to_specific_line_number(const KeymapMatch &m) {
+    if (not m.count_given) {
         int last_line_index = viewport.buffer->line_count() - 1;
         viewport.set_active_buffer_line_under_cursor(last_line_index);
     } else {
-        int number = std::stoi(digits);
-        viewport.set_active_buffer_line_under_cursor(number - 1);
+        viewport.set_active_buffer_line_under_cursor(m.count - 1);
     }
 }
 
-void ModalEditor::change_or_delete_till_or_find_to_character(const std::smatch &m) {
+void ModalEditor::change_or_delete_till_or_find_to_character(const KeymapMatch &m) {
 
-    std::string action = m[1].str(); // 'c' (change) or 'd' (delete), optional
-    std::string motion = m[2].str(); // 'f', 'F', 't', or 'T'
-    char character = m[3].str()[0];  // The character to search for
+    char action = m.capture(0);    // 'c' (change) or 'd' (delete), '\0' when left out
+    char motion = m.capture(1);    // 'f', 'F', 't', or 'T'
+    char character = m.capture(2); // The character to search for
 
     int col_idx = -1;
 
     // Handle motion commands
-    if (motion == "f") {
+    if (motion == 'f') {
         col_idx = viewport.buffer->find_rightward_index(viewport.active_buffer_line_under_cursor,
                                                         viewport.active_buffer_col_under_cursor, character);
-    } else if (motion == "F") {
+    } else if (motion == 'F') {
         col_idx = viewport.buffer->find_leftward_index(viewport.active_buffer_line_under_cursor,
                                                        viewport.active_buffer_col_under_cursor, character);
-    } else if (motion == "t") {
+    } else if (motion == 't') {
         col_idx = viewport.buffer->find_rightward_index_before(viewport.active_buffer_line_under_cursor,
                                                                viewport.active_buffer_col_under_cursor, character);
-    } else if (motion == "T") {
+    } else if (motion == 'T') {
         col_idx = viewport.buffer->find_leftward_index_before(viewport.active_buffer_line_under_cursor,
                                                               viewport.active_buffer_col_under_cursor, character);
     }
 
     // Apply action based on motion result
     if (col_idx != -1) {
-        if (!action.empty()) {
+        if (action != '\0') {
             // If action is 'c' or 'd', handle deletion and mode change
             viewport.buffer->delete_bounding_box(viewport.active_buffer_line_under_cursor,
                                                  viewport.active_buffer_col_under_cursor,
                                                  viewport.active_buffer_line_under_cursor, col_idx);
-            if (action == "c") {
+            if (action == 'c') {
                 current_mode = INSERT;
                 mode_change_signal.toggle_state();
             }
@@ -488,24 +490,24 @@ void ModalEditor::change_or_delete_till_or_find_to_character(const std::smatch &
             viewport.set_active_buffer_col_under_cursor(col_idx);
         }
     } else {
-        std::cout << "Character '" << character << "' not found for motion '" << motion << "'.\n";
+        LOG_DEBUG("Character '{}' not found for motion '{}'.", character, motion);
     }
 }
 
-void ModalEditor::change_or_delete_using_word_motion(const std::smatch &m) {
+void ModalEditor::change_or_delete_using_word_motion(const KeymapMatch &m) {
 
-    std::string command = m[1].str();
-    std::string motion = m[2].str();
+    char command = m.capture(0);
+    char motion = m.capture(1);
 
     // If no command is provided (meaning [cd] is missing), run these default motions
-    if (command.empty()) {
-        if (motion == "w") {
+    if (command == '\0') {
+        if (motion == 'w') {
             viewport.move_cursor_forward_by_word();
-        } else if (motion == "e") {
+        } else if (motion == 'e') {
             viewport.move_cursor_forward_until_end_of_word();
-        } else if (motion == "b") {
+        } else if (motion == 'b') {
             viewport.move_cursor_backward_by_word();
-        } else if (motion == "B") {
+        } else if (motion == 'B') {
             viewport.move_cursor_backward_until_start_of_word();
         }
         return;
@@ -513,19 +515,19 @@ void ModalEditor::change_or_delete_using_word_motion(const std::smatch &m) {
 
     // otherwise run the deletion stuff
     int col_idx = -1;
-    if (motion == "w") {
+    if (motion == 'w') {
         // minus one is used here to mimic default vim behavior and not to delet the first character of the next
         // word
         col_idx = viewport.buffer->find_forward_by_word_index(viewport.active_buffer_line_under_cursor,
                                                               viewport.active_buffer_col_under_cursor) -
                   1;
-    } else if (motion == "e") {
+    } else if (motion == 'e') {
         col_idx = viewport.buffer->find_forward_to_end_of_word(viewport.active_buffer_line_under_cursor,
                                                                viewport.active_buffer_col_under_cursor);
-    } else if (motion == "b") {
+    } else if (motion == 'b') {
         col_idx = viewport.buffer->find_backward_to_start_of_word(viewport.active_buffer_line_under_cursor,
                                                                   viewport.active_buffer_col_under_cursor);
-    } else if (motion == "B") {
+    } else if (motion == 'B') {
         col_idx = viewport.buffer->find_backward_by_word_index(viewport.active_buffer_line_under_cursor,
                                                                viewport.active_buffer_col_under_cursor);
     }
@@ -535,7 +537,7 @@ void ModalEditor::change_or_delete_using_word_motion(const std::smatch &m) {
         viewport.buffer->delete_bounding_box(viewport.active_buffer_line_under_cursor,
                                              viewport.active_buffer_col_under_cursor,
                                              viewport.active_buffer_line_under_cursor, col_idx);
-        if (command == "c") {
+        if (command == 'c') {
             current_mode = INSERT;
             insert_mode_signal.toggle_state();
             mode_change_signal.toggle_state();
@@ -543,23 +545,23 @@ void ModalEditor::change_or_delete_using_word_motion(const std::smatch &m) {
     }
 }
 
-void ModalEditor::change_or_delete_inside_or_around_brackets(const std::smatch &m) {
+void ModalEditor::change_or_delete_inside_or_around_brackets(const KeymapMatch &m) {
 
-    std::string command = m[1].str();
-    std::string inside_or_around = m[2].str();
-    std::string bracket_type = m[3].str();
+    char command = m.capture(0);
+    char inside_or_around = m.capture(1);
+    char bracket_type = m.capture(2);
 
     int left_match_col = -1;
     int right_match_col = -1;
 
-    if (bracket_type == "b") {
+    if (bracket_type == 'b') {
         left_match_col = viewport.buffer->find_column_index_of_previous_left_bracket(
             viewport.active_buffer_line_under_cursor, viewport.active_buffer_col_under_cursor);
         right_match_col = viewport.buffer->find_column_index_of_next_right_bracket(
             viewport.active_buffer_line_under_cursor, viewport.active_buffer_col_under_cursor);
     }
 
-    if (bracket_type == "B") {
+    if (bracket_type == 'B') {
         left_match_col = viewport.buffer->find_column_index_of_character_leftward(
             viewport.active_buffer_line_under_cursor, viewport.active_buffer_col_under_cursor, '{');
         right_match_col = viewport.buffer->find_column_index_of_next_character(
@@ -570,7 +572,7 @@ void ModalEditor::change_or_delete_inside_or_around_brackets(const std::smatch &
         return;
     }
 
-    if (inside_or_around == "i") {
+    if (inside_or_around == 'i') {
         left_match_col++;
         right_match_col--;
     }
@@ -580,11 +582,11 @@ void ModalEditor::change_or_delete_inside_or_around_brackets(const std::smatch &
     viewport.set_active_buffer_line_col_under_cursor(viewport.active_buffer_line_under_cursor, left_match_col);
 }
 
-void ModalEditor::open_new_line_below_or_above_current_line(const std::smatch &m) {
+void ModalEditor::open_new_line_below_or_above_current_line(const KeymapMatch &m) {
 
     // left control pressed then don't do this because of ctrl-o command
     if (not iks.is_pressed(InputKey::LEFT_CONTROL) and current_mode == MOVE_AND_EDIT) {
-        if (m.str() == "O") {
+        if (m.capture(0) == 'O') {
             // Create a new line above the cursor and scroll up
             auto td = viewport.create_new_line_above_cursor_and_scroll_up();
             if (td != EMPTY_TEXT_DIFF) {
@@ -598,9 +600,9 @@ void ModalEditor::open_new_line_below_or_above_current_line(const std::smatch &m
             }
         }
 
-        for (int i = 0; i < viewport.buffer->get_indentation_level(viewport.active_buffer_line_under_cursor,
-                                                                   viewport.active_buffer_col_under_cursor);
-             i++) {
+        int indentation_level = viewport.buffer->get_indentation_level(viewport.active_buffer_line_under_cursor,
+                                                                       viewport.active_buffer_col_under_cursor);
+        for (int i = 0; i < indentation_level; i++) {
             auto td = viewport.insert_tab_at_cursor();
             if (td != EMPTY_TEXT_DIFF) {
                 // lsp_client.make_did_change_request(viewport.buffer->current_file_path, td);
@@ -671,7 +673,7 @@ void ModalEditor::switch_to_hpp_source_file() {
     }
 }
 
-bool ModalEditor::run_non_regex_based_move_and_edit_commands() {
+bool ModalEditor::run_key_press_based_move_and_edit_commands() {
     bool key_pressed_based_command_run = false;
     std::function<bool(InputKey)> jp = [&](InputKey k) { return iks.is_just_pressed(k); };
     std::function<bool(InputKey)> ip = [&](InputKey k) { return iks.is_pressed(k); };
@@ -713,31 +715,18 @@ bool ModalEditor::run_non_regex_based_move_and_edit_commands() {
 
     if (jp(InputKey::LEFT_SHIFT)) {
         if (jp(InputKey::n)) {
-            // Check if there are any search results
-            if (!file_search_results.empty()) {
-                // Move to the previous search result, using forced positive modulo
-                current_file_search_index =
-                    (current_file_search_index - 1 + file_search_results.size()) % file_search_results.size();
-                TextRange sti = file_search_results[current_file_search_index];
-                viewport.set_active_buffer_line_col_under_cursor(sti.start_line, sti.start_col);
-
-            } else {
-                std::cout << "No search results found" << std::endl;
+            if (file_search_job.is_active()) {
+                pending_file_search_jump = SearchJob::Direction::BACKWARD;
+                jump_to_pending_file_search_match();
             }
             key_pressed_based_command_run = true;
         }
     } else {
         if (jp(InputKey::n)) {
-            std::cout << "next one" << std::endl;
-
-            if (!file_search_results.empty()) {
-                current_file_search_index = (current_file_search_index + 1) % file_search_results.size();
-                TextRange sti = file_search_results[current_file_search_index];
-                viewport.set_active_buffer_line_col_under_cursor(sti.start_line, sti.start_col);
-            } else {
-                std::cout << "No search results found" << std::endl;
+            if (file_search_job.is_active()) {
+                pending_file_search_jump = SearchJob::Direction::FORWARD;
+                jump_to_pending_file_search_match();
             }
-
             key_pressed_based_command_run = true;
         }
     }
@@ -772,6 +761,63 @@ bool ModalEditor::run_non_regex_based_move_and_edit_commands() {
     return key_pressed_based_command_run;
 }
 
+void ModalEditor::jump_to_pending_file_search_match() {
+    if (not pending_file_search_jump.has_value()) {
+        return;
+    }
+
+    auto match = file_search_job.find_closest_match(viewport.active_buffer_line_under_cursor,
+                                                    viewport.active_buffer_col_under_cursor, *pending_file_search_jump);
+    if (match.has_value()) {
+        viewport.set_active_buffer_line_col_under_cursor(match->line, match->start_col);
+        pending_file_search_jump.reset();
+    } else if (file_search_job.is_complete()) {
+        // there is nothing to jump to
+        pending_file_search_jump.reset();
+    }
+}
+
+bool ModalEditor::run_file_search_for(std::chrono::microseconds time_budget) {
+    if (not file_search_job.is_active()) {
+        return false;
+    }
+
+    // after an edit the old matches are in the wrong places, start over from where the cursor is now
+    if (file_search_job.is_stale(viewport.buffer.get())) {
+        file_search_job.start(*viewport.buffer, file_search_job.get_query(), viewport.active_buffer_line_under_cursor);
+    }
+
+    ScopedTraceSpan span("file search", "search");
+    ScopedAllocationTag allocation_tag(AllocationTag::SEARCH);
+    bool has_work_left = file_search_job.run_for(time_budget);
+    global_trace_recorder().record_counter("file search matches",
+                                           static_cast<double>(file_search_job.get_num_matches()));
+    jump_to_pending_file_search_match();
+    return has_work_left;
+}
+
+bool ModalEditor::update_file_saves() {
+    bool any_save_running = false;
+    for (const auto &buffer : viewport.active_file_buffers) {
+        if (buffer->update_save()) {
+            any_save_running = true;
+        }
+    }
+    return any_save_running;
+}
+
+void ModalEditor::submit_undo_journals() {
+    for (const auto &buffer : viewport.active_file_buffers) {
+        buffer->submit_undo_journal();
+    }
+}
+
+void ModalEditor::wait_for_file_saves() {
+    for (const auto &buffer : viewport.active_file_buffers) {
+        buffer->wait_until_saved();
+    }
+}
+
 bool ModalEditor::run_command_bar_command() {
     std::function<bool(InputKey)> jp = [&](InputKey k) { return iks.is_just_pressed(k); };
     std::function<bool(InputKey)> ip = [&](InputKey k) { return iks.is_pressed(k); };
@@ -795,29 +841,44 @@ bool ModalEditor::run_command_bar_command() {
             requested_quit = true;
         }
 
+        if (command_bar_input == ":perf") {
+            show_perf_overlay = not show_perf_overlay;
+            key_pressed_based_command_run = true;
+        }
+        if (command_bar_input == ":perf reset") {
+            global_perf_probes().reset();
+            key_pressed_based_command_run = true;
+        }
+
+        // :trace start, then :trace stop <file> writes out everything from in between as a chrome trace
+        if (command_bar_input == ":trace start") {
+            global_trace_recorder().start();
+            key_pressed_based_command_run = true;
+        }
+        if (command_bar_input.starts_with(":trace stop")) {
+            std::string trace_file_path = command_bar_input.substr(std::string(":trace stop").size());
+            trace_file_path.erase(0, trace_file_path.find_first_not_of(' '));
+            if (trace_file_path.empty()) {
+                trace_file_path = "trace.json";
+            }
+            if (global_trace_recorder().stop_and_write(trace_file_path)) {
+                LOG_INFO("wrote trace to {}", trace_file_path);
+            } else {
+                LOG_ERROR("Unable to write trace to {}", trace_file_path);
+            }
+            key_pressed_based_command_run = true;
+        }
+
         if (command_bar_input == ":tfs") {
             // window.toggle_fullscreen();
             key_pressed_based_command_run = true;
         }
         if (command_bar_input.front() == '/') {
             std::string search_request = command_bar_input.substr(1); // remove the "/"
-            file_search_results = viewport.buffer->find_forward_matches(
-                viewport.active_buffer_line_under_cursor, viewport.active_buffer_col_under_cursor, search_request);
-            if (!file_search_results.empty()) {
-                std::cout << "search active true now" << std::endl;
-                current_file_search_index = 0; // start from the first result
-
-                // Print out matches
-                std::cout << "Search Results for '" << search_request << "':\n";
-                for (const auto &result : file_search_results) {
-                    // Assuming SubTextIndex has `line` and `col` attributes for position
-                    std::cout << "Match at Line: " << result.start_line << ", Column: " << result.start_col << "\n";
-                    // If you want to print the actual text matched:
-                    /*std::cout << "Matched text: " << matched_text << "\n";*/
-                }
-                // You may want to highlight the first search result here
-                // highlight_search_result(search_results[current_search_index]);
-            }
+            // the matches get found over the next few frames, the cursor goes to the first one as soon as it shows up
+            file_search_job.start(*viewport.buffer, search_request, viewport.active_buffer_line_under_cursor);
+            pending_file_search_jump = SearchJob::Direction::FORWARD;
+            jump_to_pending_file_search_match();
         }
 
         command_bar_input = "";
@@ -828,37 +889,14 @@ bool ModalEditor::run_command_bar_command() {
     return key_pressed_based_command_run;
 }
 
-template <typename Iterable>
-std::vector<std::pair<std::string, double>> find_matching_files(const std::string &query, const Iterable &files,
-                                                                size_t result_limit, double filename_weight = 0.7) {
-    std::vector<std::pair<std::string, double>> results;
-
-    rapidfuzz::fuzz::CachedRatio<char> scorer(query);
-
-    for (const auto &file : files) {
-        std::string file_path = file.string();
-        std::string filename = std::filesystem::path(file_path).filename().string();
-
-        // Calculate similarity scores for both the full path and the filename
-        double path_score = scorer.similarity(file_path);
-        double filename_score = scorer.similarity(filename);
-
-        // Weighted combination of both scores
-        double combined_score = (1.0 - filename_weight) * path_score + filename_weight * filename_score;
-
-        results.emplace_back(file_path, combined_score);
-    }
-
-    std::sort(results.begin(), results.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
-
-    if (results.size() > result_limit) {
-        results.resize(result_limit);
-    }
+void ModalEditor::update_fuzzy_search_modal(const ProjectFileIndex &project_file_index) {
+    std::function<bool(InputKey)> jp = [&](InputKey k) { return iks.is_just_pressed(k); };
+    std::function<bool(InputKey)> ip = [&](InputKey k) { return iks.is_pressed(k); };
 
-    return results;
-}
+    // NOTE: this is whatever the index had when the key was pressed, files that show up later are picked up on the
+    // next key press
+    auto searchable_files = project_file_index.get_files();
 
-void update_fuzzy_search_modal(FuzzySearchModal &fuzzy_file_selection_modal) {
     bool query_was_updated = false;
 
     if (jp(InputKey::BACKSPACE)) {
@@ -881,30 +919,32 @@ void update_fuzzy_search_modal(FuzzySearchModal &fuzzy_file_selection_modal) {
             movement_input = true;
         }
 
-        fuzzy_file_selection_modal.current_selection_index %= std::min<size_t>(
-            fuzzy_file_selection_modal.max_num_results,
-            fuzzy_file_selection_modal.currently_matched_results.size()); // TODO use min of num matches
+        size_t num_selectable_results = std::min<size_t>(fuzzy_file_selection_modal.max_num_results,
+                                                         fuzzy_file_selection_modal.currently_matched_results.size());
+        if (num_selectable_results == 0) {
+            fuzzy_file_selection_modal.current_selection_index = 0;
+        } else {
+            fuzzy_file_selection_modal.current_selection_index %= num_selectable_results;
+        }
     }
 
-    if (not keys_just_pressed_this_tick.empty() and
-        not movement_input) { // if a movement input occurred we don't count that towards the query input
-
-        for (const auto &key : keys_just_pressed_this_tick) {
-            fuzzy_file_selection_modal.search_query += key;
+    if (not movement_input) { // if a movement input occurred we don't count that towards the query input
+        iks.for_each_character_just_pressed_this_tick([&](char character) {
+            fuzzy_file_selection_modal.search_query += character;
             query_was_updated = true;
-        }
+        });
+    }
 
-        if (query_was_updated) {
-            auto file_score_pairs = find_matching_files(fuzzy_file_selection_modal.search_query, searchable_files, 10);
-            std::vector<std::string> matched_files;
-            for (const auto &pair : file_score_pairs) {
-                matched_files.push_back(pair.first);
-            }
-            fuzzy_file_selection_modal.currently_matched_results = matched_files;
-        }
+    // NOTE: backspacing counts too, the matcher goes back to the candidates it remembered for the shorter query
+    if (query_was_updated) {
+        ScopedPerfProbe probe(PerfStage::FUZZY_FILE_MATCH);
+        fuzzy_file_selection_modal.currently_matched_results = fuzzy_file_matcher.find_best_matches(
+            fuzzy_file_selection_modal.search_query, searchable_files, fuzzy_file_selection_modal.max_num_results);
+        // the old selection may be past the end of the new results
+        fuzzy_file_selection_modal.current_selection_index = 0;
 
-        if (searchable_files.empty()) {
-            std::cout << "No files found in the search directory." << std::endl;
+        if (searchable_files->empty()) {
+            LOG_WARNING("No files found in the search directory.");
         } else {
 
             // update_graphical_search_results(fs_browser_search_query, searchable_files, fb,
@@ -917,14 +957,10 @@ void update_fuzzy_search_modal(FuzzySearchModal &fuzzy_file_selection_modal) {
     if (jp(InputKey::ENTER)) {
         if (fuzzy_file_selection_modal.currently_matched_results.size() != 0) {
 
-            std::cout << "about to load up: "
-                      << fuzzy_file_selection_modal
-                             .currently_matched_results[fuzzy_file_selection_modal.current_selection_index]
-                      << std::endl;
             std::string file_to_open =
                 fuzzy_file_selection_modal
                     .currently_matched_results[fuzzy_file_selection_modal.current_selection_index];
-            std::cout << "file_to_open: " << file_to_open << std::endl;
+            LOG_DEBUG("file_to_open: {}", file_to_open);
 
             switch_files(file_to_open, true);
 
@@ -936,38 +972,128 @@ void update_fuzzy_search_modal(FuzzySearchModal &fuzzy_file_selection_modal) {
     }
 
     if (jp(InputKey::CAPS_LOCK) or jp(InputKey::ESCAPE)) {
-        std::cout << "tried to turn off fb" << std::endl;
+        LOG_TRACE("tried to turn off fb");
         fuzzy_file_selection_modal.active = false;
         fuzzy_file_selection_modal.search_query = "";
         return;
     }
 }
 
-void ModalEditor::run_key_logic(std::vector<std::filesystem::path> &searchable_files) {
+void ModalEditor::queue_key_press(const std::vector<InputKey> &keys) {
+    InputEvent input_event;
+    for (InputKey key : keys) {
+        if (input_event.num_keys == InputEvent::MAX_KEYS) {
+            break;
+        }
+        input_event.keys[input_event.num_keys++] = key;
+    }
+    input_events.push(std::move(input_event));
+}
+
+void ModalEditor::queue_paste(std::string text) {
+    // terminals send the newlines of a paste as carriage returns, the buffer only knows about \n
+    std::string normalized_text;
+    normalized_text.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\r') {
+            normalized_text += text[i];
+        } else if (i + 1 == text.size() or text[i + 1] != '\n') {
+            normalized_text += '\n';
+        }
+    }
+
+    InputEvent input_event;
+    input_event.pasted_text = std::move(normalized_text);
+    input_events.push(std::move(input_event));
+}
+
+void ModalEditor::run_queued_input_events(const ProjectFileIndex &project_file_index) {
+    global_trace_recorder().record_counter("input queue depth", static_cast<double>(input_events.size()));
+    InputEvent input_event;
+    while (not requested_quit and input_events.pop(input_event)) {
+        global_perf_probes().record(PerfStage::INPUT_QUEUE_WAIT, input_events.get_stats().last_latency);
+        if (not input_event.pasted_text.empty()) {
+            paste_text(input_event.pasted_text, project_file_index);
+            TemporalBinarySignal::process_all();
+            continue;
+        }
+
+        // pastes aren't counted here, a key press is what's supposed to get by without allocating
+        ScopedAllocationSample allocation_sample(global_allocation_summaries().per_key_press);
+        ScopedAllocationTag allocation_tag(AllocationTag::INPUT);
+
+        // a terminal only reports presses, so every key of the event was just pressed and nothing else is down
+        iks.pressed.reset();
+        iks.pressed_at_end_of_last_tick.reset();
+        for (size_t i = 0; i < input_event.num_keys; ++i) {
+            iks.press(input_event.keys[i]);
+        }
+
+        run_key_logic(project_file_index);
+        TemporalBinarySignal::process_all();
+    }
+    iks.pressed.reset();
+}
+
+// a paste is text and not commands, so outside of insert mode it still goes in as text wherever text is being typed
+void ModalEditor::paste_text(const std::string &text, const ProjectFileIndex &project_file_index) {
+    // the modal and the command bar only take a single line
+    std::string_view first_line(text);
+    first_line = first_line.substr(0, first_line.find_first_of("\r\n"));
+
+    if (fuzzy_file_selection_modal.active) {
+        fuzzy_file_selection_modal.search_query += first_line;
+        ScopedPerfProbe probe(PerfStage::FUZZY_FILE_MATCH);
+        fuzzy_file_selection_modal.currently_matched_results = fuzzy_file_matcher.find_best_matches(
+            fuzzy_file_selection_modal.search_query, project_file_index.get_files(),
+            fuzzy_file_selection_modal.max_num_results);
+        return;
+    }
+
+    switch (current_mode) {
+    case MOVE_AND_EDIT:
+        // every key outside of insert mode is its own undo, so is a paste
+        viewport.buffer->begin_undo_group();
+        viewport.insert_string_at_cursor(text);
+        break;
+    case INSERT:
+        viewport.insert_string_at_cursor(text);
+        break;
+    case COMMAND:
+        command_bar_input += first_line;
+        command_bar_input_signal.toggle_state();
+        break;
+    case VISUAL_SELECT:
+        break;
+    }
+}
+
+void ModalEditor::run_key_logic(const ProjectFileIndex &project_file_index) {
+    ScopedPerfProbe probe(PerfStage::KEY_LOGIC);
+    ScopedTraceSpan span("key logic", "input");
 
     std::function<bool(InputKey)> jp = [&](InputKey k) { return iks.is_just_pressed(k); };
     std::function<bool(InputKey)> ip = [&](InputKey k) { return iks.is_pressed(k); };
 
-    // auto keys_just_pressed_this_tick = input_state.get_keys_just_pressed_this_tick();
-    auto keys_just_pressed_this_tick = iks.get_keys_just_pressed_this_tick();
-
     // assuming that no popups with input are active.
 
-    bool should_try_to_run_regex_command = false;
+    // every key outside of insert mode is undone on its own, the key that enters insert mode keeps its group open
+    // until insert mode is left, so a whole insert session (along with the o or O that started it) is one undo
+    if (current_mode != INSERT) {
+        viewport.buffer->begin_undo_group();
+    }
+
+    // the keys that go into the keymap this tick
+    std::string command_keys;
 
     // input switch [[
     switch (current_mode) {
     case MOVE_AND_EDIT:
-        should_try_to_run_regex_command = true;
-        for (const auto &key : keys_just_pressed_this_tick) {
-            potential_regex_command += key;
-        }
+        iks.for_each_character_just_pressed_this_tick([&](char character) { command_keys += character; });
         break;
     case INSERT:
-        for (const auto &key : keys_just_pressed_this_tick) {
-            char c = key[0]; // safely get the first (and only) character
-            viewport.insert_character_at_cursor(c);
-        }
+        iks.for_each_character_just_pressed_this_tick(
+            [&](char character) { viewport.insert_character_at_cursor(character); });
         if (jp(InputKey::ENTER)) {
             auto td = viewport.create_new_line_at_cursor_and_scroll_down();
             if (td != EMPTY_TEXT_DIFF) {
@@ -975,9 +1101,9 @@ void ModalEditor::run_key_logic(std::vector<std::filesystem::path> &searchable_f
             }
 
             // TODO: don't use a loop make it so you can pass in the indentation level instead
-            for (int i = 0; i < viewport.buffer->get_indentation_level(viewport.active_buffer_line_under_cursor,
-                                                                       viewport.active_buffer_col_under_cursor);
-                 i++) {
+            int indentation_level = viewport.buffer->get_indentation_level(viewport.active_buffer_line_under_cursor,
+                                                                           viewport.active_buffer_col_under_cursor);
+            for (int i = 0; i < indentation_level; i++) {
                 auto td = viewport.insert_tab_at_cursor();
                 if (td != EMPTY_TEXT_DIFF) {
                     // lsp_client.make_did_change_request(viewport.buffer->current_file_path, td);
@@ -991,22 +1117,14 @@ void ModalEditor::run_key_logic(std::vector<std::filesystem::path> &searchable_f
 
         break;
     case VISUAL_SELECT:
-        should_try_to_run_regex_command = true;
-        for (const auto &key : keys_just_pressed_this_tick) {
-            potential_regex_command += key;
-        }
+        iks.for_each_character_just_pressed_this_tick([&](char character) { command_keys += character; });
         break;
     case COMMAND:
-        for (const auto &key : keys_just_pressed_this_tick) {
-            command_bar_input += key;
-        }
+        iks.for_each_character_just_pressed_this_tick([&](char character) { command_bar_input += character; });
         break;
     }
     // input switch ]]
 
-    if (should_try_to_run_regex_command) {
-    }
-
     bool popup_is_active = fuzzy_file_selection_modal.active or open_buffers_selection_modal.active;
 
     // TODO: this should not be the outermost if statement
@@ -1015,19 +1133,24 @@ void ModalEditor::run_key_logic(std::vector<std::filesystem::path> &searchable_f
             // NOTE: if keys just pressed this tick is has length greater or equal to 2, then that implies two keys were
             // pressed ina single tick, should be rare enough to ignore, but note that it may be a cause for later bugs.
 
-            bool command_was_run = regex_command_runner.potentially_run_command(potential_regex_command);
-            if (command_was_run) {
-                potential_regex_command = "";
+            // NOTE: a command that enters insert mode gets the rest of the keys of this tick dropped, they were meant as
+            // commands and not as text
+            for (char key : command_keys) {
+                if (current_mode == INSERT) {
+                    break;
+                }
+                ScopedPerfProbe probe(PerfStage::KEYMAP_DISPATCH);
+                keymap.feed(key);
             }
 
             if (jp(InputKey::ESCAPE) or jp(InputKey::CAPS_LOCK)) {
-                potential_regex_command = "";
+                keymap.reset();
             }
 
-            // these should be moved into the regex stuff?
+            // these should be moved into the keymap?
             bool key_pressed_based_command_run = false;
             if (current_mode == MOVE_AND_EDIT) {
-                key_pressed_based_command_run = run_non_regex_based_move_and_edit_commands();
+                key_pressed_based_command_run = run_key_press_based_move_and_edit_commands();
             } else if (current_mode == COMMAND) {
                 if (jp(InputKey::ESCAPE) or jp(InputKey::CAPS_LOCK)) {
                     command_bar_input = "";
@@ -1041,12 +1164,13 @@ void ModalEditor::run_key_logic(std::vector<std::filesystem::path> &searchable_f
             }
 
             if (key_pressed_based_command_run) {
-                potential_regex_command = "";
+                keymap.reset();
             }
         }
     } else { // otherwise we are in the case that a popup is active
 
         if (fuzzy_file_selection_modal.active) {
+            update_fuzzy_search_modal(project_file_index);
         } else if (open_buffers_selection_modal.active) {
         }
     }
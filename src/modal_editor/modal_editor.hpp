@@ -1,12 +1,18 @@
 #ifndef MODAL_EDITOR_HPP
 #define MODAL_EDITOR_HPP
 
+#include <chrono>
 #include <filesystem>
+#include <optional>
 
 #include "../utility/hierarchical_history/hierarchical_history.hpp"
 #include "../utility/temporal_binary_signal/temporal_binary_signal.hpp"
 #include "../utility/text_diff/text_diff.hpp"
-#include "../utility/regex_command_runner/regex_command_runner.hpp"
+#include "../utility/keymap/keymap.hpp"
+#include "../utility/project_file_index/project_file_index.hpp"
+#include "../utility/fuzzy_file_matcher/fuzzy_file_matcher.hpp"
+#include "../utility/search_job/search_job.hpp"
+#include "../utility/input_event_queue/input_event_queue.hpp"
 #include "../graphics/viewport/viewport.hpp"
 
 // clang-format off
@@ -50,6 +56,7 @@ enum class InputKey {
 };
 
 #include <array>
+#include <bitset>
 
 constexpr std::array<InputKey, static_cast<size_t>(InputKey::DUMMY)> all_input_keys = {
     InputKey::a, InputKey::b, InputKey::c, InputKey::d, InputKey::e, InputKey::f,
@@ -95,73 +102,71 @@ constexpr std::array<InputKey, static_cast<size_t>(InputKey::DUMMY)> all_input_k
     InputKey::MIDDLE_MOUSE_BUTTON, InputKey::SCROLL_UP, InputKey::SCROLL_DOWN
 };
 
+// '\0' for keys that don't type a character
+char input_key_to_character(InputKey key, bool shift_pressed);
 std::string input_key_to_string(InputKey key, bool shift_pressed);
 
 // clang-format on
 
+// which keys are down, one bit per InputKey. Keys only ever get pressed during a tick (by the events that come in) and
+// the tick ends with process_input_state, a key was just pressed when its bit differs from the one at the end of the
+// last tick and it is down now, so nothing is stored per key other than the two bits and nothing is ever allocated.
 struct InputKeyState {
+    static constexpr size_t NUM_KEYS = static_cast<size_t>(InputKey::DUMMY);
+    using KeyBits = std::bitset<NUM_KEYS>;
 
-    std::unordered_map<InputKey, bool> input_key_to_is_pressed;
-    std::unordered_map<InputKey, bool> input_key_to_just_pressed;
-    std::unordered_map<InputKey, bool> input_key_to_is_pressed_prev;
+    KeyBits pressed;
+    KeyBits pressed_at_end_of_last_tick;
 
-    InputKeyState() {
-        for (InputKey key : all_input_keys) {
-            input_key_to_is_pressed[key] = false;
-            input_key_to_just_pressed[key] = false;
-            input_key_to_is_pressed_prev[key] = false;
-        }
-    }
+    static size_t bit_index(InputKey key) { return static_cast<size_t>(key); }
 
-    bool is_pressed(const InputKey &input_key) const { return input_key_to_is_pressed.at(input_key); }
-    bool is_just_pressed(const InputKey &input_key) const { return input_key_to_just_pressed.at(input_key); }
+    void press(InputKey key) { pressed.set(bit_index(key)); }
 
-    // NOTE: this doesn't make sense when more than one key is pressed this tick, I'm just going to make the bad
-    // assumption that that will not really occur too often, if it does then we'll have to fix this
-    std::vector<std::string> get_keys_just_pressed_this_tick() {
-        std::vector<std::string> result;
+    bool is_pressed(InputKey key) const { return pressed.test(bit_index(key)); }
+    bool is_just_pressed(InputKey key) const { return get_just_pressed().test(bit_index(key)); }
+    KeyBits get_just_pressed() const { return (pressed ^ pressed_at_end_of_last_tick) & pressed; }
+
+    // calls the function with the character of every key just pressed this tick that types one, in the order of the
+    // InputKey enum, every key press is its own tick (see ModalEditor::run_queued_input_events) so that's at most one
+    template <typename Function> void for_each_character_just_pressed_this_tick(Function &&function) const {
+        KeyBits just_pressed = get_just_pressed();
+        if (just_pressed.none()) {
+            return;
+        }
         bool shift_pressed = is_pressed(InputKey::LEFT_SHIFT) || is_pressed(InputKey::RIGHT_SHIFT);
 
-        for (const auto &[key, just_pressed] : input_key_to_just_pressed) {
-            if (!just_pressed)
+        for (size_t i = 0; i < NUM_KEYS; ++i) {
+            if (not just_pressed.test(i)) {
                 continue;
-
-            // Skip modifier keys
-            switch (key) {
-            case InputKey::ENTER:
-            case InputKey::LEFT_SHIFT:
-            case InputKey::RIGHT_SHIFT:
-            case InputKey::LEFT_CONTROL:
-            case InputKey::RIGHT_CONTROL:
-            case InputKey::LEFT_ALT:
-            case InputKey::RIGHT_ALT:
-            case InputKey::LEFT_SUPER:
-            case InputKey::RIGHT_SUPER:
+            }
+            // enter is handled on its own where it matters
+            auto key = static_cast<InputKey>(i);
+            if (key == InputKey::ENTER) {
                 continue;
-            default:
-                break;
             }
-
-            std::string str = input_key_to_string(key, shift_pressed);
-            if (!str.empty())
-                result.push_back(str);
+            // modifier keys (and everything else that doesn't type anything) map to no character
+            char character = input_key_to_character(key, shift_pressed);
+            if (character != '\0') {
+                function(character);
+            }
         }
-
-        return result;
     }
 
     void process_input_state() {
-        input_key_to_is_pressed_prev = input_key_to_is_pressed;
-        for (auto &[key, is_pressed] : input_key_to_is_pressed) {
-            is_pressed = false;
-        }
-
-        for (auto &[key, is_pressed] : input_key_to_just_pressed) {
-            is_pressed = false;
-        }
+        pressed_at_end_of_last_tick = pressed;
+        pressed.reset();
     }
 };
 
+// a single input event, a key along with the modifiers that were held down for it, or a whole paste
+struct InputEvent {
+    static constexpr size_t MAX_KEYS = 4;
+    std::array<InputKey, MAX_KEYS> keys{};
+    size_t num_keys = 0;
+    // the text of a bracketed paste, it goes into the buffer as it is instead of being typed one key at a time
+    std::string pasted_text;
+};
+
 enum EditorMode {
     MOVE_AND_EDIT,
     INSERT,
@@ -187,6 +192,13 @@ class ModalEditor {
     TemporalBinarySignal mode_change_signal;
     Viewport &viewport;
     InputKeyState iks = InputKeyState();
+    // key presses and pastes wait here until the next frame applies them
+    InputEventQueue<InputEvent> input_events;
+    void queue_key_press(const std::vector<InputKey> &keys);
+    void queue_paste(std::string text);
+    // runs the key logic once for every queued key press and applies every paste, in the order they came in, stops
+    // early when one of them quits
+    void run_queued_input_events(const ProjectFileIndex &project_file_index);
 
     ModalEditor(Viewport &viewport);
 
@@ -195,26 +207,28 @@ class ModalEditor {
     bool requested_quit = false;
 
     std::string command_bar_input;
+    // :perf shows how long each stage between a key press and the frame takes
+    bool show_perf_overlay = false;
     TemporalBinarySignal command_bar_input_signal;
     TemporalBinarySignal insert_mode_signal;
 
     int buffer_line_where_selection_mode_started = -1;
     int buffer_col_where_selection_mode_started = -1;
 
-    // regex command runner [[
-    RegexCommandRunner regex_command_runner;
-    bool regex_command_runner_has_been_configured = false;
-    std::string potential_regex_command = "";
-    // regex command runner ]]
+    // keymap [[
+    // every command typed outside of insert mode, the keys go in one at a time as they are pressed
+    Keymap keymap;
+    // keymap ]]
 
     // searching within file [[
-    std::vector<TextRange> file_search_results;
-    int current_file_search_index = 0; // to keep track of the current search result
-    bool file_search_is_active = false;
+    SearchJob file_search_job;
+    // n or N was pressed (or a search was just started) but the match to jump to hasn't been found yet
+    std::optional<SearchJob::Direction> pending_file_search_jump;
     // searching within file ]]
 
     FuzzySearchModal fuzzy_file_selection_modal;
     FuzzySearchModal open_buffers_selection_modal;
+    FuzzyFileMatcher fuzzy_file_matcher;
 
     // actual logic here
     void switch_files(const std::string &file_to_open, bool store_movements_to_history);
@@ -222,19 +236,20 @@ class ModalEditor {
 
     void delete_at_current_cursor_position_logic();
     void delete_line_current_cursor_position();
-    void paste_at_cursor_position_logic(const std::smatch &m);
+    void paste_at_cursor_position_logic(const KeymapMatch &m);
     void start_visual_selection();
     void enter_insert_mode();
     void enter_insert_mode_after_cursor_position();
     void enter_insert_mode_at_end_of_line();
     void enter_insert_mode_in_front_of_first_non_whitespace_character_on_active_line();
     void move_cursor_to_first_non_whitespace_character_on_active_line();
-    void handle_hjkl_with_number_modifier(const std::smatch &m);
-    void go_to_specific_line_number(const std::smatch &m);
-    void change_or_delete_till_or_find_to_character(const std::smatch &m);
-    void change_or_delete_using_word_motion(const std::smatch &m);
-    void change_or_delete_inside_or_around_brackets(const std::smatch &m);
-    void open_new_line_below_or_above_current_line(const std::smatch &m);
+    void handle_hjkl_with_number_modifier(const KeymapMatch &m);
+    void go_to_specific_line_number(const KeymapMatch &m);
+    void change_or_delete_till_or_find_to_character(const KeymapMatch &m);
+    void change_or_delete_using_word_motion(const KeymapMatch &m);
+    void change_or_delete_inside_or_around_brackets(const KeymapMatch &m);
+    void open_new_line_below_or_above_current_line(const KeymapMatch &m);
+    void paste_text(const std::string &text, const ProjectFileIndex &project_file_index);
     void undo();
     void redo();
     void launch_search_files();
@@ -243,8 +258,17 @@ class ModalEditor {
     void switch_to_hpp_source_file();
 
     bool run_command_bar_command();
-    bool run_non_regex_based_move_and_edit_commands();
-    void run_key_logic(std::vector<std::filesystem::path> &searchable_files);
+    bool run_key_press_based_move_and_edit_commands();
+    void update_fuzzy_search_modal(const ProjectFileIndex &project_file_index);
+    void jump_to_pending_file_search_match();
+    // gives the search its share of the frame, returns true if it needs another frame to get further
+    bool run_file_search_for(std::chrono::microseconds time_budget);
+    // saves run in the background, this finishes the ones that are done, returns true while any is still running
+    bool update_file_saves();
+    void wait_for_file_saves();
+    // the undo journals get the edits of a whole frame at once, see LineTextBuffer::submit_undo_journal
+    void submit_undo_journals();
+    void run_key_logic(const ProjectFileIndex &project_file_index);
 };
 
 #endif // MODAL_EDITOR_HPP
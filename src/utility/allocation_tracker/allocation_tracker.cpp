@@ -0,0 +1,158 @@
+#include "allocation_tracker.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+const char *allocation_tag_to_string(AllocationTag tag) {
+    switch (tag) {
+    case AllocationTag::UNTAGGED:
+        return "untagged";
+    case AllocationTag::RENDER:
+        return "render";
+    case AllocationTag::INPUT:
+        return "input";
+    case AllocationTag::BUFFER:
+        return "buffer";
+    case AllocationTag::SEARCH:
+        return "search";
+    case AllocationTag::HISTORY:
+        return "history";
+    case AllocationTag::DUMMY:
+        break;
+    }
+    return "";
+}
+
+static constexpr size_t NUM_TAGS = static_cast<size_t>(AllocationTag::DUMMY);
+
+// NOTE: everything here is touched from inside operator new, so none of it may allocate or need to be constructed at
+// runtime (a thread_local with a constructor would run it from inside the first allocation of every thread)
+struct AtomicAllocationCounts {
+    std::atomic<size_t> num_allocations{0};
+    std::atomic<size_t> num_bytes{0};
+    std::atomic<size_t> num_frees{0};
+};
+static std::array<AtomicAllocationCounts, NUM_TAGS> counts_per_tag;
+static thread_local AllocationCounts current_thread_counts;
+
+AllocationCounts get_allocation_counts(AllocationTag tag) {
+    const AtomicAllocationCounts &counts = counts_per_tag[static_cast<size_t>(tag)];
+    return {counts.num_allocations.load(std::memory_order_relaxed), counts.num_bytes.load(std::memory_order_relaxed),
+            counts.num_frees.load(std::memory_order_relaxed)};
+}
+
+AllocationCounts get_current_thread_allocation_counts() { return current_thread_counts; }
+
+void AllocationSummary::add_sample(const AllocationCounts &counts) {
+    ++num_samples;
+    if (counts.num_allocations == 0) {
+        ++num_samples_without_allocations;
+    }
+    last = counts;
+    total.num_allocations += counts.num_allocations;
+    total.num_bytes += counts.num_bytes;
+    total.num_frees += counts.num_frees;
+    max_num_allocations = std::max(max_num_allocations, counts.num_allocations);
+    max_num_bytes = std::max(max_num_bytes, counts.num_bytes);
+}
+
+double AllocationSummary::get_average_num_allocations() const {
+    return num_samples == 0 ? 0.0 : static_cast<double>(total.num_allocations) / static_cast<double>(num_samples);
+}
+
+double AllocationSummary::get_average_num_bytes() const {
+    return num_samples == 0 ? 0.0 : static_cast<double>(total.num_bytes) / static_cast<double>(num_samples);
+}
+
+AllocationSummaries &global_allocation_summaries() {
+    static AllocationSummaries allocation_summaries;
+    return allocation_summaries;
+}
+
+#ifdef TRACK_ALLOCATIONS
+
+static thread_local AllocationTag current_tag = AllocationTag::UNTAGGED;
+
+ScopedAllocationTag::ScopedAllocationTag(AllocationTag tag) : previous_tag(current_tag) { current_tag = tag; }
+
+ScopedAllocationTag::~ScopedAllocationTag() { current_tag = previous_tag; }
+
+static void count_allocation(size_t num_bytes) {
+    AtomicAllocationCounts &counts = counts_per_tag[static_cast<size_t>(current_tag)];
+    counts.num_allocations.fetch_add(1, std::memory_order_relaxed);
+    counts.num_bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+    ++current_thread_counts.num_allocations;
+    current_thread_counts.num_bytes += num_bytes;
+}
+
+static void count_free() {
+    counts_per_tag[static_cast<size_t>(current_tag)].num_frees.fetch_add(1, std::memory_order_relaxed);
+    ++current_thread_counts.num_frees;
+}
+
+static void *allocate(size_t num_bytes) {
+    // malloc(0) is allowed to return nullptr, new never is
+    void *pointer = std::malloc(std::max<size_t>(num_bytes, 1));
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    count_allocation(num_bytes);
+    return pointer;
+}
+
+static void *allocate_aligned(size_t num_bytes, std::align_val_t alignment) {
+    size_t alignment_bytes = static_cast<size_t>(alignment);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size_t rounded_num_bytes =
+        (std::max<size_t>(num_bytes, 1) + alignment_bytes - 1) / alignment_bytes * alignment_bytes;
+#if defined(_WIN32) || defined(_WIN64)
+    void *pointer = _aligned_malloc(rounded_num_bytes, alignment_bytes);
+#else
+    void *pointer = std::aligned_alloc(alignment_bytes, rounded_num_bytes);
+#endif
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    count_allocation(num_bytes);
+    return pointer;
+}
+
+static void deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    count_free();
+    std::free(pointer);
+}
+
+static void deallocate_aligned(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    count_free();
+#if defined(_WIN32) || defined(_WIN64)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+// the array and nothrow versions of the standard ones call these, so they are counted as well
+void *operator new(size_t num_bytes) { return allocate(num_bytes); }
+void *operator new[](size_t num_bytes) { return allocate(num_bytes); }
+void *operator new(size_t num_bytes, std::align_val_t alignment) { return allocate_aligned(num_bytes, alignment); }
+void *operator new[](size_t num_bytes, std::align_val_t alignment) { return allocate_aligned(num_bytes, alignment); }
+
+void operator delete(void *pointer) noexcept { deallocate(pointer); }
+void operator delete[](void *pointer) noexcept { deallocate(pointer); }
+void operator delete(void *pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { deallocate_aligned(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { deallocate_aligned(pointer); }
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { deallocate_aligned(pointer); }
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept { deallocate_aligned(pointer); }
+
+#endif
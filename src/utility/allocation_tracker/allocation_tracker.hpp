@@ -0,0 +1,109 @@
+#ifndef ALLOCATION_TRACKER_HPP
+#define ALLOCATION_TRACKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// counts every allocation when the editor is built with -DTRACK_ALLOCATIONS=ON (cmake), the global operator new and
+// delete get replaced by ones that count what goes through them. Without it nothing is replaced, the counts all stay
+// at zero and the tags below compile down to nothing.
+#ifdef TRACK_ALLOCATIONS
+constexpr bool ALLOCATION_TRACKING_ENABLED = true;
+#else
+constexpr bool ALLOCATION_TRACKING_ENABLED = false;
+#endif
+
+// the part of the editor an allocation is charged to, whatever tag is innermost on the allocating thread wins
+enum class AllocationTag : uint8_t {
+    UNTAGGED,
+    RENDER,
+    INPUT,
+    BUFFER,
+    SEARCH,
+    HISTORY,
+
+    DUMMY
+};
+
+const char *allocation_tag_to_string(AllocationTag tag);
+
+struct AllocationCounts {
+    size_t num_allocations = 0;
+    size_t num_bytes = 0;
+    size_t num_frees = 0;
+
+    AllocationCounts operator-(const AllocationCounts &other) const {
+        return {num_allocations - other.num_allocations, num_bytes - other.num_bytes, num_frees - other.num_frees};
+    }
+};
+
+// everything charged to the tag since the start, over all threads
+AllocationCounts get_allocation_counts(AllocationTag tag);
+// everything the calling thread allocated since it started, take the difference of two of these to measure a stretch
+// of code
+AllocationCounts get_current_thread_allocation_counts();
+
+// how much got allocated in each of a series of stretches of code (every key press, every frame)
+struct AllocationSummary {
+    size_t num_samples = 0;
+    // samples that didn't allocate anything at all, the goal for a key press is that this is all of them
+    size_t num_samples_without_allocations = 0;
+    AllocationCounts last;
+    AllocationCounts total;
+    size_t max_num_allocations = 0;
+    size_t max_num_bytes = 0;
+
+    void add_sample(const AllocationCounts &counts);
+    double get_average_num_allocations() const;
+    double get_average_num_bytes() const;
+};
+
+struct AllocationSummaries {
+    AllocationSummary per_key_press;
+    AllocationSummary per_frame;
+};
+
+// NOTE: not thread safe, the samples are taken on the ui thread
+AllocationSummaries &global_allocation_summaries();
+
+// charges the allocations the calling thread makes while this is alive to the tag
+class ScopedAllocationTag {
+  public:
+#ifdef TRACK_ALLOCATIONS
+    explicit ScopedAllocationTag(AllocationTag tag);
+    ~ScopedAllocationTag();
+
+  private:
+    AllocationTag previous_tag;
+#else
+    explicit ScopedAllocationTag(AllocationTag) {}
+#endif
+
+  public:
+    ScopedAllocationTag(const ScopedAllocationTag &) = delete;
+    ScopedAllocationTag &operator=(const ScopedAllocationTag &) = delete;
+};
+
+// adds what the calling thread allocated while this was alive as a sample to the summary
+class ScopedAllocationSample {
+  public:
+    explicit ScopedAllocationSample(AllocationSummary &summary) : summary(summary) {
+        if constexpr (ALLOCATION_TRACKING_ENABLED) {
+            start = get_current_thread_allocation_counts();
+        }
+    }
+    ~ScopedAllocationSample() {
+        if constexpr (ALLOCATION_TRACKING_ENABLED) {
+            summary.add_sample(get_current_thread_allocation_counts() - start);
+        }
+    }
+
+    ScopedAllocationSample(const ScopedAllocationSample &) = delete;
+    ScopedAllocationSample &operator=(const ScopedAllocationSample &) = delete;
+
+  private:
+    AllocationSummary &summary;
+    AllocationCounts start;
+};
+
+#endif // ALLOCATION_TRACKER_HPP
@@ -0,0 +1,80 @@
+#include "bracket_depth_index.hpp"
+
+BracketBalance BracketBalance::of_text(std::string_view text) {
+    int depth = 0;
+    int lowest_depth = 0;
+    for (char c : text) {
+        if (c == '{') {
+            ++depth;
+        } else if (c == '}') {
+            --depth;
+            lowest_depth = std::min(lowest_depth, depth);
+        }
+    }
+    // whatever the depth going in was, the closing brackets that went below it were ignored
+    return {depth, depth - lowest_depth};
+}
+
+void BracketDepthIndex::clear() { tree.clear(); }
+
+void BracketDepthIndex::assign(const std::vector<BracketBalance> &line_balances) { tree.assign(line_balances); }
+
+int BracketDepthIndex::line_count() const { return tree.line_count(); }
+
+int BracketDepthIndex::get_depth_before_line(int line_index) const {
+    int depth = 0;
+    const auto *node = &tree.get_root();
+    while (not node->is_leaf) {
+        const CowBTree<BracketDepthIndexTraits>::Node *next_node = nullptr;
+        for (const auto &child : node->children) {
+            if (line_index < child->summary.line_count) {
+                next_node = child.get();
+                break;
+            }
+            depth = child->summary.balance.apply(depth);
+            line_index -= child->summary.line_count;
+        }
+        // past the last line, every child has been applied already
+        if (next_node == nullptr) {
+            return depth;
+        }
+        node = next_node;
+    }
+
+    for (int i = 0; i < line_index and i < static_cast<int>(node->entries.size()); ++i) {
+        depth = node->entries[i].apply(depth);
+    }
+    return depth;
+}
+
+void BracketDepthIndex::insert_line(int line_index, const BracketBalance &balance) {
+    if (line_index < 0 or line_index > line_count()) {
+        return;
+    }
+    tree.splice(line_index, false, &balance);
+}
+
+void BracketDepthIndex::erase_line(int line_index) {
+    if (line_index < 0 or line_index >= line_count()) {
+        return;
+    }
+    tree.splice(line_index, true, nullptr);
+}
+
+void BracketDepthIndex::replace_line(int line_index, const BracketBalance &balance) {
+    if (line_index < 0 or line_index >= line_count()) {
+        return;
+    }
+    tree.splice(line_index, true, &balance);
+}
+
+void BracketDepthIndexTraits::splice_leaf(std::vector<BracketBalance> &line_balances, int line_index, bool erase,
+                                          const BracketBalance *balance_to_insert) {
+    auto position = line_balances.begin() + line_index;
+    if (erase) {
+        position = line_balances.erase(position);
+    }
+    if (balance_to_insert != nullptr) {
+        line_balances.insert(position, *balance_to_insert);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef BRACKET_DEPTH_INDEX_HPP
+#define BRACKET_DEPTH_INDEX_HPP
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "../cow_btree/cow_btree.hpp"
+
+// what a stretch of text does to the curly bracket depth. A closing bracket with nothing open is ignored, so the depth
+// never goes below zero, that makes the effect of the text on a depth d
+//
+//     max(d + net, floor)
+//
+// where net is how many more brackets are opened than closed and floor is the lowest depth that can come out of it.
+// Two stretches back to back have an effect of the same shape, which is what lets the index below cache the effect of
+// whole subtrees
+struct BracketBalance {
+    int net = 0;
+    int floor = 0;
+
+    static BracketBalance of_text(std::string_view text);
+
+    int apply(int depth) const { return std::max(depth + net, floor); }
+    // the effect of this stretch followed by the next one
+    BracketBalance then(const BracketBalance &next) const {
+        return {net + next.net, std::max(floor + next.net, next.floor)};
+    }
+};
+
+// one entry per line, every node caches how many lines are below it and their combined balance
+struct BracketDepthIndexTraits {
+    using Entry = BracketBalance;
+    struct Summary {
+        int line_count = 0;
+        BracketBalance balance;
+    };
+
+    static Summary summarize(const BracketBalance &balance) { return {1, balance}; }
+    static Summary combine(const Summary &a, const Summary &b) {
+        return {a.line_count + b.line_count, a.balance.then(b.balance)};
+    }
+    static void splice_leaf(std::vector<BracketBalance> &line_balances, int line_index, bool erase,
+                            const BracketBalance *balance_to_insert);
+};
+
+// the bracket balance of every line of a buffer in a balanced tree (the same CowBTree as the line rope), the depth at
+// the start of any line is found in O(log n) by walking down from the root, and changing a line only recomputes the
+// nodes on its root to leaf path
+class BracketDepthIndex {
+  public:
+    int line_count() const;
+    // the depth at the start of the line, line_count() gives the depth after the last line
+    int get_depth_before_line(int line_index) const;
+
+    void clear();
+    // replaces everything with these lines, building the tree bottom up is a lot faster than inserting them one by one
+    void assign(const std::vector<BracketBalance> &line_balances);
+    void insert_line(int line_index, const BracketBalance &balance);
+    void erase_line(int line_index);
+    void replace_line(int line_index, const BracketBalance &balance);
+
+  private:
+    CowBTree<BracketDepthIndexTraits> tree;
+};
+
+#endif // BRACKET_DEPTH_INDEX_HPP
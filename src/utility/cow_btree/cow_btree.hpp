@@ -0,0 +1,255 @@
+#ifndef COW_BTREE_HPP
+#define COW_BTREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// the balanced tree (b-tree) underneath the line rope and the bracket depth index. Leaves hold entries and every node
+// caches a summary of the entries below it, the summary always has a line_count which is what positions in the tree
+// are measured in, so going from a line to the leaf holding it is O(log n) by walking down from the root, and
+// splicing a line in or out only touches the nodes on a single root to leaf path.
+//
+// copying a tree is O(1), the copies share their nodes and a node is only copied when one of them is about to change
+// it while the other still uses it (so an edit copies at most one root to leaf path). A copy can be read from another
+// thread while the original keeps getting modified, as long as each tree itself is only used by one thread.
+//
+// what an entry is and how a leaf changes is up to the traits:
+//
+//     using Entry = ...;
+//     struct Summary { int line_count = 0; ... };
+//     static Summary summarize(const Entry &entry);
+//     // the summary of a followed by b
+//     static Summary combine(const Summary &a, const Summary &b);
+//     // erases the line at line_index (if erase is set) and then inserts the entry at line_index (if there is one)
+//     static void splice_leaf(std::vector<Entry> &entries, int line_index, bool erase, const Entry *entry_to_insert);
+template <typename Traits> class CowBTree {
+  public:
+    using Entry = typename Traits::Entry;
+    using Summary = typename Traits::Summary;
+
+    struct Node {
+        bool is_leaf = true;
+        Summary summary;
+        std::vector<Entry> entries;                  // only used by leaves
+        std::vector<std::shared_ptr<Node>> children; // only used by internal nodes
+
+        size_t num_entries() const { return is_leaf ? entries.size() : children.size(); }
+    };
+
+    CowBTree() { clear(); }
+
+    void clear() { root = std::make_shared<Node>(); }
+
+    // replaces everything with these entries, building the tree bottom up is a lot faster than inserting them one at
+    // a time
+    void assign(const std::vector<Entry> &entries) {
+        clear();
+        if (entries.empty()) {
+            return;
+        }
+
+        // nodes are filled half way so that the first edits into them don't immediately split them
+        constexpr size_t ENTRIES_PER_BUILT_NODE = MAX_ENTRIES_PER_NODE / 2;
+
+        std::vector<std::shared_ptr<Node>> level;
+        for (size_t start = 0; start < entries.size(); start += ENTRIES_PER_BUILT_NODE) {
+            auto leaf = std::make_shared<Node>();
+            size_t end = std::min(start + ENTRIES_PER_BUILT_NODE, entries.size());
+            leaf->entries.assign(entries.begin() + start, entries.begin() + end);
+            recompute_summary(*leaf);
+            level.push_back(std::move(leaf));
+        }
+
+        while (level.size() > 1) {
+            std::vector<std::shared_ptr<Node>> parent_level;
+            for (size_t start = 0; start < level.size(); start += ENTRIES_PER_BUILT_NODE) {
+                auto parent = std::make_shared<Node>();
+                parent->is_leaf = false;
+                size_t end = std::min(start + ENTRIES_PER_BUILT_NODE, level.size());
+                for (size_t i = start; i < end; ++i) {
+                    parent->children.push_back(std::move(level[i]));
+                }
+                recompute_summary(*parent);
+                parent_level.push_back(std::move(parent));
+            }
+            level = std::move(parent_level);
+        }
+
+        root = std::move(level.front());
+    }
+
+    int line_count() const { return root->summary.line_count; }
+    const Node &get_root() const { return *root; }
+
+    // see Traits::splice_leaf, the line must be in bounds (or one past the end for a pure insertion)
+    void splice(int line_index, bool erase, const Entry *entry_to_insert) {
+        adopt_root_split(splice(make_unshared(root), line_index, erase, entry_to_insert));
+    }
+
+    // calls the function on every entry in document order
+    template <typename Function> void for_each_entry(Function &&function) const {
+        for_each_entry_in_node(*root, function);
+    }
+
+  private:
+    // how many entries a leaf or how many children an internal node may hold before it gets split in two, and how few
+    // it may hold before we try to merge it into a neighbour
+    static constexpr size_t MAX_ENTRIES_PER_NODE = 32;
+    static constexpr size_t MIN_ENTRIES_PER_NODE = MAX_ENTRIES_PER_NODE / 4;
+
+    std::shared_ptr<Node> root;
+
+    // copies the node if another tree still uses it, every modification goes through here from the root down, so a
+    // node that is only pointed at by an unshared parent is never shared itself
+    static Node &make_unshared(std::shared_ptr<Node> &node) {
+        if (node.use_count() > 1) {
+            // the copy shares the children, they get the same treatment once the modification reaches them
+            node = std::make_shared<Node>(*node);
+        } else {
+            // the last other owner may have just let go on another thread, what it read has to be done before we write
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *node;
+    }
+
+    // grows the tree by one level when the root was split, and shrinks it while the root only has a single child
+    void adopt_root_split(std::shared_ptr<Node> split) {
+        if (split) {
+            auto new_root = std::make_shared<Node>();
+            new_root->is_leaf = false;
+            new_root->children.push_back(std::move(root));
+            new_root->children.push_back(std::move(split));
+            recompute_summary(*new_root);
+            root = std::move(new_root);
+        }
+
+        while (not root->is_leaf and root->children.size() == 1) {
+            // NOTE: a copy of the pointer, the old root could be shared in which case it must stay as it is
+            root = std::shared_ptr<Node>(root->children.front());
+        }
+
+        if (not root->is_leaf and root->children.empty()) {
+            clear();
+        }
+    }
+
+    // when the node overflows because of the splice it gets split and the new right half is returned so that the
+    // parent can adopt it
+    static std::shared_ptr<Node> splice(Node &node, int line_index, bool erase, const Entry *entry_to_insert) {
+        if (node.is_leaf) {
+            Traits::splice_leaf(node.entries, line_index, erase, entry_to_insert);
+            recompute_summary(node);
+            return split_if_overfull(node);
+        }
+
+        size_t child_index = 0;
+        for (; child_index < node.children.size(); ++child_index) {
+            int child_line_count = node.children[child_index]->summary.line_count;
+            // NOTE: a pure insertion right at the end of a child goes into that child rather than the start of the next
+            // one so that the leaf can merge it with the entry in front of it
+            bool line_is_in_child = line_index < child_line_count or (not erase and line_index == child_line_count);
+            if (line_is_in_child or child_index + 1 == node.children.size()) {
+                break;
+            }
+            line_index -= child_line_count;
+        }
+
+        auto split = splice(make_unshared(node.children[child_index]), line_index, erase, entry_to_insert);
+        if (split) {
+            node.children.insert(node.children.begin() + child_index + 1, std::move(split));
+        }
+
+        if (node.children[child_index]->num_entries() == 0) {
+            node.children.erase(node.children.begin() + child_index);
+        } else {
+            merge_underfull_child(node, child_index);
+        }
+
+        recompute_summary(node);
+        return split_if_overfull(node);
+    }
+
+    static std::shared_ptr<Node> split_if_overfull(Node &node) {
+        if (node.num_entries() <= MAX_ENTRIES_PER_NODE) {
+            return nullptr;
+        }
+
+        auto right = std::make_shared<Node>();
+        right->is_leaf = node.is_leaf;
+
+        size_t half = node.num_entries() / 2;
+        if (node.is_leaf) {
+            right->entries.assign(node.entries.begin() + half, node.entries.end());
+            node.entries.resize(half);
+        } else {
+            right->children.assign(std::make_move_iterator(node.children.begin() + half),
+                                   std::make_move_iterator(node.children.end()));
+            node.children.resize(half);
+        }
+
+        recompute_summary(node);
+        recompute_summary(*right);
+        return right;
+    }
+
+    // folds a child that has become very small into one of its neighbours, as long as the result still fits in a node
+    static void merge_underfull_child(Node &parent, size_t child_index) {
+        if (parent.children[child_index]->num_entries() >= MIN_ENTRIES_PER_NODE) {
+            return;
+        }
+
+        size_t left_index;
+        if (child_index + 1 < parent.children.size()) {
+            left_index = child_index;
+        } else if (child_index > 0) {
+            left_index = child_index - 1;
+        } else {
+            return;
+        }
+
+        if (parent.children[left_index]->num_entries() + parent.children[left_index + 1]->num_entries() >
+            MAX_ENTRIES_PER_NODE) {
+            return;
+        }
+
+        // the right node is only read (it could still be shared), its entries are copied over rather than moved
+        Node &left = make_unshared(parent.children[left_index]);
+        const Node &right = *parent.children[left_index + 1];
+        if (left.is_leaf) {
+            left.entries.insert(left.entries.end(), right.entries.begin(), right.entries.end());
+        } else {
+            left.children.insert(left.children.end(), right.children.begin(), right.children.end());
+        }
+        recompute_summary(left);
+        parent.children.erase(parent.children.begin() + left_index + 1);
+    }
+
+    static void recompute_summary(Node &node) {
+        node.summary = {};
+        if (node.is_leaf) {
+            for (const auto &entry : node.entries) {
+                node.summary = Traits::combine(node.summary, Traits::summarize(entry));
+            }
+        } else {
+            for (const auto &child : node.children) {
+                node.summary = Traits::combine(node.summary, child->summary);
+            }
+        }
+    }
+
+    template <typename Function> static void for_each_entry_in_node(const Node &node, Function &function) {
+        if (node.is_leaf) {
+            for (const auto &entry : node.entries) {
+                function(entry);
+            }
+        } else {
+            for (const auto &child : node.children) {
+                for_each_entry_in_node(*child, function);
+            }
+        }
+    }
+};
+
+#endif // COW_BTREE_HPP
@@ -0,0 +1,86 @@
+#include "frame_scheduler.hpp"
+
+#include <algorithm>
+
+FrameScheduler::FrameScheduler(std::function<void()> post_frame, std::chrono::milliseconds min_frame_interval)
+    : post_frame(std::move(post_frame)), min_frame_interval(min_frame_interval) {
+    scheduler_thread = std::thread([this] { run(); });
+}
+
+FrameScheduler::~FrameScheduler() { stop(); }
+
+void FrameScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    wake_up.notify_one();
+    if (scheduler_thread.joinable()) {
+        scheduler_thread.join();
+    }
+}
+
+// a request waits out one frame interval before it gets posted, anything else that shows up in the meantime rides
+// along with it
+void FrameScheduler::request_frame() {
+    auto now = Clock::now();
+    add_request(now + min_frame_interval, now);
+}
+
+void FrameScheduler::request_frame_at(Clock::time_point time) { add_request(time, time); }
+
+void FrameScheduler::add_request(Clock::time_point due_time, Clock::time_point needed_after) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending_frame_due_time) {
+            ++stats.requests_merged;
+            pending_frame_due_time = std::min(*pending_frame_due_time, due_time);
+            pending_frame_needed_after = std::min(pending_frame_needed_after, needed_after);
+        } else {
+            pending_frame_due_time = due_time;
+            pending_frame_needed_after = needed_after;
+        }
+    }
+    wake_up.notify_one();
+}
+
+void FrameScheduler::notify_frame_rendered() {
+    std::lock_guard<std::mutex> lock(mutex);
+    last_render_time = Clock::now();
+    ++stats.frames_rendered;
+}
+
+FrameScheduler::Stats FrameScheduler::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void FrameScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (not stop_requested) {
+        if (not pending_frame_due_time) {
+            // nothing to do, sleep until someone asks for a frame
+            wake_up.wait(lock);
+            continue;
+        }
+
+        if (Clock::now() < *pending_frame_due_time) {
+            // a new request or stop can wake us early, in that case everything gets looked at again
+            wake_up.wait_until(lock, *pending_frame_due_time);
+            continue;
+        }
+
+        bool already_drawn = last_render_time >= pending_frame_needed_after;
+        pending_frame_due_time.reset();
+
+        if (already_drawn) {
+            ++stats.frames_skipped;
+            continue;
+        }
+
+        ++stats.frames_posted;
+        lock.unlock();
+        post_frame();
+        lock.lock();
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef FRAME_SCHEDULER_HPP
+#define FRAME_SCHEDULER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// decides when a new frame has to be drawn, instead of waking up on a fixed timer the scheduler sleeps until
+// something asks for a frame. Requests that come in close together are merged into a single frame, so there is at
+// most one frame per min_frame_interval no matter how many requests there were.
+//
+// NOTE: the frontend already redraws after every input event on its own, so a request is dropped if a frame got
+// drawn after it was made, the scheduler only ever has to step in for changes that didn't come from input (a clock
+// ticking over, a background job finishing)
+class FrameScheduler {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        // every frame that was actually drawn, no matter who asked for it
+        size_t frames_rendered = 0;
+        // frames the scheduler asked the frontend for
+        size_t frames_posted = 0;
+        // requested frames that never had to be posted because a frame got drawn in the meantime anyways
+        size_t frames_skipped = 0;
+        // requests that came in while another one was still waiting and got merged into it
+        size_t requests_merged = 0;
+    };
+
+    // post_frame gets called from the scheduler thread and has to be safe to call from there
+    FrameScheduler(std::function<void()> post_frame,
+                   std::chrono::milliseconds min_frame_interval = std::chrono::milliseconds(16));
+    ~FrameScheduler();
+
+    FrameScheduler(const FrameScheduler &) = delete;
+    FrameScheduler &operator=(const FrameScheduler &) = delete;
+
+    // all of these are safe to call from any thread
+    void request_frame();
+    // for things that are known to change at a certain time, like the clock in the status bar
+    void request_frame_at(Clock::time_point time);
+    // the renderer calls this every time it draws
+    void notify_frame_rendered();
+    Stats get_stats() const;
+
+    void stop();
+
+  private:
+    std::function<void()> post_frame;
+    std::chrono::milliseconds min_frame_interval;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake_up;
+    bool stop_requested = false;
+
+    // when the pending frame has to be posted by, and the time a frame has to be drawn after for the request to
+    // count as done already
+    std::optional<Clock::time_point> pending_frame_due_time;
+    Clock::time_point pending_frame_needed_after;
+    Clock::time_point last_render_time;
+
+    Stats stats;
+    std::thread scheduler_thread;
+
+    void add_request(Clock::time_point due_time, Clock::time_point needed_after);
+    void run();
+};
+
+#endif // FRAME_SCHEDULER_HPP
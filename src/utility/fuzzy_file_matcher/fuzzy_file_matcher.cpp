@@ -0,0 +1,175 @@
+#include "fuzzy_file_matcher.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+#include <rapidfuzz/fuzz.hpp>
+
+#include "../allocation_tracker/allocation_tracker.hpp"
+#include "../trace_recorder/trace_recorder.hpp"
+
+// below this many candidates per thread it is faster to not split the work up at all
+static constexpr size_t MIN_CANDIDATES_PER_SHARD = 4096;
+
+FuzzyFileMatcher::FuzzyFileMatcher(size_t num_threads, double filename_weight)
+    : thread_pool(num_threads), filename_weight(filename_weight) {}
+
+static std::string to_lowercase(const std::string &text) {
+    std::string lowercase_text = text;
+    for (char &c : lowercase_text) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return lowercase_text;
+}
+
+static bool contains_in_order(std::string_view lowercase_query, std::string_view text) {
+    size_t num_matched = 0;
+    for (size_t i = 0; i < text.size() and num_matched < lowercase_query.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) == lowercase_query[num_matched]) {
+            ++num_matched;
+        }
+    }
+    return num_matched == lowercase_query.size();
+}
+
+static std::string_view get_filename(std::string_view file_path) {
+    // NOTE: both separators are checked so this also does the right thing for windows paths
+    size_t last_separator = file_path.find_last_of("/\\");
+    return last_separator == std::string_view::npos ? file_path : file_path.substr(last_separator + 1);
+}
+
+std::vector<std::string> FuzzyFileMatcher::find_best_matches(const std::string &query,
+                                                             const std::shared_ptr<const FileList> &files,
+                                                             size_t result_limit) {
+    ScopedTraceSpan span("fuzzy match", "search");
+    ScopedAllocationTag allocation_tag(AllocationTag::SEARCH);
+    if (files == nullptr or result_limit == 0) {
+        return {};
+    }
+
+    std::string lowercase_query = to_lowercase(query);
+
+    if (files != files_of_remembered_candidates) {
+        remembered_candidates.clear();
+        files_of_remembered_candidates = files;
+    }
+
+    // go back to the longest remembered query that the new one starts with
+    while (not remembered_candidates.empty() and
+           not lowercase_query.starts_with(remembered_candidates.back().lowercase_query)) {
+        remembered_candidates.pop_back();
+    }
+    const std::vector<uint32_t> *previous_candidates =
+        remembered_candidates.empty() ? nullptr : &remembered_candidates.back().file_indices;
+
+    size_t num_candidates_to_check = previous_candidates ? previous_candidates->size() : files->size();
+    global_trace_recorder().record_counter("fuzzy match candidates", static_cast<double>(num_candidates_to_check));
+    RememberedCandidates new_candidates{lowercase_query, {}};
+    std::vector<ScoredFile> best_files =
+        rank_files(query, lowercase_query, *files, previous_candidates, result_limit, &new_candidates.file_indices);
+
+    if (not remembered_candidates.empty() and remembered_candidates.back().lowercase_query == lowercase_query) {
+        remembered_candidates.back() = std::move(new_candidates);
+    } else {
+        remembered_candidates.push_back(std::move(new_candidates));
+    }
+
+    // NOTE: the cutoffs rapidfuzz gets still apply here, so most files are given up on early
+    if (best_files.empty()) {
+        best_files = rank_files(query, lowercase_query, *files, nullptr, result_limit, nullptr);
+    }
+
+    std::vector<std::string> best_matches;
+    best_matches.reserve(best_files.size());
+    for (const ScoredFile &scored_file : best_files) {
+        best_matches.push_back((*files)[scored_file.file_index]);
+    }
+    return best_matches;
+}
+
+std::vector<FuzzyFileMatcher::ScoredFile>
+FuzzyFileMatcher::rank_files(const std::string &query, const std::string &lowercase_query, const FileList &files,
+                             const std::vector<uint32_t> *file_indices, size_t result_limit,
+                             std::vector<uint32_t> *candidates) {
+    size_t num_candidates_to_check = file_indices ? file_indices->size() : files.size();
+    size_t num_shards = std::clamp<size_t>(num_candidates_to_check / MIN_CANDIDATES_PER_SHARD, 1,
+                                           thread_pool.get_num_threads());
+
+    // each shard keeps its own candidates and its own best results, they get merged once every shard is done
+    std::vector<std::vector<uint32_t>> candidates_per_shard(num_shards);
+    std::vector<std::vector<ScoredFile>> best_files_per_shard(num_shards);
+
+    // the heap keeps the worst of the best files on top, so it is the one that gets replaced
+    auto is_better = [](const ScoredFile &a, const ScoredFile &b) {
+        return a.score > b.score or (a.score == b.score and a.file_index < b.file_index);
+    };
+
+    thread_pool.run_sharded(num_candidates_to_check, num_shards, [&](size_t shard_index, size_t begin, size_t end) {
+        ScopedTraceSpan shard_span("fuzzy match shard", "search");
+        ScopedAllocationTag shard_allocation_tag(AllocationTag::SEARCH);
+        rapidfuzz::fuzz::CachedRatio<char> scorer(query);
+        auto &shard_candidates = candidates_per_shard[shard_index];
+        auto &best_files = best_files_per_shard[shard_index];
+
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t file_index = file_indices ? (*file_indices)[i] : static_cast<uint32_t>(i);
+            std::string_view file_path = files[file_index];
+
+            if (candidates != nullptr) {
+                if (not contains_in_order(lowercase_query, file_path)) {
+                    continue;
+                }
+                shard_candidates.push_back(file_index);
+            }
+
+            // once the heap is full a file has to beat the worst one on it, so the scorer gets told how low it
+            // can give up at, this lets rapidfuzz bail out early on the files that can't make it
+            double filename_cutoff = 0;
+            double worst_best_score = 0;
+            bool heap_is_full = best_files.size() == result_limit;
+            if (heap_is_full) {
+                worst_best_score = best_files.front().score;
+                filename_cutoff = std::max(0.0, (worst_best_score - (1.0 - filename_weight) * 100) / filename_weight);
+            }
+
+            double filename_score = scorer.similarity(get_filename(file_path), filename_cutoff);
+            double path_cutoff = 0;
+            if (heap_is_full and filename_weight < 1.0) {
+                path_cutoff = std::max(0.0, (worst_best_score - filename_weight * filename_score) /
+                                                (1.0 - filename_weight));
+            }
+            double path_score = scorer.similarity(file_path, path_cutoff);
+
+            // Weighted combination of both scores
+            ScoredFile scored_file{(1.0 - filename_weight) * path_score + filename_weight * filename_score,
+                                   file_index};
+
+            if (not heap_is_full) {
+                best_files.push_back(scored_file);
+                std::push_heap(best_files.begin(), best_files.end(), is_better);
+            } else if (is_better(scored_file, best_files.front())) {
+                std::pop_heap(best_files.begin(), best_files.end(), is_better);
+                best_files.back() = scored_file;
+                std::push_heap(best_files.begin(), best_files.end(), is_better);
+            }
+        }
+    });
+
+    // the shards cover the candidates in order, so sticking them together keeps the indices sorted
+    if (candidates != nullptr) {
+        for (const auto &shard_candidates : candidates_per_shard) {
+            candidates->insert(candidates->end(), shard_candidates.begin(), shard_candidates.end());
+        }
+    }
+
+    std::vector<ScoredFile> best_files;
+    for (const auto &shard_best_files : best_files_per_shard) {
+        best_files.insert(best_files.end(), shard_best_files.begin(), shard_best_files.end());
+    }
+    size_t num_results = std::min(result_limit, best_files.size());
+    std::partial_sort(best_files.begin(), best_files.begin() + num_results, best_files.end(), is_better);
+    best_files.resize(num_results);
+    return best_files;
+}
+
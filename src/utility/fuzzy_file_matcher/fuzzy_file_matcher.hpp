@@ -0,0 +1,62 @@
+#ifndef FUZZY_FILE_MATCHER_HPP
+#define FUZZY_FILE_MATCHER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../thread_pool/thread_pool.hpp"
+
+// finds the files that best match what has been typed into the file picker.
+//
+// a file is a candidate when the query shows up in its path in order (ignoring case), for example "mdedcpp" is in
+// "src/modal_editor/modal_editor.cpp". Candidates are then ranked with rapidfuzz, mostly by how well the file name
+// matches and a bit by how well the whole path matches.
+//
+// typing usually extends the query one character at a time, and a file that didn't have "abc" in it can't have
+// "abcd" in it, so the candidates of every query are remembered and the next query only has to look through those,
+// backspacing goes back to the remembered candidates of the shorter query.
+//
+// a typo leaves no candidates at all, in that case every file is ranked with rapidfuzz alone so the picker still shows
+// the closest files.
+class FuzzyFileMatcher {
+  public:
+    using FileList = std::vector<std::string>;
+
+    // zero threads means one per core
+    explicit FuzzyFileMatcher(size_t num_threads = 0, double filename_weight = 0.7);
+
+    // best match first, holding onto the file list is what lets the candidates be reused between calls, when a
+    // different list comes in everything starts over
+    std::vector<std::string> find_best_matches(const std::string &query, const std::shared_ptr<const FileList> &files,
+                                               size_t result_limit);
+
+  private:
+    ThreadPool thread_pool;
+    double filename_weight;
+
+    struct RememberedCandidates {
+        std::string lowercase_query;
+        // indices into the file list, in increasing order
+        std::vector<uint32_t> file_indices;
+    };
+
+    std::shared_ptr<const FileList> files_of_remembered_candidates;
+    // every entry's query is a prefix of the next entry's query
+    std::vector<RememberedCandidates> remembered_candidates;
+
+    struct ScoredFile {
+        double score;
+        uint32_t file_index;
+    };
+
+    // ranks the files at the given indices (every file when there are none) and returns the best of them, best first.
+    // When candidates is passed only the files that have the query in them in order get ranked, and their indices
+    // are put into it in increasing order
+    std::vector<ScoredFile> rank_files(const std::string &query, const std::string &lowercase_query,
+                                       const FileList &files, const std::vector<uint32_t> *file_indices,
+                                       size_t result_limit, std::vector<uint32_t> *candidates);
+};
+
+#endif // FUZZY_FILE_MATCHER_HPP
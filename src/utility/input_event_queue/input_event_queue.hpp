@@ -0,0 +1,120 @@
+#ifndef INPUT_EVENT_QUEUE_HPP
+#define INPUT_EVENT_QUEUE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// the input events that came in but haven't been applied yet, in the order they came in. Events are pushed as the
+// frontend hands them over and drained all at once when the editor gets to them (once per frame), so a burst of keys
+// (fast typing, a paste, a slow connection catching up) is applied in order instead of being merged into one tick.
+//
+// the events live in a ring buffer, it only ever grows (doubling) when a burst doesn't fit, events are never dropped.
+// Every event is stamped when it's pushed, so the queue also knows how long events wait before they are applied.
+//
+// NOTE: not thread safe, pushing and popping both happen on the ui thread
+template <typename Event> class InputEventQueue {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t depth = 0;
+        // the most events that were ever waiting at once
+        size_t max_depth = 0;
+        size_t num_events_applied = 0;
+        // time from pushing an event to popping it
+        Clock::duration last_latency{0};
+        Clock::duration max_latency{0};
+        Clock::duration total_latency{0};
+
+        Clock::duration get_average_latency() const {
+            if (num_events_applied == 0) {
+                return Clock::duration(0);
+            }
+            return total_latency / static_cast<Clock::rep>(num_events_applied);
+        }
+    };
+
+    explicit InputEventQueue(size_t initial_capacity = 64) {
+        size_t capacity = 1;
+        while (capacity < initial_capacity) {
+            capacity *= 2;
+        }
+        slots.resize(capacity);
+    }
+
+    void push(Event event) {
+        if (num_events == slots.size()) {
+            grow();
+        }
+        Slot &slot = slots[(first_event + num_events) & (slots.size() - 1)];
+        slot.event = std::move(event);
+        slot.received_at = Clock::now();
+        ++num_events;
+        if (num_events > stats.max_depth) {
+            stats.max_depth = num_events;
+        }
+    }
+
+    // the oldest event, false when there is none
+    bool pop(Event &event) {
+        if (num_events == 0) {
+            return false;
+        }
+        Slot &slot = slots[first_event];
+        event = std::move(slot.event);
+        first_event = (first_event + 1) & (slots.size() - 1);
+        --num_events;
+
+        Clock::duration latency = Clock::now() - slot.received_at;
+        stats.last_latency = latency;
+        if (latency > stats.max_latency) {
+            stats.max_latency = latency;
+        }
+        stats.total_latency += latency;
+        ++stats.num_events_applied;
+        return true;
+    }
+
+    // when the oldest event still in the queue came in
+    std::optional<Clock::time_point> get_oldest_received_at() const {
+        if (num_events == 0) {
+            return std::nullopt;
+        }
+        return slots[first_event].received_at;
+    }
+
+    size_t size() const { return num_events; }
+    bool empty() const { return num_events == 0; }
+
+    Stats get_stats() const {
+        Stats current_stats = stats;
+        current_stats.depth = num_events;
+        return current_stats;
+    }
+
+  private:
+    struct Slot {
+        Event event{};
+        Clock::time_point received_at;
+    };
+
+    // the capacity is always a power of two so wrapping around is a mask
+    std::vector<Slot> slots;
+    size_t first_event = 0;
+    size_t num_events = 0;
+    Stats stats;
+
+    void grow() {
+        std::vector<Slot> bigger_slots(slots.size() * 2);
+        for (size_t i = 0; i < num_events; ++i) {
+            bigger_slots[i] = std::move(slots[(first_event + i) & (slots.size() - 1)]);
+        }
+        slots = std::move(bigger_slots);
+        first_event = 0;
+    }
+};
+
+#endif // INPUT_EVENT_QUEUE_HPP
@@ -0,0 +1,218 @@
+#include "keymap.hpp"
+
+#include <algorithm>
+
+#include "../ring_logger/ring_logger.hpp"
+
+Keymap::Keymap() { nodes.emplace_back(); }
+
+bool Keymap::parse_pattern(const std::string &pattern, std::vector<PatternElement> &elements, size_t &num_captures) {
+    elements.clear();
+    num_captures = 0;
+
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        PatternElement element;
+
+        if (c == '\\') {
+            if (i + 1 == pattern.size()) {
+                return false;
+            }
+            element.characters = pattern[++i];
+        } else if (c == '[') {
+            size_t closing = pattern.find(']', i + 1);
+            if (closing == std::string::npos or closing == i + 1) {
+                return false;
+            }
+            element.characters = pattern.substr(i + 1, closing - i - 1);
+            element.capture_index = static_cast<int>(num_captures++);
+            i = closing;
+        } else if (c == '.') {
+            element.capture_index = static_cast<int>(num_captures++);
+        } else if (c == '?' or c == ']') {
+            return false;
+        } else {
+            element.characters = c;
+        }
+
+        if (i + 1 < pattern.size() and pattern[i + 1] == '?') {
+            element.optional = true;
+            ++i;
+        }
+        elements.push_back(std::move(element));
+    }
+
+    return not elements.empty();
+}
+
+bool Keymap::add_binding(const std::string &pattern, Handler handler) {
+    std::vector<PatternElement> elements;
+    size_t num_captures;
+    if (not parse_pattern(pattern, elements, num_captures)) {
+        LOG_ERROR("Unable to parse key binding \"{}\".", pattern);
+        return false;
+    }
+    if (num_captures > KeymapMatch::MAX_CAPTURES) {
+        LOG_ERROR("Key binding \"{}\" has {} captures, at most {} are supported.", pattern, num_captures,
+                  KeymapMatch::MAX_CAPTURES);
+        return false;
+    }
+
+    std::vector<size_t> optional_element_indices;
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (elements[i].optional) {
+            optional_element_indices.push_back(i);
+        }
+    }
+
+    // every way of keeping or leaving out the optional elements, with everything kept first so it wins ties
+    size_t num_variants = size_t(1) << optional_element_indices.size();
+    for (size_t left_out = 0; left_out < num_variants; ++left_out) {
+        Binding binding;
+        binding.num_captures = num_captures;
+        binding.handler = handler;
+        for (size_t i = 0, optional_index = 0; i < elements.size(); ++i) {
+            bool keep = true;
+            if (elements[i].optional) {
+                keep = ((left_out >> optional_index) & 1) == 0;
+                ++optional_index;
+            }
+            if (keep) {
+                binding.elements.push_back(elements[i]);
+            }
+        }
+        if (binding.elements.empty()) {
+            continue;
+        }
+
+        bindings.push_back(std::move(binding));
+        insert(ROOT, static_cast<int>(bindings.size()) - 1, 0);
+    }
+    return true;
+}
+
+// walks every path the binding takes from the node and marks where it ends, the automaton stays deterministic because
+// a key that gets its own child copies whatever the any key child already leads to, and a . goes down every child
+void Keymap::insert(int node, int binding_index, size_t element_index) {
+    const std::vector<PatternElement> &elements = bindings[binding_index].elements;
+    if (element_index == elements.size()) {
+        if (nodes[node].binding_index == -1) {
+            nodes[node].binding_index = binding_index;
+        }
+        return;
+    }
+
+    const PatternElement &element = elements[element_index];
+    if (not element.characters.empty()) {
+        for (char key : element.characters) {
+            insert(get_or_create_child(node, key), binding_index, element_index + 1);
+        }
+        return;
+    }
+
+    if (nodes[node].any_key_child == -1) {
+        int child = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+        nodes[node].any_key_child = child;
+    }
+    insert(nodes[node].any_key_child, binding_index, element_index + 1);
+
+    // NOTE: copied out first, nodes can be added (and moved around) while inserting
+    std::vector<int> children;
+    for (const auto &[key, child] : nodes[node].children) {
+        children.push_back(child);
+    }
+    for (int child : children) {
+        insert(child, binding_index, element_index + 1);
+    }
+}
+
+int Keymap::get_or_create_child(int node, char key) {
+    auto it = nodes[node].children.find(key);
+    if (it != nodes[node].children.end()) {
+        return it->second;
+    }
+
+    int child;
+    if (nodes[node].any_key_child != -1) {
+        child = clone_subtree(nodes[node].any_key_child);
+    } else {
+        child = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[node].children[key] = child;
+    return child;
+}
+
+int Keymap::clone_subtree(int node) {
+    int copy = static_cast<int>(nodes.size());
+    nodes.push_back(nodes[node]);
+
+    if (nodes[copy].any_key_child != -1) {
+        int any_key_child = clone_subtree(nodes[copy].any_key_child);
+        nodes[copy].any_key_child = any_key_child;
+    }
+    std::vector<std::pair<char, int>> children(nodes[copy].children.begin(), nodes[copy].children.end());
+    for (const auto &[key, child] : children) {
+        int child_copy = clone_subtree(child);
+        nodes[copy].children[key] = child_copy;
+    }
+    return copy;
+}
+
+KeymapResult Keymap::feed(char key) {
+    const Node &root = nodes[ROOT];
+    bool key_is_digit = key >= '0' and key <= '9';
+    bool root_binds_key = root.children.count(key) != 0 or root.any_key_child != -1;
+    if (current_node == ROOT and key_is_digit and (count_given or not root_binds_key)) {
+        count = std::min(count * 10 + (key - '0'), MAX_COUNT);
+        count_given = true;
+        pending_keys += key;
+        return KeymapResult::PENDING;
+    }
+
+    const Node &node = nodes[current_node];
+    int next_node = node.any_key_child;
+    auto it = node.children.find(key);
+    if (it != node.children.end()) {
+        next_node = it->second;
+    }
+    if (next_node == -1) {
+        reset();
+        return KeymapResult::NO_MATCH;
+    }
+
+    current_node = next_node;
+    pending_keys += key;
+    command_keys += key;
+
+    int binding_index = nodes[current_node].binding_index;
+    if (binding_index == -1) {
+        return KeymapResult::PENDING;
+    }
+
+    const Binding &binding = bindings[binding_index];
+    KeymapMatch match;
+    match.count = count_given ? count : 1;
+    match.count_given = count_given;
+    match.keys = std::move(command_keys);
+    match.num_captures = binding.num_captures;
+    for (size_t i = 0; i < binding.elements.size(); ++i) {
+        if (binding.elements[i].capture_index != -1) {
+            match.captures[binding.elements[i].capture_index] = match.keys[i];
+        }
+    }
+
+    // NOTE: reset before running, the handler is free to feed or reset the keymap itself
+    reset();
+    binding.handler(match);
+    return KeymapResult::COMPLETE;
+}
+
+void Keymap::reset() {
+    current_node = ROOT;
+    count = 0;
+    count_given = false;
+    pending_keys.clear();
+    command_keys.clear();
+}
@@ -0,0 +1,110 @@
+#ifndef KEYMAP_HPP
+#define KEYMAP_HPP
+
+#include <array>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// what feeding a key into a keymap did
+enum class KeymapResult {
+    // the keys so far make up a command, it was run and the keymap starts over
+    COMPLETE,
+    // the keys so far are the start of at least one command
+    PENDING,
+    // no command starts with the keys so far, they were dropped and the keymap starts over
+    NO_MATCH,
+};
+
+// what a command was typed with
+struct KeymapMatch {
+    // the number typed in front of the command, 1 when there wasn't one
+    int count = 1;
+    bool count_given = false;
+    // every key of the command, without the count
+    std::string keys;
+    // the key each [set] or . in the binding matched, in the order they appear in it, an optional one that was left
+    // out is '\0'. Kept inline so that matching a command doesn't allocate
+    static constexpr size_t MAX_CAPTURES = 8;
+    std::array<char, MAX_CAPTURES> captures{};
+    size_t num_captures = 0;
+
+    char capture(size_t index) const { return index < num_captures ? captures[index] : '\0'; }
+};
+
+// normal mode key sequences compiled into a deterministic automaton, so every key costs one hash lookup no matter how
+// many commands there are, and a sequence is known to be complete, a prefix of a command or nothing at all as soon as
+// its last key comes in.
+//
+// a binding is a pattern of keys:
+//   - a plain character matches itself, a backslash in front of [ ] . ? \ makes them plain characters too
+//   - [abc] matches any one of the characters inside of the brackets
+//   - . matches any key (the target of f and t)
+//   - ? after any of the above makes it optional
+// so operator/motion/text object grammar is written out directly, for example "[cd]?[webB]" or "[cd][ai][bB]".
+//
+// a count can be typed in front of every command, digits at the start of a sequence go into it unless a binding
+// starts with that digit (like 0), once a count has started every digit is part of it.
+//
+// when two bindings match the same keys the one added first wins, a binding that is a prefix of another one makes the
+// longer one unreachable since there is no waiting for more keys
+class Keymap {
+  public:
+    using Handler = std::function<void(const KeymapMatch &)>;
+
+    Keymap();
+
+    // returns false (and adds nothing) when the pattern doesn't parse or has more than KeymapMatch::MAX_CAPTURES
+    // captures
+    bool add_binding(const std::string &pattern, Handler handler);
+
+    KeymapResult feed(char key);
+    // forgets the keys typed so far
+    void reset();
+
+    // the keys typed so far (count included), for showing what is pending
+    const std::string &get_pending_keys() const { return pending_keys; }
+
+  private:
+    struct PatternElement {
+        // all the characters it matches, empty for .
+        std::string characters;
+        bool optional = false;
+        // where its key goes in the captures, -1 for plain characters
+        int capture_index = -1;
+    };
+
+    struct Binding {
+        // NOTE: without optional elements, a pattern with them is added once for every way of leaving them out
+        std::vector<PatternElement> elements;
+        size_t num_captures = 0;
+        Handler handler;
+    };
+
+    struct Node {
+        std::unordered_map<char, int> children;
+        // where any key that isn't in children goes, -1 when they go nowhere
+        int any_key_child = -1;
+        int binding_index = -1;
+    };
+
+    static constexpr int ROOT = 0;
+    static constexpr int MAX_COUNT = 1'000'000;
+
+    std::vector<Node> nodes;
+    std::vector<Binding> bindings;
+
+    int current_node = ROOT;
+    int count = 0;
+    bool count_given = false;
+    std::string pending_keys;
+    std::string command_keys;
+
+    static bool parse_pattern(const std::string &pattern, std::vector<PatternElement> &elements, size_t &num_captures);
+    void insert(int node, int binding_index, size_t element_index);
+    int get_or_create_child(int node, char key);
+    int clone_subtree(int node);
+};
+
+#endif // KEYMAP_HPP
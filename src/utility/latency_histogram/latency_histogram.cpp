@@ -0,0 +1,66 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+size_t LatencyHistogram::get_bucket_index(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = std::bit_width(value) - 1;
+    if (exponent >= MAX_VALUE_BITS) {
+        return NUM_BUCKETS - 1;
+    }
+    // the top SUB_BUCKET_BITS bits below the leading one pick the bucket within the power of two
+    int shift = exponent - SUB_BUCKET_BITS;
+    uint64_t sub_bucket = (value >> shift) & (SUB_BUCKET_COUNT - 1);
+    return SUB_BUCKET_COUNT + static_cast<size_t>(shift) * SUB_BUCKET_COUNT + static_cast<size_t>(sub_bucket);
+}
+
+uint64_t LatencyHistogram::get_bucket_upper_bound(size_t bucket_index) {
+    if (bucket_index < SUB_BUCKET_COUNT) {
+        return bucket_index;
+    }
+    size_t shift = (bucket_index - SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+    uint64_t sub_bucket = (bucket_index - SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT;
+    uint64_t lower_bound = (SUB_BUCKET_COUNT + sub_bucket) << shift;
+    return lower_bound + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(Duration duration) {
+    uint64_t value = static_cast<uint64_t>(std::max<Duration::rep>(duration.count(), 0));
+    ++bucket_counts[get_bucket_index(value)];
+    ++count;
+    total += value;
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+}
+
+void LatencyHistogram::reset() { *this = LatencyHistogram(); }
+
+LatencyHistogram::Duration LatencyHistogram::get_mean() const {
+    if (count == 0) {
+        return Duration(0);
+    }
+    return Duration(total / count);
+}
+
+LatencyHistogram::Duration LatencyHistogram::get_percentile(double percentile) const {
+    if (count == 0) {
+        return Duration(0);
+    }
+    // the rank of the value we're after, counting from 1
+    double clamped_percentile = std::clamp(percentile, 0.0, 100.0);
+    auto rank = static_cast<size_t>(std::ceil(clamped_percentile / 100.0 * static_cast<double>(count)));
+    rank = std::max<size_t>(rank, 1);
+
+    size_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += bucket_counts[i];
+        if (seen >= rank) {
+            return Duration(std::clamp(get_bucket_upper_bound(i), min_value, max_value));
+        }
+    }
+    return Duration(max_value);
+}
@@ -0,0 +1,45 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// counts durations in log-linear buckets the way an HDR histogram does: below SUB_BUCKET_COUNT nanoseconds every value
+// gets its own bucket, above that every power of two is split into SUB_BUCKET_COUNT equal buckets. A percentile read
+// back is off by at most 1/SUB_BUCKET_COUNT of itself no matter how big it is, and recording is a couple of bit
+// operations and an increment into a fixed array, so it can sit on the keystroke path
+class LatencyHistogram {
+  public:
+    using Duration = std::chrono::nanoseconds;
+
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    // anything at or above 2^40ns (about 18 minutes) lands in the last bucket
+    static constexpr int MAX_VALUE_BITS = 40;
+    static constexpr size_t NUM_BUCKETS = SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+
+    void record(Duration duration);
+    void reset();
+
+    size_t get_count() const { return count; }
+    Duration get_min() const { return Duration(count == 0 ? 0 : min_value); }
+    Duration get_max() const { return Duration(max_value); }
+    Duration get_mean() const;
+    // percentile goes from 0 to 100, the value returned is the top of the bucket the percentile falls into (but never
+    // more than the largest value recorded), zero when nothing was recorded
+    Duration get_percentile(double percentile) const;
+
+  private:
+    std::array<uint64_t, NUM_BUCKETS> bucket_counts{};
+    size_t count = 0;
+    uint64_t min_value = UINT64_MAX;
+    uint64_t max_value = 0;
+    uint64_t total = 0;
+
+    static size_t get_bucket_index(uint64_t value);
+    static uint64_t get_bucket_upper_bound(size_t bucket_index);
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
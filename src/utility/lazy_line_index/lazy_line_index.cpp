@@ -0,0 +1,118 @@
+#include "lazy_line_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../trace_recorder/trace_recorder.hpp"
+
+// how much text gets scanned before the newly found lines are published to readers
+static constexpr size_t INDEXING_CHUNK_SIZE_BYTES = 1 << 20;
+
+LazyLineIndex::~LazyLineIndex() { clear(); }
+
+void LazyLineIndex::build(const char *data, size_t size) {
+    clear();
+    allocate_segment_table(size);
+    run_indexing(data, size);
+}
+
+void LazyLineIndex::start_building_in_background(const char *data, size_t size) {
+    clear();
+    allocate_segment_table(size);
+    set_indexing_finished(false);
+    indexing_thread = std::thread([this, data, size] {
+        run_indexing(data, size);
+        set_indexing_finished(true);
+    });
+}
+
+void LazyLineIndex::wait_until_complete() {
+    if (is_complete()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(indexing_finished_mutex);
+    indexing_finished_condition.wait(lock, [this] { return indexing_finished; });
+}
+
+void LazyLineIndex::clear() {
+    stop_requested.store(true);
+    if (indexing_thread.joinable()) {
+        indexing_thread.join();
+    }
+    stop_requested.store(false);
+
+    segments.clear();
+    num_published_entries.store(0);
+    complete.store(false);
+}
+
+void LazyLineIndex::set_indexing_finished(bool finished) {
+    {
+        std::lock_guard<std::mutex> lock(indexing_finished_mutex);
+        indexing_finished = finished;
+    }
+    if (finished) {
+        indexing_finished_condition.notify_all();
+    }
+}
+
+int LazyLineIndex::num_indexed_lines() const {
+    size_t num_entries = num_published_entries.load(std::memory_order_acquire);
+    return num_entries == 0 ? 0 : static_cast<int>(num_entries - 1);
+}
+
+size_t LazyLineIndex::line_start(int line_index) const {
+    size_t entry_index = static_cast<size_t>(line_index);
+    return segments[entry_index / SEGMENT_SIZE][entry_index % SEGMENT_SIZE];
+}
+
+// every byte could be a newline, plus the first entry and the one past the end, so that is the most entries we could
+// ever need, only the table of pointers is allocated up front, the segments themselves are created as they fill up
+void LazyLineIndex::allocate_segment_table(size_t size) {
+    size_t max_num_entries = size + 2;
+    segments.resize((max_num_entries + SEGMENT_SIZE - 1) / SEGMENT_SIZE);
+}
+
+void LazyLineIndex::write_entry(size_t entry_index, size_t value) {
+    auto &segment = segments[entry_index / SEGMENT_SIZE];
+    if (!segment) {
+        segment = std::make_unique_for_overwrite<size_t[]>(SEGMENT_SIZE);
+    }
+    segment[entry_index % SEGMENT_SIZE] = value;
+}
+
+void LazyLineIndex::run_indexing(const char *data, size_t size) {
+    global_trace_recorder().set_current_thread_name("line indexing");
+    ScopedTraceSpan span("index lines", "io");
+    size_t num_entries = 0;
+    write_entry(num_entries++, 0);
+
+    size_t position = 0;
+    while (position < size) {
+        if (stop_requested.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        size_t chunk_end = std::min(size, position + INDEXING_CHUNK_SIZE_BYTES);
+        // NOTE: memchr is vectorized by the standard library, this is the hot loop when opening large files
+        while (position < chunk_end) {
+            const void *newline = std::memchr(data + position, '\n', chunk_end - position);
+            if (newline == nullptr) {
+                position = chunk_end;
+                break;
+            }
+            position = static_cast<const char *>(newline) - data + 1;
+            write_entry(num_entries++, position);
+        }
+
+        num_published_entries.store(num_entries, std::memory_order_release);
+    }
+
+    // a text that doesn't end in a newline still has a last line, pretend there is a newline one past the end
+    if (size > 0 and data[size - 1] != '\n') {
+        write_entry(num_entries++, size + 1);
+    }
+
+    num_published_entries.store(num_entries, std::memory_order_release);
+    complete.store(true, std::memory_order_release);
+}
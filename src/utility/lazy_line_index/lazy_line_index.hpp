@@ -0,0 +1,63 @@
+#ifndef LAZY_LINE_INDEX_HPP
+#define LAZY_LINE_INDEX_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// the byte offsets where each line of a block of text starts. The index can be built on a background thread, in which
+// case it grows chunk by chunk and readers on other threads can already use every line that has been published so
+// far, this is what lets a huge file show its first screen before it has been fully scanned.
+//
+// like the piece table, line i occupies [line_start(i), line_start(i + 1) - 1), the entry after the last line is one
+// past its newline, or one past the end of the text when the text doesn't end in a newline.
+class LazyLineIndex {
+  public:
+    LazyLineIndex() = default;
+    ~LazyLineIndex();
+
+    LazyLineIndex(const LazyLineIndex &) = delete;
+    LazyLineIndex &operator=(const LazyLineIndex &) = delete;
+
+    // the text must stay alive and unchanged until the index is cleared or destroyed
+    void build(const char *data, size_t size);
+    void start_building_in_background(const char *data, size_t size);
+
+    // safe to call from any thread, only the owner may clear the index (which is also when the thread is joined)
+    void wait_until_complete();
+    void clear();
+
+    bool is_complete() const { return complete.load(std::memory_order_acquire); }
+
+    // lines whose start and end are both known, safe to call from any thread
+    int num_indexed_lines() const;
+    // the index must be at most num_indexed_lines()
+    size_t line_start(int line_index) const;
+
+  private:
+    // entries are stored in fixed size segments which are never moved, so readers can use published entries while the
+    // indexing thread is still appending new ones
+    static constexpr size_t SEGMENT_SIZE = 1 << 16;
+    std::vector<std::unique_ptr<size_t[]>> segments;
+
+    std::atomic<size_t> num_published_entries{0};
+    std::atomic<bool> complete{false};
+    std::atomic<bool> stop_requested{false};
+    std::thread indexing_thread;
+
+    // waiters block on this instead of joining, joining the same thread from two places is undefined behavior
+    std::mutex indexing_finished_mutex;
+    std::condition_variable indexing_finished_condition;
+    bool indexing_finished = true;
+
+    void allocate_segment_table(size_t size);
+    void run_indexing(const char *data, size_t size);
+    void set_indexing_finished(bool finished);
+    void write_entry(size_t entry_index, size_t value);
+};
+
+#endif // LAZY_LINE_INDEX_HPP
@@ -0,0 +1,95 @@
+#include "line_rope.hpp"
+
+void LineRope::clear() { tree.clear(); }
+
+int LineRope::line_count() const { return tree.line_count(); }
+
+LineRope::Location LineRope::locate(int line_index) const {
+    const auto *node = &tree.get_root();
+    while (not node->is_leaf) {
+        for (const auto &child : node->children) {
+            if (line_index < child->summary.line_count) {
+                node = child.get();
+                break;
+            }
+            line_index -= child->summary.line_count;
+        }
+    }
+
+    for (const auto &piece : node->entries) {
+        if (line_index < piece.line_count) {
+            return {piece, line_index};
+        }
+        line_index -= piece.line_count;
+    }
+
+    // only reachable when the line was out of bounds
+    return {{PieceSource::ORIGINAL, 0, 0}, 0};
+}
+
+void LineRope::insert(int line_index, const Piece &piece) {
+    if (line_index < 0 or line_index > line_count() or piece.line_count <= 0) {
+        return;
+    }
+    tree.splice(line_index, false, &piece);
+}
+
+void LineRope::erase_line(int line_index) {
+    if (line_index < 0 or line_index >= line_count()) {
+        return;
+    }
+    tree.splice(line_index, true, nullptr);
+}
+
+void LineRope::replace_line(int line_index, const Piece &piece) {
+    if (line_index < 0 or line_index >= line_count()) {
+        return;
+    }
+    tree.splice(line_index, true, &piece);
+}
+
+void LineRopeTraits::splice_leaf(std::vector<Piece> &pieces, int line_index, bool erase,
+                                 const Piece *piece_to_insert) {
+    // find the piece the line lives in
+    size_t position = 0;
+    while (position < pieces.size() and line_index >= pieces[position].line_count) {
+        line_index -= pieces[position].line_count;
+        position++;
+    }
+
+    // make sure a piece starts exactly at the line by splitting the piece it lives in
+    if (position < pieces.size() and line_index > 0) {
+        Piece &piece = pieces[position];
+        Piece right_piece = {piece.source, piece.first_line + line_index, piece.line_count - line_index};
+        piece.line_count = line_index;
+        pieces.insert(pieces.begin() + position + 1, right_piece);
+        position++;
+    }
+
+    if (erase and position < pieces.size()) {
+        Piece &piece = pieces[position];
+        if (piece.line_count == 1) {
+            pieces.erase(pieces.begin() + position);
+        } else {
+            piece.first_line++;
+            piece.line_count--;
+        }
+    }
+
+    if (piece_to_insert != nullptr) {
+        // lines that were appended back to back into the same buffer can share a single piece
+        bool extended_previous_piece = false;
+        if (position > 0) {
+            Piece &previous_piece = pieces[position - 1];
+            if (previous_piece.source == piece_to_insert->source and
+                previous_piece.first_line + previous_piece.line_count == piece_to_insert->first_line) {
+                previous_piece.line_count += piece_to_insert->line_count;
+                extended_previous_piece = true;
+            }
+        }
+
+        if (not extended_previous_piece) {
+            pieces.insert(pieces.begin() + position, *piece_to_insert);
+        }
+    }
+}
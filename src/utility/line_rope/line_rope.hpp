@@ -0,0 +1,64 @@
+#ifndef LINE_ROPE_HPP
+#define LINE_ROPE_HPP
+
+#include <vector>
+
+#include "../cow_btree/cow_btree.hpp"
+
+enum class PieceSource { ORIGINAL, ADD };
+
+// a run of consecutive lines inside of one of the piece table buffers
+struct Piece {
+    PieceSource source;
+    // index into the line starts of the source buffer
+    int first_line;
+    int line_count;
+};
+
+// what the rope needs to know about pieces to keep them in a CowBTree, every node caches how many lines are below it
+struct LineRopeTraits {
+    using Entry = Piece;
+    struct Summary {
+        int line_count = 0;
+    };
+
+    static Summary summarize(const Piece &piece) { return {piece.line_count}; }
+    static Summary combine(const Summary &a, const Summary &b) { return {a.line_count + b.line_count}; }
+    static void splice_leaf(std::vector<Piece> &pieces, int line_index, bool erase, const Piece *piece_to_insert);
+};
+
+// the pieces of a piece table in a balanced tree (see CowBTree), this lets us go from a line number to the piece
+// holding it in O(log n) by walking down from the root, and splicing a line in or out only touches the nodes on a
+// single root to leaf path.
+//
+// NOTE: the pieces are the chunks of the rope, the text itself lives in the buffers of the piece table
+//
+// copying a rope is O(1) and a copy can be read from another thread while the original keeps getting modified, as
+// long as each rope itself is only used by one thread.
+class LineRope {
+  public:
+    int line_count() const;
+
+    struct Location {
+        Piece piece;
+        // which line of the piece the requested line is
+        int offset_in_piece;
+    };
+
+    // the line must be in bounds
+    Location locate(int line_index) const;
+
+    void clear();
+    // inserts the lines of the piece so that the first one ends up at line_index
+    void insert(int line_index, const Piece &piece);
+    void erase_line(int line_index);
+    void replace_line(int line_index, const Piece &piece);
+
+    // calls the function on every piece in document order
+    template <typename Function> void for_each_piece(Function &&function) const { tree.for_each_entry(function); }
+
+  private:
+    CowBTree<LineRopeTraits> tree;
+};
+
+#endif // LINE_ROPE_HPP
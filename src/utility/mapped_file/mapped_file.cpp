@@ -0,0 +1,127 @@
+#include "mapped_file.hpp"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../ring_logger/ring_logger.hpp"
+
+MappedFile::~MappedFile() { close(); }
+
+#if defined(_WIN32) || defined(_WIN64)
+
+bool MappedFile::open(const std::string &file_path) {
+    close();
+
+    HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Unable to open file {} for mapping", file_path);
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapped_size = static_cast<size_t>(file_size.QuadPart);
+    opened = true;
+
+    // an empty file can't be mapped, but there is nothing to read anyways
+    if (mapped_size == 0) {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        LOG_ERROR("Unable to map file {}", file_path);
+        close();
+        return false;
+    }
+    mapping_handle = mapping;
+
+    mapped_data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (mapped_data == nullptr) {
+        LOG_ERROR("Unable to map file {}", file_path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped_data != nullptr) {
+        UnmapViewOfFile(mapped_data);
+    }
+    if (mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle != nullptr) {
+        CloseHandle(file_handle);
+    }
+    mapped_data = nullptr;
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+    mapped_size = 0;
+    opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &file_path) {
+    close();
+
+    int file_descriptor = ::open(file_path.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+        LOG_ERROR("Unable to open file {} for mapping", file_path);
+        return false;
+    }
+
+    struct stat file_stats;
+    if (fstat(file_descriptor, &file_stats) != 0) {
+        ::close(file_descriptor);
+        return false;
+    }
+
+    mapped_size = static_cast<size_t>(file_stats.st_size);
+    opened = true;
+
+    // an empty file can't be mapped, but there is nothing to read anyways
+    if (mapped_size == 0) {
+        ::close(file_descriptor);
+        return true;
+    }
+
+    void *mapping = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    // the mapping keeps its own reference to the file, so the descriptor isn't needed anymore
+    ::close(file_descriptor);
+
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("Unable to map file {}", file_path);
+        mapped_size = 0;
+        opened = false;
+        return false;
+    }
+
+    mapped_data = static_cast<const char *>(mapping);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped_data != nullptr) {
+        munmap(const_cast<char *>(mapped_data), mapped_size);
+    }
+    mapped_data = nullptr;
+    mapped_size = 0;
+    opened = false;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// a read only memory mapping of a whole file, the operating system pages the contents in as they get touched, so
+// opening a file is practically free no matter how big it is.
+//
+// NOTE: the mapping reflects the file on disk, so the file must not be truncated or rewritten in place while it is
+// mapped, write a new file and rename it over the old one instead.
+class MappedFile {
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &file_path);
+    void close();
+
+    bool is_open() const { return opened; }
+    const char *data() const { return mapped_data; }
+    size_t size() const { return mapped_size; }
+
+  private:
+    bool opened = false;
+    const char *mapped_data = nullptr;
+    size_t mapped_size = 0;
+
+#if defined(_WIN32) || defined(_WIN64)
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,34 @@
+#include "perf_probes.hpp"
+
+const char *perf_stage_to_string(PerfStage stage) {
+    switch (stage) {
+    case PerfStage::INPUT_QUEUE_WAIT:
+        return "input queue wait";
+    case PerfStage::KEY_LOGIC:
+        return "key logic";
+    case PerfStage::KEYMAP_DISPATCH:
+        return "keymap dispatch";
+    case PerfStage::TEXT_MODIFICATION:
+        return "text modification";
+    case PerfStage::FUZZY_FILE_MATCH:
+        return "fuzzy file match";
+    case PerfStage::VIEWPORT_RENDER:
+        return "viewport render";
+    case PerfStage::KEY_TO_FRAME:
+        return "key to frame";
+    case PerfStage::DUMMY:
+        break;
+    }
+    return "";
+}
+
+void PerfProbes::reset() {
+    for (auto &histogram : histograms) {
+        histogram.reset();
+    }
+}
+
+PerfProbes &global_perf_probes() {
+    static PerfProbes perf_probes;
+    return perf_probes;
+}
@@ -0,0 +1,62 @@
+#ifndef PERF_PROBES_HPP
+#define PERF_PROBES_HPP
+
+#include <array>
+#include <chrono>
+
+#include "../latency_histogram/latency_histogram.hpp"
+
+// the parts of getting from a key press to a frame on screen that get timed
+enum class PerfStage {
+    // from the frontend handing over the key to the frame picking it up
+    INPUT_QUEUE_WAIT,
+    // all of the key logic for one key press
+    KEY_LOGIC,
+    // one key going through the keymap, including the command it runs
+    KEYMAP_DISPATCH,
+    TEXT_MODIFICATION,
+    FUZZY_FILE_MATCH,
+    // laying out the visible rows and building the frame
+    VIEWPORT_RENDER,
+    // from the oldest key press applied in a frame to the frame being built
+    KEY_TO_FRAME,
+
+    DUMMY
+};
+
+const char *perf_stage_to_string(PerfStage stage);
+
+// a latency histogram per stage. NOTE: not thread safe, every stage is timed on the ui thread
+class PerfProbes {
+  public:
+    static constexpr size_t NUM_STAGES = static_cast<size_t>(PerfStage::DUMMY);
+
+    void record(PerfStage stage, LatencyHistogram::Duration duration) {
+        histograms[static_cast<size_t>(stage)].record(duration);
+    }
+    const LatencyHistogram &get_histogram(PerfStage stage) const { return histograms[static_cast<size_t>(stage)]; }
+    void reset();
+
+  private:
+    std::array<LatencyHistogram, NUM_STAGES> histograms;
+};
+
+PerfProbes &global_perf_probes();
+
+// times the scope it lives in and records it into the stage once the scope is left
+class ScopedPerfProbe {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ScopedPerfProbe(PerfStage stage) : stage(stage), start(Clock::now()) {}
+    ~ScopedPerfProbe() { global_perf_probes().record(stage, Clock::now() - start); }
+
+    ScopedPerfProbe(const ScopedPerfProbe &) = delete;
+    ScopedPerfProbe &operator=(const ScopedPerfProbe &) = delete;
+
+  private:
+    PerfStage stage;
+    Clock::time_point start;
+};
+
+#endif // PERF_PROBES_HPP
@@ -0,0 +1,223 @@
+#include "piece_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+int AddedLines::append(std::string_view content) {
+    // a line that doesn't fit in what is left of the last block starts a new one, the old block stays where it is
+    size_t needed = content.size() + 1;
+    if (text_blocks.empty() or last_text_block_capacity - last_text_block_used < needed) {
+        last_text_block_capacity = std::max(MIN_TEXT_BLOCK_SIZE, needed);
+        last_text_block_used = 0;
+        text_blocks.push_back(std::make_shared_for_overwrite<char[]>(last_text_block_capacity));
+    }
+    if (static_cast<size_t>(num_lines) == line_blocks.size() * LINES_PER_BLOCK) {
+        line_blocks.push_back(std::make_shared_for_overwrite<Line[]>(LINES_PER_BLOCK));
+    }
+
+    char *destination = text_blocks.back().get() + last_text_block_used;
+    std::memcpy(destination, content.data(), content.size());
+    destination[content.size()] = '\n';
+    last_text_block_used += needed;
+
+    line_blocks[num_lines / LINES_PER_BLOCK][num_lines % LINES_PER_BLOCK] = {
+        std::string_view(destination, content.size()), text_blocks.size() - 1};
+    return num_lines++;
+}
+
+void AddedLines::clear() {
+    text_blocks.clear();
+    last_text_block_capacity = 0;
+    last_text_block_used = 0;
+    line_blocks.clear();
+    num_lines = 0;
+}
+
+int PieceTableSnapshot::line_count() const {
+    if (not original_lines_are_in_rope) {
+        return original_line_starts->num_indexed_lines();
+    }
+    return pieces.line_count();
+}
+
+std::string_view PieceTableSnapshot::line_view(int line_index) const {
+    if (line_index < 0 or line_index >= line_count()) {
+        return {};
+    }
+
+    if (not original_lines_are_in_rope) {
+        return original_line_view(line_index);
+    }
+
+    auto [piece, offset_in_piece] = pieces.locate(line_index);
+    int source_line = piece.first_line + offset_in_piece;
+
+    if (piece.source == PieceSource::ORIGINAL) {
+        return original_line_view(source_line);
+    }
+    return added_lines.line_view(source_line);
+}
+
+std::string_view PieceTableSnapshot::original_line_view(int original_line_index) const {
+    size_t start = original_line_starts->line_start(original_line_index);
+    size_t end = original_line_starts->line_start(original_line_index + 1) - 1;
+    return std::string_view(original_data + start, end - start);
+}
+
+std::vector<std::string_view> PieceTableSnapshot::get_chunks() const {
+    std::vector<std::string_view> chunks;
+
+    // the text is only complete once every line is known, this is the one place a snapshot waits
+    if (not original_lines_are_in_rope) {
+        original_line_starts->wait_until_complete();
+    }
+
+    // pieces that happen to sit right next to each other in the same block of memory become a single chunk
+    const void *block_of_last_chunk = nullptr;
+    auto add_chunk = [&](const void *block, const char *data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        bool same_block = block != nullptr and block == block_of_last_chunk;
+        block_of_last_chunk = block;
+        if (same_block) {
+            std::string_view &last_chunk = chunks.back();
+            if (last_chunk.data() + last_chunk.size() == data) {
+                last_chunk = std::string_view(last_chunk.data(), last_chunk.size() + size);
+                return;
+            }
+        }
+        chunks.emplace_back(data, size);
+    };
+
+    // only the last line of the original buffer can be missing its newline
+    static constexpr std::string_view NEWLINE = "\n";
+    auto add_original_chunk = [&](size_t start, size_t end) {
+        add_chunk(original_data, original_data + start, std::min(end, original_size) - start);
+        if (end > original_size) {
+            add_chunk(nullptr, NEWLINE.data(), NEWLINE.size());
+        }
+    };
+
+    if (not original_lines_are_in_rope) {
+        int num_lines = line_count();
+        if (num_lines > 0) {
+            add_original_chunk(0, original_line_starts->line_start(num_lines));
+        }
+        return chunks;
+    }
+
+    pieces.for_each_piece([&](const Piece &piece) {
+        if (piece.source == PieceSource::ORIGINAL) {
+            add_original_chunk(original_line_starts->line_start(piece.first_line),
+                               original_line_starts->line_start(piece.first_line + piece.line_count));
+            return;
+        }
+        for (int i = 0; i < piece.line_count; ++i) {
+            int added_line = piece.first_line + i;
+            std::string_view line = added_lines.line_view(added_line);
+            // the newline right after the line is part of its block
+            add_chunk(added_lines.get_block(added_line), line.data(), line.size() + 1);
+        }
+    });
+    return chunks;
+}
+
+std::string PieceTableSnapshot::get_text() const {
+    std::vector<std::string_view> chunks = get_chunks();
+    size_t size = 0;
+    for (std::string_view chunk : chunks) {
+        size += chunk.size();
+    }
+
+    std::string result;
+    result.reserve(size);
+    for (std::string_view chunk : chunks) {
+        result += chunk;
+    }
+    return result;
+}
+
+PieceTable::PieceTable() { clear(); }
+
+void PieceTable::clear() {
+    // NOTE: the index goes first, it may still be reading the original bytes on its own thread
+    current.original_line_starts = std::make_shared<LazyLineIndex>();
+    current.original_owner.reset();
+    current.original_data = nullptr;
+    current.original_size = 0;
+    current.original_lines_are_in_rope = false;
+    current.added_lines.clear();
+    current.pieces.clear();
+    is_mapped = false;
+}
+
+void PieceTable::load(std::string &&original_content) {
+    clear();
+    auto owned_buffer = std::make_shared<std::string>(std::move(original_content));
+    current.original_data = owned_buffer->data();
+    current.original_size = owned_buffer->size();
+    current.original_owner = std::move(owned_buffer);
+    current.original_line_starts->build(current.original_data, current.original_size);
+}
+
+bool PieceTable::load_mapped(const std::string &file_path) {
+    clear();
+    auto mapping = std::make_shared<MappedFile>();
+    if (!mapping->open(file_path)) {
+        return false;
+    }
+    current.original_data = mapping->data();
+    current.original_size = mapping->size();
+    current.original_owner = std::move(mapping);
+    current.original_line_starts->start_building_in_background(current.original_data, current.original_size);
+    is_mapped = true;
+    return true;
+}
+
+bool PieceTable::is_memory_mapped() const { return is_mapped; }
+
+bool PieceTable::is_still_indexing() const { return not current.original_line_starts->is_complete(); }
+
+void PieceTable::wait_until_fully_indexed() { current.original_line_starts->wait_until_complete(); }
+
+// the rope only gets built on the first modification, for that we need to know every line of the original buffer
+void PieceTable::move_original_lines_into_rope() {
+    if (current.original_lines_are_in_rope) {
+        return;
+    }
+
+    current.original_line_starts->wait_until_complete();
+    int num_original_lines = current.original_line_starts->num_indexed_lines();
+    current.pieces.clear();
+    current.pieces.insert(0, {PieceSource::ORIGINAL, 0, num_original_lines});
+    current.original_lines_are_in_rope = true;
+}
+
+void PieceTable::replace_line(int line_index, std::string_view new_content) {
+    move_original_lines_into_rope();
+    if (line_index < 0 or line_index >= line_count()) {
+        return;
+    }
+    int added_line = current.added_lines.append(new_content);
+    current.pieces.replace_line(line_index, {PieceSource::ADD, added_line, 1});
+}
+
+void PieceTable::insert_line(int line_index, std::string_view content) {
+    move_original_lines_into_rope();
+    if (line_index < 0 or line_index > line_count()) {
+        return;
+    }
+    int added_line = current.added_lines.append(content);
+    current.pieces.insert(line_index, {PieceSource::ADD, added_line, 1});
+}
+
+void PieceTable::erase_line(int line_index) {
+    move_original_lines_into_rope();
+    current.pieces.erase_line(line_index);
+}
+
+void PieceTable::append_line(std::string_view content) {
+    move_original_lines_into_rope();
+    insert_line(line_count(), content);
+}
@@ -0,0 +1,129 @@
+#ifndef PIECE_TABLE_HPP
+#define PIECE_TABLE_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../line_rope/line_rope.hpp"
+#include "../lazy_line_index/lazy_line_index.hpp"
+#include "../mapped_file/mapped_file.hpp"
+
+// a piece table stores a document as two buffers, the original buffer holds the file exactly as it was loaded and is
+// never modified, the add buffer is only ever appended to. The document itself is described by a list of pieces where
+// each piece refers to a run of lines inside of one of those two buffers.
+//
+// NOTE: unlike the textbook piece table our pieces are measured in whole lines instead of bytes. Whenever a line is
+// edited its full new content gets appended to the add buffer, that way every line always lives contiguously in one
+// buffer, which is what the rest of the editor wants since it works line by line.
+//
+// the pieces are kept in a rope which caches line counts at every node, so finding a line and splicing a line in or
+// out are both O(log n) and never move any text around.
+//
+// the original buffer can either be read into memory or memory mapped, when it is mapped its lines are indexed on a
+// background thread, until the first modification every read goes straight to that index so lines can be shown while
+// it is still growing, the first modification waits for the index to finish and then hands the lines to the rope.
+
+// the lines that edits added, they live in blocks of memory that are never moved or freed while anything still uses
+// them, so a copy of this (which shares the blocks) keeps reading the same lines while more get appended to the
+// original. A line never straddles two blocks and is always followed by a newline inside of its block.
+class AddedLines {
+  public:
+    int line_count() const { return num_lines; }
+    std::string_view line_view(int line_index) const { return get_line(line_index).text; }
+    // lines in the same block that were appended one after the other sit right next to each other in memory
+    const char *get_block(int line_index) const { return text_blocks[get_line(line_index).text_block_index].get(); }
+
+    // returns the index of the new line
+    // NOTE: only ever append to one copy, the copies share the memory past the end of the lines they know about
+    int append(std::string_view content);
+    void clear();
+
+  private:
+    static constexpr size_t MIN_TEXT_BLOCK_SIZE = 1 << 18;
+    static constexpr size_t LINES_PER_BLOCK = 1 << 12;
+
+    struct Line {
+        std::string_view text;
+        size_t text_block_index;
+    };
+
+    std::vector<std::shared_ptr<char[]>> text_blocks;
+    size_t last_text_block_capacity = 0;
+    size_t last_text_block_used = 0;
+    std::vector<std::shared_ptr<Line[]>> line_blocks;
+    int num_lines = 0;
+
+    const Line &get_line(int line_index) const {
+        return line_blocks[line_index / LINES_PER_BLOCK][line_index % LINES_PER_BLOCK];
+    }
+};
+
+// the state of a piece table at one point in time, taking one is cheap (the rope and the buffers are shared, not
+// copied) and it never changes afterwards no matter what happens to the table, so it can be read on any thread
+// without locking while the editor keeps going.
+//
+// NOTE: a snapshot of a file that is still being indexed keeps picking up lines as the indexing finds them, that's
+// still the same text, it just isn't all known yet
+class PieceTableSnapshot {
+  public:
+    int line_count() const;
+    std::string_view line_view(int line_index) const;
+    // the whole text in order, in as few chunks as possible, every line is followed by a newline
+    std::vector<std::string_view> get_chunks() const;
+    std::string get_text() const;
+
+  private:
+    friend class PieceTable;
+
+    // NOTE: the order matters, members are destroyed bottom up and the line index can still be reading the original
+    // bytes on its own thread, so it has to go before they do
+    std::shared_ptr<const void> original_owner;
+    const char *original_data = nullptr;
+    size_t original_size = 0;
+    std::shared_ptr<LazyLineIndex> original_line_starts;
+    // false until the first modification, see the comment on the piece table
+    bool original_lines_are_in_rope = false;
+
+    AddedLines added_lines;
+    LineRope pieces;
+
+    std::string_view original_line_view(int original_line_index) const;
+};
+
+class PieceTable {
+  public:
+    PieceTable();
+
+    // takes ownership of the file content, the bytes are moved in and never copied afterwards
+    void load(std::string &&original_content);
+    bool load_mapped(const std::string &file_path);
+    void clear();
+
+    bool is_memory_mapped() const;
+    bool is_still_indexing() const;
+    void wait_until_fully_indexed();
+
+    // while the original buffer is still being indexed this only counts the lines found so far
+    int line_count() const { return current.line_count(); }
+
+    // the view is invalidated by any modification of the table
+    std::string_view line_view(int line_index) const { return current.line_view(line_index); }
+    std::string get_text() const { return current.get_text(); }
+    PieceTableSnapshot take_snapshot() const { return current; }
+
+    void replace_line(int line_index, std::string_view new_content);
+    void insert_line(int line_index, std::string_view content);
+    void erase_line(int line_index);
+    void append_line(std::string_view content);
+
+  private:
+    // the table is its own latest snapshot, modifying it only ever copies what a snapshot taken earlier still shares
+    PieceTableSnapshot current;
+    bool is_mapped = false;
+
+    void move_original_lines_into_rope();
+};
+
+#endif // PIECE_TABLE_HPP
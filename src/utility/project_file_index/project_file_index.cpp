@@ -0,0 +1,272 @@
+#include "project_file_index.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "../ring_logger/ring_logger.hpp"
+
+// while the first walk is still going the picker already gets to see what has been found so far
+static constexpr size_t PUBLISH_EVERY_N_FILES_DURING_WALK = 1 << 16;
+// changes tend to come in bursts (a checkout, a build), they get collected for this long before publishing
+static constexpr int PUBLISH_DELAY_AFTER_CHANGE_MS = 100;
+
+ProjectFileIndex::ProjectFileIndex(std::filesystem::path root_directory,
+                                   std::vector<std::string> ignored_directory_names)
+    : root_directory(std::move(root_directory)), ignored_directory_names(std::move(ignored_directory_names)),
+      published_files(std::make_shared<const FileList>()) {}
+
+ProjectFileIndex::~ProjectFileIndex() { stop(); }
+
+void ProjectFileIndex::start() {
+    if (indexing_thread.joinable()) {
+        return;
+    }
+    stop_requested.store(false);
+
+#if defined(__linux__)
+    inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd < 0) {
+        LOG_ERROR("Unable to watch {} for changes, the file list won't update", root_directory.string());
+    }
+    if (pipe(stop_pipe_fds) != 0) {
+        stop_pipe_fds[0] = stop_pipe_fds[1] = -1;
+    }
+#endif
+
+    indexing_thread = std::thread([this] { run(); });
+}
+
+void ProjectFileIndex::stop() {
+    stop_requested.store(true);
+
+#if defined(__linux__)
+    if (stop_pipe_fds[1] >= 0) {
+        char wake_up = 0;
+        [[maybe_unused]] auto written = write(stop_pipe_fds[1], &wake_up, 1);
+    }
+#endif
+
+    if (indexing_thread.joinable()) {
+        indexing_thread.join();
+    }
+
+#if defined(__linux__)
+    for (int fd : {inotify_fd, stop_pipe_fds[0], stop_pipe_fds[1]}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    inotify_fd = -1;
+    stop_pipe_fds[0] = stop_pipe_fds[1] = -1;
+    watch_descriptor_to_directory.clear();
+#endif
+}
+
+std::shared_ptr<const ProjectFileIndex::FileList> ProjectFileIndex::get_files() const {
+    std::lock_guard<std::mutex> lock(published_files_mutex);
+    return published_files;
+}
+
+bool ProjectFileIndex::is_ignored_directory(const std::filesystem::path &directory) const {
+    std::string directory_name = directory.filename().string();
+    return std::find(ignored_directory_names.begin(), ignored_directory_names.end(), directory_name) !=
+           ignored_directory_names.end();
+}
+
+void ProjectFileIndex::walk(const std::filesystem::path &directory) {
+#if defined(__linux__)
+    // NOTE: the watch goes in before the directory is listed, that way nothing created in between gets missed
+    watch_directory(directory.string());
+#endif
+
+    std::error_code error_code;
+    auto it = std::filesystem::recursive_directory_iterator(
+        directory, std::filesystem::directory_options::skip_permission_denied, error_code);
+
+    for (; not error_code and it != std::filesystem::recursive_directory_iterator(); it.increment(error_code)) {
+        if (stop_requested.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        const auto &entry = *it;
+        std::error_code entry_error_code;
+
+        if (entry.is_directory(entry_error_code)) {
+            if (is_ignored_directory(entry.path())) {
+                it.disable_recursion_pending();
+            } else {
+#if defined(__linux__)
+                watch_directory(entry.path().string());
+#endif
+            }
+        } else if (entry.is_regular_file(entry_error_code)) {
+            files.insert(entry.path().string());
+            if (not is_ready() and files.size() % PUBLISH_EVERY_N_FILES_DURING_WALK == 0) {
+                publish();
+            }
+        }
+    }
+}
+
+void ProjectFileIndex::publish() {
+    auto new_files = std::make_shared<FileList>(files.begin(), files.end());
+    std::sort(new_files->begin(), new_files->end());
+
+    {
+        std::lock_guard<std::mutex> lock(published_files_mutex);
+        published_files = std::move(new_files);
+    }
+    version.fetch_add(1, std::memory_order_release);
+}
+
+void ProjectFileIndex::run() {
+    walk(root_directory);
+    publish();
+    initial_walk_is_done.store(true, std::memory_order_release);
+
+#if defined(__linux__)
+    if (inotify_fd >= 0) {
+        watch_for_changes();
+    }
+#endif
+}
+
+#if defined(__linux__)
+
+void ProjectFileIndex::watch_directory(const std::string &directory) {
+    if (inotify_fd < 0) {
+        return;
+    }
+    uint32_t events = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+    int watch_descriptor = inotify_add_watch(inotify_fd, directory.c_str(), events);
+    if (watch_descriptor >= 0) {
+        watch_descriptor_to_directory[watch_descriptor] = directory;
+    }
+}
+
+// used when a directory is deleted or moved away, its files go and so do the watches for it and everything below it
+void ProjectFileIndex::remove_files_below(const std::string &directory) {
+    std::string prefix = directory + "/";
+
+    for (auto it = files.begin(); it != files.end();) {
+        it = it->starts_with(prefix) ? files.erase(it) : std::next(it);
+    }
+
+    for (auto it = watch_descriptor_to_directory.begin(); it != watch_descriptor_to_directory.end();) {
+        if (it->second == directory or it->second.starts_with(prefix)) {
+            inotify_rm_watch(inotify_fd, it->first);
+            it = watch_descriptor_to_directory.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ProjectFileIndex::watch_for_changes() {
+    using Clock = std::chrono::steady_clock;
+
+    pollfd poll_fds[2] = {{inotify_fd, POLLIN, 0}, {stop_pipe_fds[0], POLLIN, 0}};
+    int num_poll_fds = stop_pipe_fds[0] >= 0 ? 2 : 1;
+
+    alignas(inotify_event) char event_buffer[64 * 1024];
+
+    bool has_unpublished_changes = false;
+    Clock::time_point publish_deadline;
+
+    while (not stop_requested.load()) {
+        // with nothing waiting to be published we sleep until the kernel has something for us
+        int timeout_ms = -1;
+        if (has_unpublished_changes) {
+            auto time_left = std::chrono::duration_cast<std::chrono::milliseconds>(publish_deadline - Clock::now());
+            timeout_ms = std::max<int>(0, time_left.count());
+        }
+
+        int num_ready = poll(poll_fds, num_poll_fds, timeout_ms);
+        if (num_ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Stopped watching {} for changes", root_directory.string());
+            return;
+        }
+
+        if (num_ready == 0) {
+            publish();
+            has_unpublished_changes = false;
+            continue;
+        }
+
+        if (num_poll_fds == 2 and poll_fds[1].revents != 0) {
+            return;
+        }
+
+        bool something_changed = false;
+        while (true) {
+            ssize_t num_bytes_read = read(inotify_fd, event_buffer, sizeof(event_buffer));
+            if (num_bytes_read <= 0) {
+                break;
+            }
+
+            for (char *position = event_buffer; position < event_buffer + num_bytes_read;) {
+                auto *event = reinterpret_cast<inotify_event *>(position);
+                position += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // the kernel dropped events, the only way to be sure is to start over
+                    for (const auto &[watch_descriptor, directory] : watch_descriptor_to_directory) {
+                        inotify_rm_watch(inotify_fd, watch_descriptor);
+                    }
+                    watch_descriptor_to_directory.clear();
+                    files.clear();
+                    walk(root_directory);
+                    something_changed = true;
+                    break;
+                }
+
+                if (event->mask & IN_IGNORED) {
+                    watch_descriptor_to_directory.erase(event->wd);
+                    continue;
+                }
+
+                auto directory_it = watch_descriptor_to_directory.find(event->wd);
+                if (directory_it == watch_descriptor_to_directory.end() or event->len == 0) {
+                    continue;
+                }
+
+                std::filesystem::path path = std::filesystem::path(directory_it->second) / event->name;
+                bool appeared = event->mask & (IN_CREATE | IN_MOVED_TO);
+                bool disappeared = event->mask & (IN_DELETE | IN_MOVED_FROM);
+
+                if (event->mask & IN_ISDIR) {
+                    if (appeared and not is_ignored_directory(path)) {
+                        walk(path);
+                    } else if (disappeared) {
+                        remove_files_below(path.string());
+                    }
+                } else {
+                    std::error_code error_code;
+                    if (appeared and std::filesystem::is_regular_file(path, error_code)) {
+                        files.insert(path.string());
+                    } else if (disappeared) {
+                        files.erase(path.string());
+                    }
+                }
+                something_changed = true;
+            }
+        }
+
+        if (something_changed and not has_unpublished_changes) {
+            has_unpublished_changes = true;
+            publish_deadline = Clock::now() + std::chrono::milliseconds(PUBLISH_DELAY_AFTER_CHANGE_MS);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef PROJECT_FILE_INDEX_HPP
+#define PROJECT_FILE_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// every file in the project, walked once on a background thread when the editor starts and then kept up to date by
+// watching the directories for changes (inotify on linux), so nothing has to touch the disk while the user is typing.
+//
+// the paths look like the ones rec_get_all_files gives back, the root joined with the path below it
+class ProjectFileIndex {
+  public:
+    using FileList = std::vector<std::string>;
+
+    // directories with one of the ignored names are skipped along with everything inside of them
+    ProjectFileIndex(std::filesystem::path root_directory, std::vector<std::string> ignored_directory_names);
+    ~ProjectFileIndex();
+
+    ProjectFileIndex(const ProjectFileIndex &) = delete;
+    ProjectFileIndex &operator=(const ProjectFileIndex &) = delete;
+
+    void start();
+    void stop();
+
+    // true once the first walk of the whole tree is done, before that get_files only has what was found so far
+    bool is_ready() const { return initial_walk_is_done.load(std::memory_order_acquire); }
+
+    // the list never changes once it has been handed out, when files come and go a new list replaces it, so this can
+    // be held onto for as long as needed, safe to call from any thread
+    std::shared_ptr<const FileList> get_files() const;
+    // goes up every time a new list is published, lets users tell whether they have to redo their work
+    size_t get_version() const { return version.load(std::memory_order_acquire); }
+
+  private:
+    std::filesystem::path root_directory;
+    std::vector<std::string> ignored_directory_names;
+
+    mutable std::mutex published_files_mutex;
+    std::shared_ptr<const FileList> published_files;
+    std::atomic<size_t> version{0};
+    std::atomic<bool> initial_walk_is_done{false};
+
+    // only touched by the indexing thread
+    std::unordered_set<std::string> files;
+
+    std::atomic<bool> stop_requested{false};
+    std::thread indexing_thread;
+
+#if defined(__linux__)
+    int inotify_fd = -1;
+    // used to wake the indexing thread up when stopping
+    int stop_pipe_fds[2] = {-1, -1};
+    std::unordered_map<int, std::string> watch_descriptor_to_directory;
+
+    void watch_directory(const std::string &directory);
+    void watch_for_changes();
+    void remove_files_below(const std::string &directory);
+#endif
+
+    bool is_ignored_directory(const std::filesystem::path &directory) const;
+    void walk(const std::filesystem::path &directory);
+    void publish();
+    void run();
+};
+
+#endif // PROJECT_FILE_INDEX_HPP
@@ -0,0 +1,168 @@
+#include "ring_logger.hpp"
+
+#include <bit>
+#include <cstdio>
+#include <iostream>
+
+const char *log_level_to_string(LogLevel level) {
+    switch (level) {
+    case LogLevel::TRACE:
+        return "TRACE";
+    case LogLevel::DEBUG:
+        return "DEBUG";
+    case LogLevel::INFO:
+        return "INFO";
+    case LogLevel::WARNING:
+        return "WARNING";
+    case LogLevel::ERROR:
+        return "ERROR";
+    }
+    return "";
+}
+
+RingLogger::RingLogger(size_t capacity, std::chrono::milliseconds flush_interval)
+    : slots(std::make_unique<Slot[]>(std::bit_ceil(std::max<size_t>(capacity, 2)))),
+      slots_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1), flush_interval(flush_interval),
+      start_time(Clock::now()) {
+    for (size_t i = 0; i <= slots_mask; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+RingLogger::~RingLogger() { stop(); }
+
+bool RingLogger::start(const std::string &file_path) {
+    if (writer_thread.joinable()) {
+        return true;
+    }
+    file.open(file_path, std::ios::out | std::ios::trunc);
+    if (not file.is_open()) {
+        std::cerr << "Error: Unable to open log file " << file_path << "\n";
+        return false;
+    }
+    stop_requested = false;
+    writer_thread = std::thread([this] { run(); });
+    return true;
+}
+
+void RingLogger::stop() {
+    if (not writer_thread.joinable()) {
+        return;
+    }
+    stop_requested = true;
+    writer_thread.join();
+    if (get_num_dropped() > 0) {
+        file << get_num_dropped() << " log records were dropped because the ring was full\n";
+    }
+    file.close();
+}
+
+void RingLogger::run() {
+    std::string text;
+    while (not stop_requested.load()) {
+        if (not write_pending_records(text)) {
+            std::this_thread::sleep_for(flush_interval);
+        }
+    }
+    // whatever came in before stop was called
+    write_pending_records(text);
+}
+
+// fills in the {} of the format with the arguments in order, leftover arguments are left off and leftover {} stay
+static void format_record(const LogRecord &record, std::string &text) {
+    char number[32];
+    size_t payload_position = 0;
+    size_t num_arguments_left = record.num_arguments;
+
+    auto append_next_argument = [&] {
+        auto type = static_cast<LogRecord::ArgumentType>(record.payload[payload_position++]);
+        auto read = [&](auto &value) {
+            std::memcpy(&value, record.payload.data() + payload_position, sizeof(value));
+            payload_position += sizeof(value);
+        };
+        switch (type) {
+        case LogRecord::ArgumentType::SIGNED: {
+            int64_t value;
+            read(value);
+            std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(value));
+            text += number;
+            break;
+        }
+        case LogRecord::ArgumentType::UNSIGNED: {
+            uint64_t value;
+            read(value);
+            std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(value));
+            text += number;
+            break;
+        }
+        case LogRecord::ArgumentType::FLOATING: {
+            double value;
+            read(value);
+            std::snprintf(number, sizeof(number), "%g", value);
+            text += number;
+            break;
+        }
+        case LogRecord::ArgumentType::BOOLEAN: {
+            uint8_t value;
+            read(value);
+            text += value ? "true" : "false";
+            break;
+        }
+        case LogRecord::ArgumentType::CHARACTER: {
+            char value;
+            read(value);
+            text += value;
+            break;
+        }
+        case LogRecord::ArgumentType::STRING: {
+            uint16_t length;
+            read(length);
+            text.append(record.payload.data() + payload_position, length);
+            payload_position += length;
+            break;
+        }
+        }
+    };
+
+    std::snprintf(number, sizeof(number), "[%12.6f] ", static_cast<double>(record.timestamp_ns) / 1e9);
+    text += number;
+    text += log_level_to_string(record.level);
+    text += ": ";
+
+    for (const char *c = record.format; *c != '\0'; ++c) {
+        if (c[0] == '{' and c[1] == '}' and num_arguments_left > 0) {
+            append_next_argument();
+            --num_arguments_left;
+            ++c;
+        } else {
+            text += *c;
+        }
+    }
+    text += '\n';
+}
+
+bool RingLogger::write_pending_records(std::string &text) {
+    text.clear();
+    while (true) {
+        Slot &slot = slots[read_index & slots_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != read_index + 1) {
+            break;
+        }
+        format_record(slot.record, text);
+        // the slot can be reused as soon as it's turned into text
+        slot.sequence.store(read_index + slots_mask + 1, std::memory_order_release);
+        ++read_index;
+    }
+    if (text.empty()) {
+        return false;
+    }
+
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    file.flush();
+    return true;
+}
+
+RingLogger &global_logger() {
+    static RingLogger logger;
+    return logger;
+}
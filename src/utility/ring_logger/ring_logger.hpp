@@ -0,0 +1,211 @@
+#ifndef RING_LOGGER_HPP
+#define RING_LOGGER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+// clang-format off
+enum class LogLevel : uint8_t {
+    TRACE, DEBUG, INFO, WARNING, ERROR,
+};
+// clang-format on
+
+// anything below this level is compiled out, set it from the build with -DLOG_LEVEL_THRESHOLD=<0-4> (0 keeps
+// everything, 4 only keeps errors)
+#ifndef LOG_LEVEL_THRESHOLD
+#define LOG_LEVEL_THRESHOLD 2
+#endif
+
+const char *log_level_to_string(LogLevel level);
+
+// one log call, fixed size so the ring never allocates. Only the pointer to the format is stored so it has to be a
+// string literal, the arguments are copied into the payload as a type tag followed by their bytes and turned into
+// text by the writer thread. Strings that don't fit are cut off
+struct LogRecord {
+    static constexpr size_t SIZE = 256;
+
+    enum class ArgumentType : uint8_t { SIGNED, UNSIGNED, FLOATING, BOOLEAN, CHARACTER, STRING };
+
+    int64_t timestamp_ns;
+    const char *format;
+    LogLevel level;
+    uint8_t num_arguments;
+    uint16_t payload_size;
+    static constexpr size_t PAYLOAD_CAPACITY = SIZE - sizeof(int64_t) - sizeof(const char *) - sizeof(uint32_t);
+    std::array<char, PAYLOAD_CAPACITY> payload;
+
+    template <typename T> void add_argument(const T &value);
+
+  private:
+    bool add_bytes(const void *bytes, size_t num_bytes) {
+        if (payload_size + num_bytes > PAYLOAD_CAPACITY) {
+            return false;
+        }
+        std::memcpy(payload.data() + payload_size, bytes, num_bytes);
+        payload_size += static_cast<uint16_t>(num_bytes);
+        return true;
+    }
+
+    template <typename T> void add_tagged(ArgumentType type, T value) {
+        if (payload_size + 1 + sizeof(T) > PAYLOAD_CAPACITY) {
+            return;
+        }
+        add_bytes(&type, 1);
+        add_bytes(&value, sizeof(T));
+        ++num_arguments;
+    }
+
+    void add_string(std::string_view string) {
+        if (payload_size + 1 + sizeof(uint16_t) > PAYLOAD_CAPACITY) {
+            return;
+        }
+        auto length = static_cast<uint16_t>(
+            std::min(string.size(), PAYLOAD_CAPACITY - payload_size - 1 - sizeof(uint16_t)));
+        ArgumentType type = ArgumentType::STRING;
+        add_bytes(&type, 1);
+        add_bytes(&length, sizeof(length));
+        add_bytes(string.data(), length);
+        ++num_arguments;
+    }
+};
+
+static_assert(sizeof(LogRecord) == LogRecord::SIZE);
+
+template <typename T> void LogRecord::add_argument(const T &value) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        add_tagged(ArgumentType::BOOLEAN, static_cast<uint8_t>(value));
+    } else if constexpr (std::is_same_v<U, char>) {
+        add_tagged(ArgumentType::CHARACTER, value);
+    } else if constexpr (std::is_enum_v<U>) {
+        add_tagged(ArgumentType::SIGNED, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<U> and std::is_signed_v<U>) {
+        add_tagged(ArgumentType::SIGNED, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<U>) {
+        add_tagged(ArgumentType::UNSIGNED, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_floating_point_v<U>) {
+        add_tagged(ArgumentType::FLOATING, static_cast<double>(value));
+    } else if constexpr (std::is_same_v<U, const char *> or std::is_same_v<U, char *>) {
+        add_string(value == nullptr ? std::string_view("(null)") : std::string_view(value));
+    } else {
+        static_assert(std::is_convertible_v<const U &, std::string_view>,
+                      "only numbers, enums and strings can be logged");
+        add_string(std::string_view(value));
+    }
+}
+
+// takes log calls without ever blocking, locking or doing a syscall and writes them to a file from its own thread.
+// Any thread can log, each record goes into a slot of a ring that only the writer thread reads from. A logging thread
+// claims a slot by moving write_index forward with a compare exchange, fills it in and then publishes it through the
+// slot's sequence number, the writer takes slots in order for as long as they're published. When the ring is full
+// the record is dropped and counted instead of waiting for room. The writer doesn't get woken up, it looks at the
+// ring every flush_interval, turns what's there into text and writes it out in one go
+class RingLogger {
+  public:
+    // the capacity is rounded up to a power of two
+    explicit RingLogger(size_t capacity = 4096,
+                        std::chrono::milliseconds flush_interval = std::chrono::milliseconds(20));
+    ~RingLogger();
+
+    RingLogger(const RingLogger &) = delete;
+    RingLogger &operator=(const RingLogger &) = delete;
+
+    // truncates the file and starts the writer, records logged before this are written out once it starts
+    bool start(const std::string &file_path);
+    // writes out everything still in the ring and stops the writer
+    void stop();
+
+    template <typename... Args> void log(LogLevel level, const char *format, const Args &...args) {
+        size_t position = write_index.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[position & slots_mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::make_signed_t<size_t>>(sequence - position);
+            if (difference == 0) {
+                if (write_index.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // the slot still holds a record from the last time around that hasn't been written out
+                num_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                // another thread claimed this position first
+                position = write_index.load(std::memory_order_relaxed);
+            }
+        }
+
+        LogRecord &record = slot->record;
+        record.timestamp_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time).count();
+        record.format = format;
+        record.level = level;
+        record.num_arguments = 0;
+        record.payload_size = 0;
+        (record.add_argument(args), ...);
+
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    size_t get_num_dropped() const { return num_dropped.load(std::memory_order_relaxed); }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    // keeps the indices on their own cache lines so the threads don't fight over one
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // the sequence is the position the slot is free to be claimed at, one past that once its record is published, and
+    // it moves a whole lap ahead when the writer is done with the record
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t slots_mask;
+    std::chrono::milliseconds flush_interval;
+    Clock::time_point start_time;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_index = 0;
+    // only the writer thread touches this
+    alignas(CACHE_LINE_SIZE) size_t read_index = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> num_dropped = 0;
+
+    std::atomic<bool> stop_requested = false;
+    std::ofstream file;
+    std::thread writer_thread;
+
+    // returns whether there was anything to write
+    bool write_pending_records(std::string &text);
+    void run();
+};
+
+// the logger everything in the editor logs to
+RingLogger &global_logger();
+
+// NOTE: the arguments aren't even evaluated when the level is compiled out
+#define LOG_AT_LEVEL(level, ...)                                                                                       \
+    do {                                                                                                               \
+        if constexpr (static_cast<int>(level) >= LOG_LEVEL_THRESHOLD) {                                                \
+            global_logger().log(level, __VA_ARGS__);                                                                   \
+        }                                                                                                              \
+    } while (0)
+
+#define LOG_TRACE(...) LOG_AT_LEVEL(LogLevel::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT_LEVEL(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT_LEVEL(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT_LEVEL(LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT_LEVEL(LogLevel::ERROR, __VA_ARGS__)
+
+#endif // RING_LOGGER_HPP
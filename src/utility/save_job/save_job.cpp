@@ -0,0 +1,223 @@
+#include "save_job.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "../trace_recorder/trace_recorder.hpp"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// how much gets handed to the operating system per write, also how often the progress moves
+static constexpr size_t WRITE_BATCH_BYTES = 1 << 20;
+#if defined(IOV_MAX)
+static constexpr size_t MAX_BUFFERS_PER_WRITE = IOV_MAX;
+#else
+// the smallest IOV_MAX allowed by posix
+static constexpr size_t MAX_BUFFERS_PER_WRITE = 16;
+#endif
+
+SaveJob::~SaveJob() { wait(); }
+
+bool SaveJob::start(PieceTableSnapshot snapshot, const std::string &file_path) {
+    if (get_state() == State::RUNNING) {
+        return false;
+    }
+    wait();
+
+    this->snapshot = std::move(snapshot);
+    this->file_path = file_path;
+    num_bytes_total.store(0, std::memory_order_relaxed);
+    num_bytes_written.store(0, std::memory_order_relaxed);
+    error.clear();
+    start_time = std::chrono::steady_clock::now();
+    state.store(State::RUNNING, std::memory_order_release);
+
+    worker = std::thread(&SaveJob::run, this);
+    return true;
+}
+
+void SaveJob::wait() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+std::chrono::steady_clock::duration SaveJob::get_elapsed_time() const {
+    if (get_state() == State::RUNNING) {
+        return std::chrono::steady_clock::now() - start_time;
+    }
+    return std::chrono::steady_clock::duration(finished_elapsed_ticks.load(std::memory_order_relaxed));
+}
+
+double SaveJob::get_bytes_per_second() const {
+    double seconds = std::chrono::duration<double>(get_elapsed_time()).count();
+    if (seconds <= 0) {
+        return 0;
+    }
+    return get_num_bytes_written() / seconds;
+}
+
+void SaveJob::run() {
+    global_trace_recorder().set_current_thread_name("save");
+    ScopedTraceSpan span("save", "io");
+    std::string temporary_path = file_path + ".tbx_save_tmp";
+    bool succeeded = write_temporary_file(temporary_path);
+
+    if (succeeded) {
+        std::error_code error_code;
+        std::filesystem::rename(temporary_path, file_path, error_code);
+        if (error_code) {
+            error = "unable to replace " + file_path + ": " + error_code.message();
+            succeeded = false;
+        }
+    }
+
+    if (succeeded) {
+#if !defined(_WIN32) && !defined(_WIN64)
+        // the rename itself only survives a crash once the directory holding the file is on disk as well
+        std::string directory = std::filesystem::path(file_path).parent_path().string();
+        int directory_descriptor = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+        if (directory_descriptor >= 0) {
+            ::fsync(directory_descriptor);
+            ::close(directory_descriptor);
+        }
+#endif
+    } else {
+        std::error_code error_code;
+        std::filesystem::remove(temporary_path, error_code);
+    }
+
+    // the text is on disk (or not going to be), the bytes don't need to be kept alive for it anymore
+    snapshot = {};
+
+    finished_elapsed_ticks.store((std::chrono::steady_clock::now() - start_time).count(), std::memory_order_relaxed);
+    state.store(succeeded ? State::SUCCEEDED : State::FAILED, std::memory_order_release);
+}
+
+bool SaveJob::write_temporary_file(const std::string &temporary_path) {
+#if defined(_WIN32) || defined(_WIN64)
+    int descriptor = ::_open(temporary_path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    // the new file gets the permissions of the one it replaces
+    mode_t mode = 0644;
+    struct stat existing_file_status;
+    bool file_exists = ::stat(file_path.c_str(), &existing_file_status) == 0;
+    if (file_exists) {
+        mode = existing_file_status.st_mode & 07777;
+    }
+    int descriptor = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    if (descriptor >= 0 and file_exists) {
+        ::fchmod(descriptor, mode);
+    }
+#endif
+    if (descriptor < 0) {
+        error = "unable to open " + temporary_path + " for writing: " + std::strerror(errno);
+        return false;
+    }
+
+    // the chunks are cut into slices of at most one batch and written a batch at a time
+    struct Slice {
+        const char *data;
+        size_t size;
+    };
+    std::vector<Slice> batch;
+    size_t batch_size = 0;
+
+    auto write_batch = [&]() {
+        size_t first_unwritten = 0;
+        while (first_unwritten < batch.size()) {
+#if defined(_WIN32) || defined(_WIN64)
+            Slice &slice = batch[first_unwritten];
+            auto num_written = ::_write(descriptor, slice.data, static_cast<unsigned int>(slice.size));
+#else
+            iovec buffers[MAX_BUFFERS_PER_WRITE];
+            size_t num_buffers = std::min(batch.size() - first_unwritten, MAX_BUFFERS_PER_WRITE);
+            for (size_t i = 0; i < num_buffers; ++i) {
+                buffers[i].iov_base = const_cast<char *>(batch[first_unwritten + i].data);
+                buffers[i].iov_len = batch[first_unwritten + i].size;
+            }
+            auto num_written = ::writev(descriptor, buffers, static_cast<int>(num_buffers));
+#endif
+            if (num_written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+
+            num_bytes_written.fetch_add(num_written, std::memory_order_relaxed);
+
+            // a write can stop partway through, the rest of the slice it stopped in goes out with the next one
+            size_t remaining = static_cast<size_t>(num_written);
+            while (remaining > 0) {
+                Slice &slice = batch[first_unwritten];
+                size_t taken = std::min(remaining, slice.size);
+                slice.data += taken;
+                slice.size -= taken;
+                remaining -= taken;
+                if (slice.size == 0) {
+                    ++first_unwritten;
+                }
+            }
+        }
+        batch.clear();
+        batch_size = 0;
+        return true;
+    };
+
+    // working out the chunks walks the whole rope, that happens here so taking the snapshot stays cheap
+    std::vector<std::string_view> chunks = snapshot.get_chunks();
+    size_t total = 0;
+    for (std::string_view chunk : chunks) {
+        total += chunk.size();
+    }
+    num_bytes_total.store(total, std::memory_order_relaxed);
+
+    bool succeeded = true;
+    for (std::string_view chunk : chunks) {
+        while (succeeded and not chunk.empty()) {
+            size_t slice_size = std::min(chunk.size(), WRITE_BATCH_BYTES - batch_size);
+            batch.push_back({chunk.data(), slice_size});
+            batch_size += slice_size;
+            chunk.remove_prefix(slice_size);
+            if (batch_size == WRITE_BATCH_BYTES) {
+                succeeded = write_batch();
+            }
+        }
+    }
+    if (succeeded) {
+        succeeded = write_batch();
+    }
+    if (not succeeded) {
+        error = "unable to write " + temporary_path + ": " + std::strerror(errno);
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    if (succeeded and ::_commit(descriptor) != 0) {
+#else
+    if (succeeded and ::fsync(descriptor) != 0) {
+#endif
+        error = "unable to sync " + temporary_path + " to disk: " + std::strerror(errno);
+        succeeded = false;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    ::_close(descriptor);
+#else
+    ::close(descriptor);
+#endif
+    return succeeded;
+}
@@ -0,0 +1,58 @@
+#ifndef SAVE_JOB_HPP
+#define SAVE_JOB_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+#include "../piece_table/piece_table.hpp"
+
+// writes a snapshot of a buffer to disk on a worker thread, so saving a big file never holds up input.
+//
+// the text goes into a temporary file next to the target in large batches (gathered with writev where there is one),
+// the temporary file is synced to disk and only then renamed over the target, so at any moment the file on disk is
+// either entirely the old version or entirely the new one.
+class SaveJob {
+  public:
+    enum class State { IDLE, RUNNING, SUCCEEDED, FAILED };
+
+    SaveJob() = default;
+    ~SaveJob();
+
+    SaveJob(const SaveJob &) = delete;
+    SaveJob &operator=(const SaveJob &) = delete;
+
+    // false when the previous save is still running
+    bool start(PieceTableSnapshot snapshot, const std::string &file_path);
+    void wait();
+
+    State get_state() const { return state.load(std::memory_order_acquire); }
+    size_t get_num_bytes_written() const { return num_bytes_written.load(std::memory_order_relaxed); }
+    // zero until the worker has gone through the snapshot
+    size_t get_num_bytes_total() const { return num_bytes_total.load(std::memory_order_relaxed); }
+    // while running this is the time so far, afterwards the time the whole save took
+    std::chrono::steady_clock::duration get_elapsed_time() const;
+    double get_bytes_per_second() const;
+    // why the save failed, only meaningful once the state is FAILED
+    const std::string &get_error() const { return error; }
+
+  private:
+    PieceTableSnapshot snapshot;
+    std::string file_path;
+    std::chrono::steady_clock::time_point start_time;
+
+    std::atomic<State> state{State::IDLE};
+    std::atomic<size_t> num_bytes_total{0};
+    std::atomic<size_t> num_bytes_written{0};
+    std::atomic<std::chrono::steady_clock::rep> finished_elapsed_ticks{0};
+    // only written by the worker before it publishes FAILED
+    std::string error;
+    std::thread worker;
+
+    void run();
+    bool write_temporary_file(const std::string &temporary_path);
+};
+
+#endif // SAVE_JOB_HPP
@@ -0,0 +1,150 @@
+#include "search_job.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// looking at the clock is not free, it only happens once every this many lines
+static constexpr int LINES_BETWEEN_CLOCK_CHECKS = 256;
+
+void SearchJob::start(const LineTextBuffer &buffer, const std::string &query, int start_line) {
+    this->buffer = &buffer;
+    this->query = query;
+    pattern.emplace(query);
+    modification_count_at_start = buffer.get_modification_count();
+
+    this->start_line = std::clamp(start_line, 0, std::max(buffer.line_count() - 1, 0));
+    next_line_to_scan = this->start_line;
+    wrapped_around = false;
+    complete = pattern->is_empty();
+
+    matches_before_start_line.clear();
+    matches_from_start_line.clear();
+}
+
+void SearchJob::cancel() {
+    buffer = nullptr;
+    query.clear();
+    pattern.reset();
+    complete = false;
+    matches_before_start_line.clear();
+    matches_from_start_line.clear();
+}
+
+bool SearchJob::is_stale(const LineTextBuffer *current_buffer) const {
+    return buffer != current_buffer or buffer->get_modification_count() != modification_count_at_start;
+}
+
+bool SearchJob::run_for(std::chrono::microseconds time_budget) {
+    if (buffer == nullptr or complete) {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + time_budget;
+
+    for (int num_lines_scanned = 0;; ++num_lines_scanned) {
+        if (num_lines_scanned > 0 and num_lines_scanned % LINES_BETWEEN_CLOCK_CHECKS == 0 and
+            std::chrono::steady_clock::now() >= deadline) {
+            return true;
+        }
+
+        if (not wrapped_around and next_line_to_scan >= buffer->line_count()) {
+            // a big file can still be getting indexed, more lines will show up later
+            if (buffer->is_still_indexing()) {
+                return true;
+            }
+            wrapped_around = true;
+            next_line_to_scan = 0;
+        }
+
+        if (wrapped_around and next_line_to_scan >= start_line) {
+            complete = true;
+            return false;
+        }
+
+        int line = next_line_to_scan;
+        auto &matches = wrapped_around ? matches_before_start_line : matches_from_start_line;
+        pattern->for_each_match_in_line(buffer->get_line(line), 0, [&](size_t match_start, size_t match_end) {
+            matches.push_back({line, static_cast<int>(match_start), static_cast<int>(match_end)});
+        });
+        ++next_line_to_scan;
+    }
+}
+
+const SearchJob::Match &SearchJob::get_match(size_t index) const {
+    if (index < matches_before_start_line.size()) {
+        return matches_before_start_line[index];
+    }
+    return matches_from_start_line[index - matches_before_start_line.size()];
+}
+
+// the unscanned lines are always one stretch: before wrapping around it's everything below the scan plus everything
+// above the start line, after wrapping it's what's left between the scan and the start line
+bool SearchJob::has_unscanned_lines_between(int first_line, int last_line) const {
+    if (complete) {
+        return false;
+    }
+    if (not wrapped_around) {
+        return last_line >= next_line_to_scan or first_line < start_line;
+    }
+    return first_line < start_line and last_line >= next_line_to_scan;
+}
+
+std::optional<SearchJob::Match> SearchJob::find_closest_match(int line, int col, Direction direction) const {
+    size_t num_matches = get_num_matches();
+    if (num_matches == 0) {
+        return std::nullopt;
+    }
+
+    constexpr int LAST_POSSIBLE_LINE = std::numeric_limits<int>::max();
+
+    // the number of matches that come before the position, binary searched through both halves at once
+    auto count_matches_before = [&](bool include_matches_at_position) {
+        size_t low = 0;
+        size_t high = num_matches;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            const Match &match = get_match(middle);
+            bool is_before = match.line < line or (match.line == line and (match.start_col < col or
+                                                                            (include_matches_at_position and
+                                                                             match.start_col == col)));
+            if (is_before) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+
+    if (direction == Direction::FORWARD) {
+        size_t first_after = count_matches_before(true);
+        if (first_after < num_matches) {
+            const Match &match = get_match(first_after);
+            if (has_unscanned_lines_between(line, match.line)) {
+                return std::nullopt;
+            }
+            return match;
+        }
+        // nothing below, wrap around to the first match of the buffer
+        const Match &match = get_match(0);
+        if (has_unscanned_lines_between(line, LAST_POSSIBLE_LINE) or has_unscanned_lines_between(0, match.line)) {
+            return std::nullopt;
+        }
+        return match;
+    }
+
+    size_t num_before = count_matches_before(false);
+    if (num_before > 0) {
+        const Match &match = get_match(num_before - 1);
+        if (has_unscanned_lines_between(match.line, line)) {
+            return std::nullopt;
+        }
+        return match;
+    }
+    // nothing above, wrap around to the last match of the buffer
+    const Match &match = get_match(num_matches - 1);
+    if (has_unscanned_lines_between(0, line) or has_unscanned_lines_between(match.line, LAST_POSSIBLE_LINE)) {
+        return std::nullopt;
+    }
+    return match;
+}
@@ -0,0 +1,71 @@
+#ifndef SEARCH_JOB_HPP
+#define SEARCH_JOB_HPP
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../search_pattern/search_pattern.hpp"
+#include "../text_buffer/text_buffer.hpp"
+
+// a / search over a whole buffer that is done a bit at a time, so that a search with hundreds of thousands of matches
+// never holds up the editor. The scan starts at the line the search was started from, goes down to the end of the
+// buffer and then wraps around to the top, that way the matches close to the cursor are the first ones to show up.
+//
+// matches are only stored as a line and two columns, nothing is copied out of the buffer.
+//
+// NOTE: the buffer can't be read from another thread while it is being edited, so for now the job doesn't get a thread
+// of its own, instead it is given a slice of time on the ui thread every frame (see run_for)
+class SearchJob {
+  public:
+    struct Match {
+        int line;
+        int start_col;
+        int end_col;
+    };
+
+    enum class Direction { FORWARD, BACKWARD };
+
+    void start(const LineTextBuffer &buffer, const std::string &query, int start_line);
+    void cancel();
+
+    // scans lines until the time budget is used up, returns true if there is still work left to do
+    bool run_for(std::chrono::microseconds time_budget);
+
+    // there is a search, it might still be scanning
+    bool is_active() const { return buffer != nullptr; }
+    bool is_complete() const { return complete; }
+    // the buffer was swapped out or edited since the search started, the matches don't line up with the text anymore
+    bool is_stale(const LineTextBuffer *current_buffer) const;
+
+    const std::string &get_query() const { return query; }
+    size_t get_num_matches() const { return matches_before_start_line.size() + matches_from_start_line.size(); }
+
+    // the closest match strictly after (or before) the position, wrapping around the ends of the buffer. While the scan
+    // is still going a match is only given back once no closer one can show up anymore, so nullopt means either there
+    // are no matches at all (when the job is complete) or that it's too early to tell
+    std::optional<Match> find_closest_match(int line, int col, Direction direction) const;
+
+  private:
+    const LineTextBuffer *buffer = nullptr;
+    std::string query;
+    std::optional<SearchPattern> pattern;
+    size_t modification_count_at_start = 0;
+
+    int start_line = 0;
+    int next_line_to_scan = 0;
+    bool wrapped_around = false;
+    bool complete = false;
+
+    // both are sorted, and every match in the first one comes before every match in the second one
+    std::vector<Match> matches_before_start_line;
+    std::vector<Match> matches_from_start_line;
+
+    // the matches in order through the whole buffer
+    const Match &get_match(size_t index) const;
+    // whether any of the lines from first_line to last_line (inclusive) still has to be scanned
+    bool has_unscanned_lines_between(int first_line, int last_line) const;
+};
+
+#endif // SEARCH_JOB_HPP
@@ -0,0 +1,426 @@
+#include "search_pattern.hpp"
+
+#include <cctype>
+#include <cstring>
+
+SearchPattern::SearchPattern(const std::string &query) {
+    if (not compile(query)) {
+        literal = true;
+        literal_text = query;
+        program.clear();
+    }
+}
+
+static bool is_word_character(char c) { return std::isalnum(static_cast<unsigned char>(c)) or c == '_'; }
+
+// the parsed query is a list of alternatives, each one a list of atoms, an atom matches a single character or is an
+// assertion and can be repeated by a quantifier
+bool SearchPattern::compile(const std::string &query) {
+    struct Quantifier {
+        char repeat;
+        bool lazy;
+    };
+    struct Atom {
+        Instruction instruction;
+        // applied inside out, a+* is (a+)*
+        std::vector<Quantifier> quantifiers;
+    };
+
+    auto is_assertion = [](Opcode opcode) {
+        return opcode == Opcode::START_OF_LINE or opcode == Opcode::END_OF_LINE or opcode == Opcode::WORD_BOUNDARY or
+               opcode == Opcode::NOT_WORD_BOUNDARY;
+    };
+
+    std::vector<std::vector<Atom>> alternatives(1);
+
+    for (size_t i = 0; i < query.size(); ++i) {
+        char c = query[i];
+        Instruction instruction{Opcode::CHARACTER, c};
+
+        switch (c) {
+        case '|':
+            alternatives.emplace_back();
+            continue;
+        case '*':
+        case '+':
+        case '?': {
+            auto &atoms = alternatives.back();
+            // nothing to repeat, this is an error for std::regex as well
+            if (atoms.empty() or is_assertion(atoms.back().instruction.opcode)) {
+                return false;
+            }
+            bool lazy = i + 1 < query.size() and query[i + 1] == '?';
+            if (lazy) {
+                ++i;
+            }
+            atoms.back().quantifiers.push_back({c, lazy});
+            continue;
+        }
+        case '.':
+            instruction.opcode = Opcode::ANY_CHARACTER;
+            break;
+        case '^':
+            instruction.opcode = Opcode::START_OF_LINE;
+            break;
+        case '$':
+            instruction.opcode = Opcode::END_OF_LINE;
+            break;
+        case '\\': {
+            if (i + 1 == query.size()) {
+                return false;
+            }
+            char escaped = query[++i];
+            instruction.character = escaped;
+            instruction.negated = std::isupper(static_cast<unsigned char>(escaped));
+            switch (std::tolower(static_cast<unsigned char>(escaped))) {
+            case 'd':
+                instruction.opcode = Opcode::DIGIT;
+                break;
+            case 'w':
+                instruction.opcode = Opcode::WORD_CHARACTER;
+                break;
+            case 's':
+                instruction.opcode = Opcode::WHITESPACE;
+                break;
+            case 'b':
+                instruction.opcode = escaped == 'b' ? Opcode::WORD_BOUNDARY : Opcode::NOT_WORD_BOUNDARY;
+                break;
+            case 't':
+                instruction.character = escaped == 't' ? '\t' : escaped;
+                instruction.negated = false;
+                break;
+            default:
+                instruction.negated = false;
+                break;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        alternatives.back().push_back({instruction, {}});
+    }
+
+    // plain text, possibly with some escaped characters, doesn't need the vm at all
+    bool only_plain_characters = alternatives.size() == 1;
+    for (const auto &atom : alternatives.front()) {
+        only_plain_characters = only_plain_characters and atom.instruction.opcode == Opcode::CHARACTER and
+                                atom.quantifiers.empty();
+    }
+    if (only_plain_characters) {
+        literal = true;
+        literal_text.clear();
+        for (const auto &atom : alternatives.front()) {
+            literal_text += atom.instruction.character;
+        }
+        return true;
+    }
+
+    literal = false;
+    program.clear();
+
+    auto emit = [&](Instruction instruction) {
+        program.push_back(instruction);
+        return static_cast<int>(program.size()) - 1;
+    };
+
+    // emits the atom with its first num_quantifiers quantifiers applied
+    auto emit_quantified = [&](auto &self, const Atom &atom, size_t num_quantifiers) -> void {
+        if (num_quantifiers == 0) {
+            emit(atom.instruction);
+            return;
+        }
+
+        const Quantifier &quantifier = atom.quantifiers[num_quantifiers - 1];
+        switch (quantifier.repeat) {
+        case '*': {
+            int loop_split = emit({Opcode::SPLIT});
+            self(self, atom, num_quantifiers - 1);
+            emit({Opcode::JUMP, 0, false, loop_split});
+            int after = static_cast<int>(program.size());
+            program[loop_split].target = quantifier.lazy ? after : loop_split + 1;
+            program[loop_split].alternative_target = quantifier.lazy ? loop_split + 1 : after;
+            break;
+        }
+        case '+': {
+            int body = static_cast<int>(program.size());
+            self(self, atom, num_quantifiers - 1);
+            int loop_split = emit({Opcode::SPLIT});
+            int after = static_cast<int>(program.size());
+            program[loop_split].target = quantifier.lazy ? after : body;
+            program[loop_split].alternative_target = quantifier.lazy ? body : after;
+            break;
+        }
+        default: {
+            int optional_split = emit({Opcode::SPLIT});
+            self(self, atom, num_quantifiers - 1);
+            int after = static_cast<int>(program.size());
+            program[optional_split].target = quantifier.lazy ? after : optional_split + 1;
+            program[optional_split].alternative_target = quantifier.lazy ? optional_split + 1 : after;
+            break;
+        }
+        }
+    };
+
+    std::vector<int> jumps_to_match;
+    for (size_t alternative_index = 0; alternative_index < alternatives.size(); ++alternative_index) {
+        bool is_last_alternative = alternative_index + 1 == alternatives.size();
+
+        int split = -1;
+        if (not is_last_alternative) {
+            split = emit({Opcode::SPLIT});
+            program[split].target = split + 1;
+        }
+
+        for (const auto &atom : alternatives[alternative_index]) {
+            emit_quantified(emit_quantified, atom, atom.quantifiers.size());
+        }
+
+        if (not is_last_alternative) {
+            jumps_to_match.push_back(emit({Opcode::JUMP}));
+            program[split].alternative_target = static_cast<int>(program.size());
+        }
+    }
+
+    int match = emit({Opcode::MATCH});
+    for (int jump : jumps_to_match) {
+        program[jump].target = match;
+    }
+
+    compute_match_start_filter();
+    current_threads.added_in_generation.assign(program.size(), 0);
+    next_threads.added_in_generation.assign(program.size(), 0);
+    return true;
+}
+
+bool SearchPattern::find_in_line(std::string_view line, size_t from_col, size_t &match_start,
+                                 size_t &match_end) const {
+    if (from_col > line.size()) {
+        return false;
+    }
+    if (literal) {
+        return find_literal(line, from_col, match_start, match_end);
+    }
+    return find_with_program(line, from_col, match_start, match_end);
+}
+
+bool SearchPattern::find_literal(std::string_view line, size_t from_col, size_t &match_start,
+                                 size_t &match_end) const {
+    if (literal_text.empty()) {
+        return false;
+    }
+
+    const char *haystack = line.data() + from_col;
+    size_t haystack_size = line.size() - from_col;
+    const char *found = nullptr;
+
+    // NOTE: these are vectorized by the standard library, memmem is a two way search in glibc
+    if (literal_text.size() == 1) {
+        found = static_cast<const char *>(std::memchr(haystack, literal_text[0], haystack_size));
+    } else {
+#if defined(__GLIBC__)
+        found = static_cast<const char *>(memmem(haystack, haystack_size, literal_text.data(), literal_text.size()));
+#else
+        size_t position = std::string_view(haystack, haystack_size).find(literal_text);
+        found = position == std::string_view::npos ? nullptr : haystack + position;
+#endif
+    }
+
+    if (found == nullptr) {
+        return false;
+    }
+    match_start = found - line.data();
+    match_end = match_start + literal_text.size();
+    return true;
+}
+
+bool SearchPattern::consumes(const Instruction &instruction, char c) {
+    switch (instruction.opcode) {
+    case Opcode::CHARACTER:
+        return c == instruction.character;
+    case Opcode::ANY_CHARACTER:
+        return c != '\n' and c != '\r';
+    case Opcode::DIGIT:
+        return static_cast<bool>(std::isdigit(static_cast<unsigned char>(c))) != instruction.negated;
+    case Opcode::WORD_CHARACTER:
+        return is_word_character(c) != instruction.negated;
+    case Opcode::WHITESPACE:
+        return static_cast<bool>(std::isspace(static_cast<unsigned char>(c))) != instruction.negated;
+    default:
+        return false;
+    }
+}
+
+// when every match has to start with a character (no assertions or empty matches up front) the positions that can't
+// start one are skipped without running the vm at all, this is what keeps most regex searches close to the literal ones
+void SearchPattern::compute_match_start_filter() {
+    can_skip_to_match_start = true;
+    can_start_match.fill(false);
+
+    std::vector<bool> visited(program.size(), false);
+    std::vector<int> to_visit = {0};
+    while (not to_visit.empty()) {
+        int index = to_visit.back();
+        to_visit.pop_back();
+        if (visited[index]) {
+            continue;
+        }
+        visited[index] = true;
+
+        const Instruction &instruction = program[index];
+        if (instruction.opcode == Opcode::JUMP) {
+            to_visit.push_back(instruction.target);
+        } else if (instruction.opcode == Opcode::SPLIT) {
+            to_visit.push_back(instruction.target);
+            to_visit.push_back(instruction.alternative_target);
+        } else if (instruction.opcode == Opcode::CHARACTER or instruction.opcode == Opcode::ANY_CHARACTER or
+                   instruction.opcode == Opcode::DIGIT or instruction.opcode == Opcode::WORD_CHARACTER or
+                   instruction.opcode == Opcode::WHITESPACE) {
+            for (int c = 0; c < 256; ++c) {
+                can_start_match[c] = can_start_match[c] or consumes(instruction, static_cast<char>(c));
+            }
+        } else {
+            can_skip_to_match_start = false;
+            return;
+        }
+    }
+
+    only_start_character = -1;
+    int num_start_characters = 0;
+    for (int c = 0; c < 256; ++c) {
+        if (can_start_match[c]) {
+            ++num_start_characters;
+            only_start_character = c;
+        }
+    }
+    if (num_start_characters != 1) {
+        only_start_character = -1;
+    }
+}
+
+size_t SearchPattern::find_possible_match_start(std::string_view line, size_t position) const {
+    if (not can_skip_to_match_start) {
+        return position;
+    }
+    if (only_start_character >= 0) {
+        const void *found = std::memchr(line.data() + position, only_start_character, line.size() - position);
+        return found == nullptr ? std::string_view::npos : static_cast<const char *>(found) - line.data();
+    }
+    for (; position < line.size(); ++position) {
+        if (can_start_match[static_cast<unsigned char>(line[position])]) {
+            return position;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// follows jumps, splits and assertions from the instruction until reaching instructions that consume a character (or
+// the match), those become threads. The order in which they get added is their priority
+void SearchPattern::add_thread(ThreadList &threads, int instruction_index, size_t match_start, std::string_view line,
+                               size_t position) const {
+    instructions_to_visit.clear();
+    instructions_to_visit.push_back(instruction_index);
+
+    while (not instructions_to_visit.empty()) {
+        int index = instructions_to_visit.back();
+        instructions_to_visit.pop_back();
+
+        if (threads.added_in_generation[index] == threads.generation) {
+            continue;
+        }
+        threads.added_in_generation[index] = threads.generation;
+
+        const Instruction &instruction = program[index];
+        bool at_word_boundary = false;
+        if (instruction.opcode == Opcode::WORD_BOUNDARY or instruction.opcode == Opcode::NOT_WORD_BOUNDARY) {
+            bool word_before = position > 0 and is_word_character(line[position - 1]);
+            bool word_after = position < line.size() and is_word_character(line[position]);
+            at_word_boundary = word_before != word_after;
+        }
+
+        switch (instruction.opcode) {
+        case Opcode::JUMP:
+            instructions_to_visit.push_back(instruction.target);
+            break;
+        case Opcode::SPLIT:
+            // pushed in reverse so the preferred target gets explored first
+            instructions_to_visit.push_back(instruction.alternative_target);
+            instructions_to_visit.push_back(instruction.target);
+            break;
+        case Opcode::START_OF_LINE:
+            if (position == 0) {
+                instructions_to_visit.push_back(index + 1);
+            }
+            break;
+        case Opcode::END_OF_LINE:
+            if (position == line.size()) {
+                instructions_to_visit.push_back(index + 1);
+            }
+            break;
+        case Opcode::WORD_BOUNDARY:
+        case Opcode::NOT_WORD_BOUNDARY:
+            if (at_word_boundary == (instruction.opcode == Opcode::WORD_BOUNDARY)) {
+                instructions_to_visit.push_back(index + 1);
+            }
+            break;
+        default:
+            threads.instruction_indices.push_back(index);
+            threads.match_starts.push_back(match_start);
+            break;
+        }
+    }
+}
+
+bool SearchPattern::find_with_program(std::string_view line, size_t from_col, size_t &match_start,
+                                      size_t &match_end) const {
+    bool found_match = false;
+    current_threads.clear();
+    next_threads.clear();
+
+    for (size_t position = from_col;; ++position) {
+        if (current_threads.instruction_indices.empty()) {
+            if (found_match) {
+                break;
+            }
+            position = find_possible_match_start(line, position);
+            if (position == std::string_view::npos) {
+                return false;
+            }
+            add_thread(current_threads, 0, position, line, position);
+        }
+
+        for (size_t i = 0; i < current_threads.instruction_indices.size(); ++i) {
+            const Instruction &instruction = program[current_threads.instruction_indices[i]];
+            if (instruction.opcode == Opcode::MATCH) {
+                // everything after this thread has lower priority and can't win anymore
+                found_match = true;
+                match_start = current_threads.match_starts[i];
+                match_end = position;
+                break;
+            }
+            if (position < line.size() and consumes(instruction, line[position])) {
+                add_thread(next_threads, current_threads.instruction_indices[i] + 1, current_threads.match_starts[i],
+                           line, position + 1);
+            }
+        }
+
+        if (position == line.size()) {
+            break;
+        }
+
+        // a match starting further right only matters if nothing to the left matched, and if nothing is in progress
+        // the start of the next possible match gets looked for at the top of the loop instead
+        bool next_position_can_start_match =
+            not can_skip_to_match_start or
+            (position + 1 < line.size() and can_start_match[static_cast<unsigned char>(line[position + 1])]);
+        if (not found_match and not next_threads.instruction_indices.empty() and next_position_can_start_match) {
+            add_thread(next_threads, 0, position + 1, line, position + 1);
+        }
+
+        std::swap(current_threads, next_threads);
+        next_threads.clear();
+    }
+
+    return found_match;
+}
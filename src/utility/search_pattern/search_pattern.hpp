@@ -0,0 +1,122 @@
+#ifndef SEARCH_PATTERN_HPP
+#define SEARCH_PATTERN_HPP
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// a search query compiled once up front so that it can be run over every line of a file without doing any work per
+// line other than the actual matching.
+//
+// the syntax is a small part of ecmascript regex, the same thing / search accepted when it went through std::regex
+// with its brackets escaped:
+//   - round, square and curly brackets are plain characters
+//   - . matches any character, \d \w \s and \D \W \S match the usual classes
+//   - * + ? repeat what comes before them, adding a ? after makes them lazy
+//   - | separates alternatives, ^ and $ match at the start and end of the line, \b \B match (non) word boundaries
+//   - a backslash in front of anything else makes it a plain character
+//
+// queries without any of those special characters (the common case) never touch the matching machine, they go through
+// memchr/memmem. Everything else is compiled into a list of instructions that is run as a pike vm, it advances every
+// possible way of matching at the same time so it takes time linear in the length of the line no matter the pattern,
+// and it gives back the same match a backtracking regex would.
+//
+// a query that doesn't parse (like one starting with *) is searched for as plain text instead.
+//
+// NOTE: matching reuses some scratch space inside of the pattern, so one pattern must not be used by two threads at
+// once
+class SearchPattern {
+  public:
+    explicit SearchPattern(const std::string &query);
+
+    bool is_literal() const { return literal; }
+    // an empty query matches nothing
+    bool is_empty() const { return literal and literal_text.empty(); }
+
+    // finds the first match in the line starting at or after from_col
+    bool find_in_line(std::string_view line, size_t from_col, size_t &match_start, size_t &match_end) const;
+
+    // every non overlapping match in the line from left to right starting at from_col, the function gets the start and
+    // end column of each match
+    template <typename Function>
+    void for_each_match_in_line(std::string_view line, size_t from_col, Function &&function) const {
+        size_t match_start, match_end;
+        while (from_col <= line.size() and find_in_line(line, from_col, match_start, match_end)) {
+            function(match_start, match_end);
+            // an empty match would be found again and again, step over it
+            from_col = match_end > match_start ? match_end : match_end + 1;
+        }
+    }
+
+  private:
+    bool literal = true;
+    std::string literal_text;
+
+    enum class Opcode {
+        CHARACTER,
+        ANY_CHARACTER,
+        DIGIT,
+        WORD_CHARACTER,
+        WHITESPACE,
+        START_OF_LINE,
+        END_OF_LINE,
+        WORD_BOUNDARY,
+        NOT_WORD_BOUNDARY,
+        // continue at target
+        JUMP,
+        // try target first, then alternative_target
+        SPLIT,
+        MATCH,
+    };
+
+    struct Instruction {
+        Opcode opcode;
+        char character = 0;
+        // for the classes, matches everything the class doesn't
+        bool negated = false;
+        int target = 0;
+        int alternative_target = 0;
+    };
+
+    std::vector<Instruction> program;
+
+    // which characters the first instruction of a match can consume, only usable if every match consumes one
+    bool can_skip_to_match_start = false;
+    std::array<bool, 256> can_start_match{};
+    // set when only one character can start a match, then memchr finds the next start
+    int only_start_character = -1;
+
+    bool compile(const std::string &query);
+    bool find_literal(std::string_view line, size_t from_col, size_t &match_start, size_t &match_end) const;
+    bool find_with_program(std::string_view line, size_t from_col, size_t &match_start, size_t &match_end) const;
+
+    static bool consumes(const Instruction &instruction, char c);
+    void compute_match_start_filter();
+    // the first position at or after the given one where a match could start, npos if there is none
+    size_t find_possible_match_start(std::string_view line, size_t position) const;
+
+    // the threads of the vm, each one is at some instruction and remembers where its match started, they are kept in
+    // order of priority and there is at most one per instruction
+    struct ThreadList {
+        std::vector<int> instruction_indices;
+        std::vector<size_t> match_starts;
+        std::vector<size_t> added_in_generation;
+        size_t generation = 1;
+
+        void clear() {
+            instruction_indices.clear();
+            match_starts.clear();
+            ++generation;
+        }
+    };
+    mutable ThreadList current_threads;
+    mutable ThreadList next_threads;
+    mutable std::vector<int> instructions_to_visit;
+
+    void add_thread(ThreadList &threads, int instruction_index, size_t match_start, std::string_view line,
+                    size_t position) const;
+};
+
+#endif // SEARCH_PATTERN_HPP
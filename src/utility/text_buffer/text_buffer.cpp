@@ -1,26 +1,64 @@
 #include "text_buffer.hpp"
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <glm/matrix.hpp>
-#include <iostream>
 #include <iterator>
-#include <regex>
+#include <utility>
+
+#include "../allocation_tracker/allocation_tracker.hpp"
+#include "../perf_probes/perf_probes.hpp"
+#include "../ring_logger/ring_logger.hpp"
+#include "../trace_recorder/trace_recorder.hpp"
 
 bool LineTextBuffer::load_file(const std::string &file_path) {
+    ScopedTraceSpan span("load file", "io");
+    ScopedAllocationTag allocation_tag(AllocationTag::BUFFER);
+    std::error_code error_code;
+    auto file_size_on_disk = std::filesystem::file_size(file_path, error_code);
+
+    // big files get mapped, the first screen can be drawn right away while the rest of the lines are indexed
+    if (!error_code and file_size_on_disk >= MEMORY_MAPPED_LOAD_THRESHOLD_BYTES) {
+        if (lines.load_mapped(file_path)) {
+            bracket_depth_index.clear();
+            undo_history.clear();
+            undo_journal.open(file_path, undo_history);
+            current_file_path = file_path;
+            unrendered_modifications.clear();
+            all_lines_modified_since_last_render = true;
+            ++modification_count;
+            edit_signal.toggle_state();
+            return true;
+        }
+        // fall back to reading the file normally
+    }
+
     std::ifstream file(file_path);
     if (!file.is_open()) {
-        std::cerr << "Error: Unable to open file " << file_path << "\n";
+        LOG_ERROR("Unable to open file {}", file_path);
         return false;
     }
 
-    lines.clear();
-    std::string line;
-    // std::getline is used to read a line of text from an input stream (such as std::cin) into a
-    // string. It reads characters until a newline character ('\n') is encountered, at which point it stops reading and
-    // stores the characters in the provided string. The newline character is not stored.
-    while (std::getline(file, line)) {
-        lines.push_back(line);
-    }
+    // read the whole file in one go, the piece table takes ownership of these bytes and splits them into lines
+    // without copying them into per line strings
+    file.seekg(0, std::ios::end);
+    std::streamsize file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    std::string content;
+    content.resize(std::max<std::streamsize>(file_size, 0));
+    file.read(content.data(), file_size);
+    // NOTE: in text mode the amount actually read can be smaller than the size on disk (\r\n conversion on windows)
+    content.resize(file.gcount());
+
+    lines.load(std::move(content));
+    bracket_depth_index.clear();
+    undo_history.clear();
+    undo_journal.open(file_path, undo_history);
     current_file_path = file_path;
+    unrendered_modifications.clear();
+    all_lines_modified_since_last_render = true;
+    ++modification_count;
     edit_signal.toggle_state();
     file.close();
     return true;
@@ -28,49 +66,72 @@ bool LineTextBuffer::load_file(const std::string &file_path) {
 
 bool LineTextBuffer::save_file() {
     if (current_file_path.empty()) {
-        std::cerr << "Error: No file currently loaded.\n";
+        LOG_ERROR("No file currently loaded.");
         return false;
     }
 
-    std::ofstream file(current_file_path);
-    if (!file.is_open()) {
-        std::cerr << "Error: Unable to open file " << current_file_path << " for writing.\n";
+    // NOTE: the old file is never truncated and rewritten in place, a crash halfway through a save would leave it half
+    // written, and a memory mapped file can't change underneath the mapping we are still reading lines out of
+    update_save();
+    TextBufferSnapshot snapshot = take_snapshot();
+    if (not save_job.start(std::move(snapshot.text), current_file_path)) {
+        LOG_ERROR("{} is still being saved.", current_file_path);
         return false;
     }
-
-    for (const auto &line : lines) {
-        file << line << "\n";
-    }
-
-    file.close();
-    modified_without_save = false;
+    save_result_pending = true;
+    version_being_saved = snapshot.version;
     return true;
 }
 
-std::string LineTextBuffer::get_text() const {
-    std::string result;
-    for (const auto &line : lines) {
-        result += line + "\n";
+bool LineTextBuffer::update_save() {
+    SaveJob::State state = save_job.get_state();
+    if (state == SaveJob::State::RUNNING) {
+        return true;
     }
-    return result;
-}
+    if (not save_result_pending) {
+        return false;
+    }
+    save_result_pending = false;
+    save_job.wait();
 
-int LineTextBuffer::line_count() const { return lines.size(); }
+    if (state == SaveJob::State::FAILED) {
+        LOG_ERROR("{}", save_job.get_error());
+        return false;
+    }
 
-std::string LineTextBuffer::get_line(int line_index) const {
-    if (line_index < lines.size()) {
-        return lines[line_index];
+    // when the text was edited while the save was running the file on disk is already behind again, and the history
+    // has moved past the state that was written out
+    if (modification_count == version_being_saved) {
+        modified_without_save = false;
+        undo_history.mark_saved();
+        undo_journal.append_saved();
     }
-    return "";
+    return false;
 }
 
-std::string LineTextBuffer::get_text_from_range(const TextRange &range) const {
-    std::string result;
-    int start_line = std::clamp(range.start_line, 0, static_cast<int>(lines.size()) - 1);
-    int end_line = std::clamp(range.end_line, 0, static_cast<int>(lines.size()) - 1);
+void LineTextBuffer::wait_until_saved() {
+    save_job.wait();
+    update_save();
+}
+
+bool LineTextBuffer::is_still_indexing() const { return lines.is_still_indexing(); }
+
+std::string LineTextBuffer::get_text() const { return lines.get_text(); }
+
+TextBufferSnapshot LineTextBuffer::take_snapshot() const { return {modification_count, lines.take_snapshot()}; }
+
+int LineTextBuffer::line_count() const { return lines.line_count(); }
+
+std::string_view LineTextBuffer::get_line(int line_index) const { return lines.line_view(line_index); }
+
+std::vector<std::string_view> LineTextBuffer::get_line_views_from_range(const TextRange &range) const {
+    std::vector<std::string_view> line_views;
+    int start_line = std::clamp(range.start_line, 0, lines.line_count() - 1);
+    int end_line = std::clamp(range.end_line, 0, lines.line_count() - 1);
 
     for (int line = start_line; line <= end_line; ++line) {
-        int line_length = static_cast<int>(lines[line].size());
+        std::string_view line_content = lines.line_view(line);
+        int line_length = static_cast<int>(line_content.size());
         int start_col = (line == range.start_line) ? std::clamp(range.start_col, 0, line_length) : 0;
         int end_col = (line == range.end_line) ? std::clamp(range.end_col, 0, line_length) : line_length;
 
@@ -79,10 +140,21 @@ std::string LineTextBuffer::get_text_from_range(const TextRange &range) const {
         // or the text range is messed up because it is all in one line but for some reason
         // the start col is >= the end col, so there would be no string produced
         if (start_col < end_col) {
-            result += lines[line].substr(start_col, end_col - start_col);
+            line_views.push_back(line_content.substr(start_col, end_col - start_col));
+        } else {
+            line_views.emplace_back();
         }
+    }
+    return line_views;
+}
+
+std::string LineTextBuffer::get_text_from_range(const TextRange &range) const {
+    std::string result;
+    auto line_views = get_line_views_from_range(range);
+    for (size_t i = 0; i < line_views.size(); ++i) {
+        result += line_views[i];
         // whenever we iterate over a line we add a newline unless we're on the last iteration
-        if (line < end_line) {
+        if (i + 1 < line_views.size()) {
             result += "\n";
         }
     }
@@ -90,43 +162,56 @@ std::string LineTextBuffer::get_text_from_range(const TextRange &range) const {
 }
 
 TextModification LineTextBuffer::delete_character(int line_index, int col_index) {
-    if (line_index >= lines.size() or col_index >= lines[line_index].size()) {
-        std::cerr << "Error: line index out of bounds.\n";
+    if (line_index >= lines.line_count() or col_index >= lines.line_view(line_index).size()) {
+        LOG_ERROR("line index out of bounds.");
         return EMPTY_TEXT_DIFF;
     }
 
-    char deleted_char = lines[line_index][col_index];
-    lines[line_index].erase(col_index, 1);
+    std::string line(lines.line_view(line_index));
+    char deleted_char = line[col_index];
+    line.erase(col_index, 1);
+    replace_stored_line(line_index, line);
 
     auto tr = TextRange(line_index, col_index, line_index, col_index + 1);
-    auto td = TextModification(tr, "", get_text_from_range(tr));
+    auto td = TextModification(tr, "", std::string(1, deleted_char));
 
+    record_undoable_modification(td);
+    record_unrendered_modification(td);
     edit_signal.toggle_state();
     modified_without_save = true;
     return td;
 }
 
 TextModification LineTextBuffer::insert_character(int line_index, int col_index, char character) {
+    if (line_index >= lines.line_count()) {
+        // the padding lines shift in below the old end of the file
+        record_unrendered_modification(create_newline_diff(lines.line_count()));
+    }
+
     // Ensure the line_index is within bounds, adding new lines if necessary
-    if (line_index >= lines.size()) {
-        lines.resize(line_index + 1, std::string()); // Adds empty lines up to line_index
+    while (line_index >= lines.line_count()) {
+        lines.append_line(""); // Adds empty lines up to line_index
     }
 
+    std::string line(lines.line_view(line_index));
+
     // Ensure the col_index is within bounds, adding spaces if necessary
-    if (col_index > lines[line_index].size()) {
-        lines[line_index].resize(col_index, ' '); // Resizes with spaces to the desired column index
+    if (col_index > line.size()) {
+        line.resize(col_index, ' '); // Resizes with spaces to the desired column index
     }
 
     // Insert the character at the specified column index
-    lines[line_index].insert(col_index, 1, character);
+    line.insert(col_index, 1, character);
+    replace_stored_line(line_index, line);
 
     // TODO: if we add new lines and stuff do we need to register those diffs as well?
     // yes of course, do this later on.
 
     auto tm = create_insertion_text_modification(line_index, col_index, std::string(1, character));
 
-    undo_stack.push(tm);
+    record_undoable_modification(tm);
 
+    record_unrendered_modification(tm);
     edit_signal.toggle_state();
     modified_without_save = true;
 
@@ -134,41 +219,28 @@ TextModification LineTextBuffer::insert_character(int line_index, int col_index,
 }
 
 TextModification LineTextBuffer::insert_string(int line_index, int col_index, const std::string &str) {
-    if (line_index >= lines.size()) {
-        std::cerr << "Error: line index out of bounds.\n";
+    if (line_index >= lines.line_count()) {
+        LOG_ERROR("line index out of bounds.");
         return EMPTY_TEXT_DIFF; // Return an empty diff in case of error
     }
 
-    std::string new_content = str;
-
-    if (col_index > lines[line_index].size()) {
-        // If col_index is larger than the line size, resize the line with spaces
-        size_t original_size = lines[line_index].size();
-        lines[line_index].resize(col_index, ' ');
-
-        new_content = lines[line_index].substr(original_size, col_index - original_size) + str;
-    }
-
-    lines[line_index].insert(col_index, str);
-
-    TextRange range(line_index, col_index, line_index, col_index + str.size());
-    TextModification modification(range, new_content, "");
+    // If col_index is larger than the line size, the gap is filled with spaces which become part of the inserted text
+    int line_size = static_cast<int>(lines.line_view(line_index).size());
+    int start_col = std::min(col_index, line_size);
+    std::string new_content = std::string(col_index - start_col, ' ') + str;
 
-    undo_stack.push(modification);
-    edit_signal.toggle_state();
-    modified_without_save = true;
-
-    return modification;
+    // the string can span multiple lines (a paste), that's still a single modification and a single undo
+    return apply_text_modification(create_insertion_text_modification(line_index, start_col, new_content));
 }
 
 TextModification LineTextBuffer::delete_line(int line_index) {
 
-    if (line_index >= lines.size()) {
-        std::cerr << "Error: line index out of bounds.\n";
+    if (line_index >= lines.line_count()) {
+        LOG_ERROR("line index out of bounds.");
         return EMPTY_TEXT_DIFF;
     }
 
-    std::string content_of_line_to_delete_with_newline = lines[line_index] + "\n";
+    std::string content_of_line_to_delete_with_newline = std::string(get_line(line_index)) + "\n";
 
     TextRange range(line_index, 0, line_index + 1, 0);
     TextModification modification(range, "", content_of_line_to_delete_with_newline);
@@ -177,16 +249,17 @@ TextModification LineTextBuffer::delete_line(int line_index) {
 }
 
 TextModification LineTextBuffer::append_line(const std::string &line) {
-    size_t line_index = lines.size(); // The index for the new line being appended
+    size_t line_index = lines.line_count(); // The index for the new line being appended
 
-    lines.push_back(line);
+    lines.append_line(line);
 
     TextRange range(line_index, 0, line_index, line.size());
 
     TextModification modification(range, line, ""); // The new content is the line, replaced content is empty
 
-    undo_stack.push(modification);
+    record_undoable_modification(modification);
 
+    record_unrendered_modification(modification);
     edit_signal.toggle_state();
     modified_without_save = true;
 
@@ -194,20 +267,21 @@ TextModification LineTextBuffer::append_line(const std::string &line) {
 }
 
 TextModification LineTextBuffer::replace_line(int line_index, const std::string &new_content) {
-    if (line_index >= lines.size()) {
-        std::cerr << "Error: line index out of bounds.\n";
+    if (line_index >= lines.line_count()) {
+        LOG_ERROR("line index out of bounds.");
         return EMPTY_TEXT_DIFF;
     }
 
-    std::string old_line_content = lines[line_index];
-    lines[line_index] = new_content;
+    std::string old_line_content(get_line(line_index));
+    replace_stored_line(line_index, new_content);
 
     TextRange range(line_index, 0, line_index, old_line_content.size());
 
     TextModification modification(range, new_content, old_line_content);
 
-    undo_stack.push(modification);
+    record_undoable_modification(modification);
 
+    record_unrendered_modification(modification);
     edit_signal.toggle_state();
     modified_without_save = true;
 
@@ -236,15 +310,18 @@ std::string LineTextBuffer::get_bounding_box_string(int start_line, int start_co
     std::string result;
 
     if (min_line == max_line) {
-        result = lines[min_line].substr(min_col, max_col - min_col + 1);
+        result = lines.line_view(min_line).substr(min_col, max_col - min_col + 1);
     } else {
         for (int line = min_line; line <= max_line; ++line) {
+            std::string_view line_content = lines.line_view(line);
             if (line == min_line) {
-                result += lines[line].substr(min_col) + "\n";
+                result += line_content.substr(min_col);
+                result += "\n";
             } else if (line == max_line) {
-                result += lines[line].substr(0, max_col + 1);
+                result += line_content.substr(0, max_col + 1);
             } else {
-                result += lines[line] + "\n";
+                result += line_content;
+                result += "\n";
             }
         }
     }
@@ -272,14 +349,19 @@ std::vector<TextModification> LineTextBuffer::delete_bounding_box(int start_line
 
     std::vector<TextModification> diffs;
     for (const auto &range : single_line_deletion_ranges) {
-        std::string part_to_replace =
-            lines[range.start_line].substr(range.start_col, range.end_col - range.start_col + 1);
-        diffs.emplace_back(range, "", part_to_replace);
-        lines[range.start_line].erase(range.start_col, range.end_col - range.start_col + 1); // Perform the deletion
+        std::string line(lines.line_view(range.start_line));
+        std::string part_to_replace = line.substr(range.start_col, range.end_col - range.start_col + 1);
+        // the box includes its last column, the recorded range ends after it so that redo deletes the same text
+        TextRange deleted_range(range.start_line, range.start_col, range.start_line,
+                                range.start_col + static_cast<int>(part_to_replace.size()));
+        diffs.emplace_back(deleted_range, "", part_to_replace);
+        line.erase(range.start_col, range.end_col - range.start_col + 1); // Perform the deletion
+        replace_stored_line(range.start_line, line);
     }
 
     for (const auto &diff : diffs) {
-        undo_stack.push(diff);
+        record_undoable_modification(diff);
+        record_unrendered_modification(diff);
     }
 
     edit_signal.toggle_state();
@@ -290,27 +372,31 @@ std::vector<TextModification> LineTextBuffer::delete_bounding_box(int start_line
 
 TextModification LineTextBuffer::insert_tab(int line_index, int col_index) {
 
-    if (line_index >= lines.size()) {
-        std::cerr << "Error: line index out of bounds.\n";
+    if (line_index >= lines.line_count()) {
+        LOG_ERROR("line index out of bounds.");
         return EMPTY_TEXT_DIFF;
     }
 
+    std::string line(lines.line_view(line_index));
+
     std::string padding;
-    if (col_index > lines[line_index].size()) {
+    if (col_index > line.size()) {
         // Record padding if line is resized
-        padding = std::string(col_index - lines[line_index].size(), ' ');
-        lines[line_index].resize(col_index, ' ');
+        padding = std::string(col_index - line.size(), ' ');
+        line.resize(col_index, ' ');
     }
 
-    lines[line_index].insert(col_index, TAB);
+    line.insert(col_index, TAB);
+    replace_stored_line(line_index, line);
 
     std::string modification = padding + TAB;
-    size_t start_col = lines[line_index].size() - padding.size();
+    size_t start_col = line.size() - padding.size();
     size_t end_col = start_col + modification.size();
 
-    auto td = create_insertion_text_modification(line_index, col_index, modification);
-    undo_stack.push(td);
+    auto td = create_insertion_text_modification(line_index, col_index - static_cast<int>(padding.size()), modification);
+    record_undoable_modification(td);
 
+    record_unrendered_modification(td);
     edit_signal.toggle_state();
     modified_without_save = true;
 
@@ -318,22 +404,23 @@ TextModification LineTextBuffer::insert_tab(int line_index, int col_index) {
 }
 
 TextModification LineTextBuffer::remove_tab(int line_index, int col_index) {
-    if (line_index >= lines.size()) {
-        std::cerr << "Error: line index out of bounds.\n";
+    if (line_index >= lines.line_count()) {
+        LOG_ERROR("line index out of bounds.");
         return EMPTY_TEXT_DIFF;
     }
 
-    std::string &line = lines[line_index];
+    std::string_view line = lines.line_view(line_index);
 
     // Check if the line starts with TAB (four spaces)
     if (line.substr(0, TAB.size()) == TAB) {
         // Remove the TAB from the start
-        line.erase(0, TAB.size());
+        replace_stored_line(line_index, line.substr(TAB.size()));
 
         TextRange range(line_index, 0, line_index, static_cast<int>(TAB.size()));
 
         TextModification td(range, "", TAB);
-        undo_stack.push(td);
+        record_undoable_modification(td);
+        record_unrendered_modification(td);
         edit_signal.toggle_state();
         modified_without_save = true;
 
@@ -343,144 +430,192 @@ TextModification LineTextBuffer::remove_tab(int line_index, int col_index) {
     return EMPTY_TEXT_DIFF;
 }
 
-std::string LineTextBuffer::get_last_deleted_content() const {
+std::string_view LineTextBuffer::get_last_deleted_content() const {
 
-    if (undo_stack.empty()) {
+    const TextModification *last_diff = undo_history.get_last_modification();
+    if (last_diff == nullptr) {
         return "";
     }
 
-    const auto &last_diff = undo_stack.top();
-
     // TODO: handle multiline:
-    return last_diff.replaced_content;
-
-    return ""; // No deletion found
+    return last_diff->replaced_content;
 }
 
-// TODO return a modification as well.
-// TODO: was working on this trying to get the "undo" of newline working.
 TextModification LineTextBuffer::apply_text_modification(const TextModification &modification) {
-    std::cout << "=== Starting apply_text_modification ===" << std::endl;
+    apply_text_modification_without_recording(modification);
+    record_undoable_modification(modification);
+    return modification;
+}
 
+void LineTextBuffer::apply_text_modification_without_recording(const TextModification &modification) {
+    ScopedPerfProbe probe(PerfStage::TEXT_MODIFICATION);
+    ScopedAllocationTag allocation_tag(AllocationTag::BUFFER);
     const auto &range = modification.text_range_to_replace;
     const std::string &new_content = modification.new_content;
-    const std::string &replaced_content = modification.replaced_content;
-
-    std::cout << "applying: " << modification << std::endl;
 
     // exactly one of the following if blocks get run
     if (is_newline_deletion(modification)) {
-        lines.erase(lines.begin() + range.start_line);
-    } else if (is_newline_insertion(modification)) {
-        lines.insert(lines.begin() + range.start_line, "");
-    } else if (range.start_line == range.end_line) {
-        auto &line = lines[range.start_line];
-
-        line.replace(range.start_col, range.end_col - range.start_col, new_content);
-        std::cout << "After modification, line: " << line << std::endl;
-
-        // If the replaced content contains a newline, we need to handle the merging
-        /*if (new_content.find('\n') != std::string::npos) {*/
-        /*    size_t newline_pos = new_content.find('\n');*/
-        /*    std::cout << "New content contains newline at position " << newline_pos << std::endl;*/
-        /**/
-        /*    auto &next_line = lines[range.start_line + 1];*/
-        /*    next_line = new_content.substr(newline_pos + 1) + next_line;*/
-        /*    line = new_content.substr(0, newline_pos);*/
-        /**/
-        /*    std::cout << "After splitting, line: " << line << std::endl;*/
-        /*    std::cout << "Next line: " << next_line << std::endl;*/
-        /*}*/
-    } else { // multi-line case
-        std::cout << "Modifying multiple lines" << std::endl;
-
-        // Modify the first line from start_col to the end of the line
-        auto &first_line = lines[range.start_line];
-        std::cout << "Before modification, first line: " << first_line << std::endl;
-
-        first_line.replace(range.start_col, first_line.length() - range.start_col,
-                           new_content.substr(0, first_line.length() - range.start_col));
-        std::cout << "After modification, first line: " << first_line << std::endl;
-
-        // Modify the intermediate lines entirely, if any
-        for (int line_index = range.start_line + 1; line_index < range.end_line; ++line_index) {
-            lines[line_index] = new_content.substr(first_line.length() - range.start_col +
-                                                       (line_index - range.start_line - 1) * first_line.length(),
-                                                   first_line.length());
-            std::cout << "After modification, line " << line_index << ": " << lines[line_index] << std::endl;
+        erase_stored_line(range.start_line);
+    } else if (is_newline_insertion(modification) and range.start_col == 0) {
+        // a newline in the middle of a line (a paste can end up doing that) splits it, that goes through the general
+        // case below
+        insert_stored_line(range.start_line, "");
+    } else {
+        int num_lines = line_count();
+        bool inserting_past_last_line = is_insertion(modification) and range.start_line == num_lines;
+        if (range.start_line < 0 or range.end_line < range.start_line or
+            (range.end_line >= num_lines and not inserting_past_last_line)) {
+            LOG_ERROR("text modification out of bounds.");
+            return;
         }
 
-        // Modify the last line from the start of the line to end_col
-        auto &last_line = lines[range.end_line];
-        std::cout << "Before modification, last line: " << last_line << std::endl;
-
-        last_line.replace(0, range.end_col,
-                          new_content.substr(new_content.length() - last_line.length(), range.end_col));
-        std::cout << "After modification, last line: " << last_line << std::endl;
+        // the text in front of the range, the new content and the text behind the range end up as one string which is
+        // then split back up into lines, that way single line edits and edits that add or remove lines are the same
+        std::string text;
+        std::string_view text_behind_range;
+        if (not inserting_past_last_line) {
+            std::string_view first_line = lines.line_view(range.start_line);
+            std::string_view last_line = lines.line_view(range.end_line);
+            text = first_line.substr(0, std::min<size_t>(range.start_col, first_line.size()));
+            text.resize(std::max<size_t>(range.start_col, text.size()), ' ');
+            text_behind_range = last_line.substr(std::min<size_t>(range.end_col, last_line.size()));
+        }
+        text += new_content;
+        text += text_behind_range;
 
-        // Check if new_content contains a newline
-        if (new_content.find('\n') != std::string::npos) {
-            size_t newline_pos = new_content.find('\n');
-            std::cout << "New content contains newline at position " << newline_pos << std::endl;
+        // NOTE: past the last line the newline at the end of the content belongs to the line before, not to a new one
+        if (inserting_past_last_line and not text.empty() and text.back() == '\n') {
+            text.pop_back();
+        }
 
-            auto &next_line = lines[range.end_line + 1];
-            next_line = new_content.substr(newline_pos + 1) + next_line;
-            lines[range.end_line] = new_content.substr(0, newline_pos);
+        std::vector<std::string_view> new_lines;
+        size_t line_start = 0;
+        for (size_t newline = text.find('\n'); newline != std::string::npos; newline = text.find('\n', line_start)) {
+            new_lines.push_back(std::string_view(text).substr(line_start, newline - line_start));
+            line_start = newline + 1;
+        }
+        new_lines.push_back(std::string_view(text).substr(line_start));
 
-            std::cout << "After splitting, last line: " << lines[range.end_line] << std::endl;
-            std::cout << "Next line: " << next_line << std::endl;
+        int num_old_lines = inserting_past_last_line ? 0 : range.end_line - range.start_line + 1;
+        int num_new_lines = static_cast<int>(new_lines.size());
+        for (int i = 0; i < std::min(num_old_lines, num_new_lines); ++i) {
+            replace_stored_line(range.start_line + i, new_lines[i]);
+        }
+        for (int i = num_new_lines; i < num_old_lines; ++i) {
+            erase_stored_line(range.start_line + num_new_lines);
+        }
+        for (int i = num_old_lines; i < num_new_lines; ++i) {
+            insert_stored_line(range.start_line + i, new_lines[i]);
         }
     }
 
+    record_unrendered_modification(modification);
     edit_signal.toggle_state();
     modified_without_save = true;
-    undo_stack.push(modification);
+}
 
-    std::cout << "=== Finished apply_text_modification ===" << std::endl;
-    return modification;
+// the bracket depth index covers the lines from the top down to some line, changes below that don't concern it.
+// NOTE: the content can be a view into the buffer itself, so it is looked at before the lines change underneath it
+void LineTextBuffer::replace_stored_line(int line_index, std::string_view content) {
+    if (line_index < bracket_depth_index.line_count()) {
+        bracket_depth_index.replace_line(line_index, BracketBalance::of_text(content));
+    }
+    lines.replace_line(line_index, content);
 }
 
-TextModification LineTextBuffer::undo() {
-    if (undo_stack.empty()) {
-        std::cerr << "Undo stack is empty!\n";
-        return EMPTY_TEXT_DIFF;
+void LineTextBuffer::insert_stored_line(int line_index, std::string_view content) {
+    if (line_index < bracket_depth_index.line_count()) {
+        bracket_depth_index.insert_line(line_index, BracketBalance::of_text(content));
     }
+    lines.insert_line(line_index, content);
+}
 
-    TextModification last_change = undo_stack.top();
-    undo_stack.pop();
-    redo_stack.push(last_change);
+void LineTextBuffer::erase_stored_line(int line_index) {
+    lines.erase_line(line_index);
+    if (line_index < bracket_depth_index.line_count()) {
+        bracket_depth_index.erase_line(line_index);
+    }
+}
 
-    std::cout << "orig: " << last_change << std::endl;
-    TextModification inverse_diff = get_inverse_modification(last_change);
-    std::cout << "inverse diff: " << inverse_diff << std::endl;
-    apply_text_modification(inverse_diff);
+void LineTextBuffer::record_unrendered_modification(const TextModification &modification) {
+    ++modification_count;
+    if (all_lines_modified_since_last_render) {
+        return;
+    }
+    // nobody is taking these, they would just keep piling up, redrawing everything is cheaper at that point anyways
+    if (unrendered_modifications.size() >= MAX_UNRENDERED_MODIFICATIONS) {
+        unrendered_modifications.clear();
+        all_lines_modified_since_last_render = true;
+        return;
+    }
+    unrendered_modifications.push_back(modification);
+}
 
-    edit_signal.toggle_state();
-    modified_without_save = true;
-    return inverse_diff;
+std::vector<TextModification> LineTextBuffer::take_unrendered_modifications(bool &all_lines_modified) {
+    all_lines_modified = all_lines_modified_since_last_render;
+    all_lines_modified_since_last_render = false;
+    return std::exchange(unrendered_modifications, {});
 }
 
-TextModification LineTextBuffer::redo() {
-    if (redo_stack.empty()) {
-        std::cerr << "Redo stack is empty!\n";
+void LineTextBuffer::record_undoable_modification(const TextModification &modification) {
+    ScopedAllocationTag allocation_tag(AllocationTag::HISTORY);
+    bool starts_group = undo_history.record(modification);
+    undo_journal.append_modification(modification, starts_group);
+}
+
+void LineTextBuffer::begin_undo_group() { undo_history.begin_group(); }
+
+void LineTextBuffer::set_undo_memory_budget(size_t memory_budget_bytes) {
+    undo_history.set_memory_budget(memory_budget_bytes);
+}
+
+void LineTextBuffer::submit_undo_journal() { undo_journal.submit(); }
+
+// a group is undone back to front, each modification by applying its inverse
+TextModification LineTextBuffer::undo() {
+    ScopedAllocationTag allocation_tag(AllocationTag::HISTORY);
+    const UndoGroup *group = undo_history.undo();
+    if (group == nullptr) {
+        LOG_DEBUG("Undo stack is empty!");
         return EMPTY_TEXT_DIFF;
     }
+    undo_journal.append_undo();
 
-    TextModification last_redo_change = redo_stack.top();
-    redo_stack.pop();
+    TextModification inverse_diff = EMPTY_TEXT_DIFF;
+    for (auto it = group->modifications.rbegin(); it != group->modifications.rend(); ++it) {
+        inverse_diff = get_inverse_modification(*it);
+        apply_text_modification_without_recording(inverse_diff);
+    }
+    return inverse_diff;
+}
 
-    undo_stack.push(last_redo_change);
+TextModification LineTextBuffer::redo() {
+    ScopedAllocationTag allocation_tag(AllocationTag::HISTORY);
+    const UndoGroup *group = undo_history.redo();
+    if (group == nullptr) {
+        LOG_DEBUG("Redo stack is empty!");
+        return EMPTY_TEXT_DIFF;
+    }
+    undo_journal.append_redo();
 
-    apply_text_modification(last_redo_change);
+    for (const auto &modification : group->modifications) {
+        apply_text_modification_without_recording(modification);
+    }
+    return group->modifications.back();
+}
 
-    edit_signal.toggle_state();   // Toggle the edit signal
-    modified_without_save = true; // Mark as modified
-    return last_redo_change;
+// NOTE: the motions below were written against std::string where reading at size() gives back '\0', views don't have
+// that terminator so anything that can step past the end of the line reads through here instead
+static char character_at(std::string_view line, int col_index) {
+    if (col_index < 0 or col_index >= static_cast<int>(line.size())) {
+        return '\0';
+    }
+    return line[col_index];
 }
 
 int LineTextBuffer::find_rightward_index(int line_index, int col_index, char character) const {
     // Look for the character to the right of col_index in the given line
-    std::string line = get_line(line_index);
+    std::string_view line = get_line(line_index);
     for (int i = col_index; i < line.length(); ++i) {
         if (line[i] == character) {
             return i; // Return the column index of the found character
@@ -491,9 +626,9 @@ int LineTextBuffer::find_rightward_index(int line_index, int col_index, char cha
 
 int LineTextBuffer::find_leftward_index(int line_index, int col_index, char character) const {
     // Look for the character to the left of col_index in the given line
-    std::string line = get_line(line_index);
+    std::string_view line = get_line(line_index);
     for (int i = col_index - 1; i >= 0; --i) {
-        if (line[i] == character) {
+        if (character_at(line, i) == character) {
             return i; // Return the column index of the found character
         }
     }
@@ -518,8 +653,8 @@ int LineTextBuffer::find_leftward_index_before(int line_index, int col_index, ch
 
 int LineTextBuffer::find_col_idx_of_first_non_whitespace_character_in_line(int line_index) const {
     int col_index = 0;
-    if (line_index < lines.size()) {
-        const std::string &line = get_line(line_index);
+    if (line_index < lines.line_count()) {
+        std::string_view line = get_line(line_index);
         while (col_index < line.size() && std::isspace(static_cast<unsigned char>(line[col_index]))) {
             ++col_index;
         }
@@ -531,8 +666,8 @@ int LineTextBuffer::find_col_idx_of_first_non_whitespace_character_in_line(int l
 bool LineTextBuffer::character_is_non_word_character(const std::string &c) const { return true; }
 
 int LineTextBuffer::find_forward_by_word_index(int line_index, int col_index) const {
-    if (line_index < lines.size()) { // Ensure line_index is valid
-        const std::string &line = get_line(line_index);
+    if (line_index < lines.line_count()) { // Ensure line_index is valid
+        std::string_view line = get_line(line_index);
 
         // Skip alphanumeric characters
         while (col_index < line.size() && std::isalnum(line[col_index])) {
@@ -549,9 +684,9 @@ int LineTextBuffer::find_forward_by_word_index(int line_index, int col_index) co
 }
 
 int LineTextBuffer::find_column_index_of_next_character(int line_index, int col_index, char target_char) const {
-    bool got_passed_end_of_document = line_index < lines.size();
+    bool got_passed_end_of_document = line_index < lines.line_count();
     if (got_passed_end_of_document) { // Ensure line_index is valid
-        const std::string &line = get_line(line_index);
+        std::string_view line = get_line(line_index);
 
         // Search for the target character on the current line
         while (col_index < line.size() && line[col_index] != target_char) {
@@ -563,12 +698,12 @@ int LineTextBuffer::find_column_index_of_next_character(int line_index, int col_
 }
 
 int LineTextBuffer::find_column_index_of_character_leftward(int line_index, int col_index, char target_char) const {
-    bool got_passed_end_of_document = line_index < lines.size();
+    bool got_passed_end_of_document = line_index < lines.line_count();
     if (got_passed_end_of_document) { // Ensure line_index is valid
-        const std::string &line = get_line(line_index);
+        std::string_view line = get_line(line_index);
 
         // Search for the target character on the current line
-        while (col_index > 0 && line[col_index] != target_char) {
+        while (col_index > 0 && character_at(line, col_index) != target_char) {
             --col_index;
         }
     }
@@ -585,11 +720,11 @@ int LineTextBuffer::find_column_index_of_previous_left_bracket(int line_index, i
 }
 
 int LineTextBuffer::find_forward_to_end_of_word(int line_index, int col_index) const {
-    if (line_index < lines.size()) { // Ensure line_index is valid
-        const std::string &line = get_line(line_index);
+    if (line_index < lines.line_count()) { // Ensure line_index is valid
+        std::string_view line = get_line(line_index);
 
         // Skip alphanumeric characters if we are not at the beginning of the word
-        while (col_index < line.size() && std::isalnum(line[col_index + 1])) {
+        while (col_index < line.size() && std::isalnum(character_at(line, col_index + 1))) {
             ++col_index;
         }
     }
@@ -598,11 +733,11 @@ int LineTextBuffer::find_forward_to_end_of_word(int line_index, int col_index) c
 }
 
 int LineTextBuffer::find_backward_to_start_of_word(int line_index, int col_index) const {
-    if (line_index < lines.size()) { // Ensure line_index is valid
-        const std::string &line = get_line(line_index);
+    if (line_index < lines.line_count()) { // Ensure line_index is valid
+        std::string_view line = get_line(line_index);
 
         // Move backwards to skip alphanumeric characters if not at the start of the word
-        while (col_index > 0 && std::isalnum(line[col_index + 1])) {
+        while (col_index > 0 && std::isalnum(character_at(line, col_index + 1))) {
             --col_index;
         }
     }
@@ -612,16 +747,16 @@ int LineTextBuffer::find_backward_to_start_of_word(int line_index, int col_index
 
 // Updated function to find the previous word by moving the cursor backward
 int LineTextBuffer::find_backward_by_word_index(int line_index, int col_index) const {
-    if (line_index < lines.size() && col_index >= 0) { // Ensure line_index is valid and col_index is non-negative
-        const std::string &line = get_line(line_index);
+    if (line_index < lines.line_count() && col_index >= 0) { // Ensure line_index is valid and col_index is non-negative
+        std::string_view line = get_line(line_index);
 
         // Skip alphanumeric characters backwards
-        while (col_index > 0 && std::isalnum(line[col_index - 1])) {
+        while (col_index > 0 && std::isalnum(character_at(line, col_index - 1))) {
             --col_index;
         }
 
         // Skip non-alphanumeric characters backwards
-        while (col_index > 0 && !std::isalnum(line[col_index - 1])) {
+        while (col_index > 0 && !std::isalnum(character_at(line, col_index - 1))) {
             --col_index;
         }
     }
@@ -629,91 +764,82 @@ int LineTextBuffer::find_backward_by_word_index(int line_index, int col_index) c
     return col_index; // Return the updated column index
 }
 
-std::string escape_special_chars(const std::string &input) {
-    std::string result = input;
-
-    // Escape round, square, and curly braces
-    result = std::regex_replace(result, std::regex(R"(\()"), R"(\()");
-    result = std::regex_replace(result, std::regex(R"(\))"), R"(\))");
-    result = std::regex_replace(result, std::regex(R"(\[)"), R"(\[)");
-    result = std::regex_replace(result, std::regex(R"(\])"), R"(\])");
-    result = std::regex_replace(result, std::regex(R"(\{)"), R"(\{)");
-    result = std::regex_replace(result, std::regex(R"(\})"), R"(\})");
-
-    return result;
+std::vector<TextRange> LineTextBuffer::find_forward_matches(int line_index, int col_index,
+                                                            const std::string &regex_str) const {
+    return find_forward_matches(line_index, col_index, SearchPattern(regex_str));
 }
 
 std::vector<TextRange> LineTextBuffer::find_forward_matches(int line_index, int col_index,
-                                                            const std::string &regex_str) const {
+                                                            const SearchPattern &pattern) const {
     std::vector<TextRange> matches;
-    std::string escaped_regex = escape_special_chars(regex_str);
-    std::regex pattern(escaped_regex);
+    if (pattern.is_empty()) {
+        return matches;
+    }
 
     // Check the current line and subsequent lines
-    for (int i = line_index; i < lines.size(); ++i) {
-        std::string line = lines[i];
+    for (int i = line_index; i < lines.line_count(); ++i) {
+        std::string_view line = lines.line_view(i);
         // If it's the starting line, start from col_index, else start from the beginning
-        int start_pos = (i == line_index) ? col_index : 0;
-
-        std::smatch match;
-        std::string remaining_text = line.substr(start_pos);
+        size_t start_col = (i == line_index) ? static_cast<size_t>(std::max(col_index, 0)) : 0;
 
-        while (std::regex_search(remaining_text, match, pattern)) {
-            int start_col = start_pos + match.position(0);
-            int end_col = start_pos + match.position(0) + match.length(0);
-            matches.push_back(TextRange(i, start_col, i, end_col));
-            remaining_text = match.suffix().str();
-        }
+        pattern.for_each_match_in_line(line, start_col, [&](size_t match_start, size_t match_end) {
+            matches.push_back(TextRange(i, static_cast<int>(match_start), i, static_cast<int>(match_end)));
+        });
     }
     return matches;
 }
 
 std::vector<TextRange> LineTextBuffer::find_backward_matches(int line_index, int col_index,
                                                              const std::string &regex_str) const {
+    return find_backward_matches(line_index, col_index, SearchPattern(regex_str));
+}
+
+std::vector<TextRange> LineTextBuffer::find_backward_matches(int line_index, int col_index,
+                                                             const SearchPattern &pattern) const {
     std::vector<TextRange> matches;
-    std::string escaped_regex = escape_special_chars(regex_str);
-    std::regex pattern(escaped_regex);
+    if (pattern.is_empty()) {
+        return matches;
+    }
 
     // Check the current line and previous lines
-    for (int i = line_index; i >= 0; --i) {
-        std::string line = lines[i];
-        // If it's the starting line, start from col_index, else start from the end of the line
-        int start_pos = (i == line_index) ? col_index : line.length();
-
-        std::smatch match;
-        std::string remaining_text = line.substr(0, start_pos);
-
-        while (std::regex_search(remaining_text, match, pattern)) {
-            int start_col = match.position(0);
-            int end_col = match.position(0) + match.length(0);
-            matches.push_back(TextRange(i, start_col, i, end_col));
-            remaining_text = match.suffix().str();
+    for (int i = std::min(line_index, lines.line_count() - 1); i >= 0; --i) {
+        std::string_view line = lines.line_view(i);
+        // If it's the starting line only the text before col_index is searched, else the whole line
+        if (i == line_index) {
+            line = line.substr(0, std::min(static_cast<size_t>(std::max(col_index, 0)), line.size()));
         }
+
+        pattern.for_each_match_in_line(line, 0, [&](size_t match_start, size_t match_end) {
+            matches.push_back(TextRange(i, static_cast<int>(match_start), i, static_cast<int>(match_end)));
+        });
     }
     return matches;
 }
 
 int LineTextBuffer::get_indentation_level(int line, int col) const {
-    std::stack<char> bracket_stack; // Stack to keep track of open/close brackets
-    int indentation_level = 0;
-
-    // Iterate through all lines up to the specified line
-    for (int i = 0; i <= line; ++i) {
-        const std::string &current_line = lines[i];
-
-        // Check each character in the line up to the specified column (or end of line)
-        for (int j = 0; j < (i == line ? col : current_line.length()); ++j) {
-            if (current_line[j] == '{') {
-                bracket_stack.push('{'); // Push an open bracket to the stack
-                ++indentation_level;     // Increase indentation level for each open bracket
-            } else if (current_line[j] == '}') {
-                if (!bracket_stack.empty()) {
-                    bracket_stack.pop(); // Pop the stack for a matching closing bracket
-                    --indentation_level; // Decrease indentation level for each closing bracket
-                }
-            }
+    if (line < 0 or line >= lines.line_count()) {
+        return 0;
+    }
+
+    // the index only covers the lines that have been asked about so far, the first call on a big file pays for the
+    // lines above it once and after that only the edited lines ever get looked at again
+    int num_covered_lines = bracket_depth_index.line_count();
+    if (line - num_covered_lines > num_covered_lines) {
+        // growing by more than it already has, cheaper to build it over again
+        std::vector<BracketBalance> line_balances;
+        line_balances.reserve(line);
+        for (int line_index = 0; line_index < line; ++line_index) {
+            line_balances.push_back(BracketBalance::of_text(lines.line_view(line_index)));
+        }
+        bracket_depth_index.assign(line_balances);
+    } else {
+        for (int line_index = num_covered_lines; line_index < line; ++line_index) {
+            bracket_depth_index.insert_line(line_index, BracketBalance::of_text(lines.line_view(line_index)));
         }
     }
 
-    return indentation_level;
+    int depth_at_start_of_line = bracket_depth_index.get_depth_before_line(line);
+    std::string_view current_line = lines.line_view(line);
+    int clamped_col = std::clamp(col, 0, static_cast<int>(current_line.size()));
+    return BracketBalance::of_text(current_line.substr(0, clamped_col)).apply(depth_at_start_of_line);
 }
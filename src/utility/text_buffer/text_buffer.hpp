@@ -2,17 +2,54 @@
 #define TEXT_BUFFER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <stack>
+#include <cstddef>
 
 #include "../temporal_binary_signal/temporal_binary_signal.hpp"
 #include "../text_diff/text_diff.hpp"
+#include "../piece_table/piece_table.hpp"
+#include "../search_pattern/search_pattern.hpp"
+#include "../bracket_depth_index/bracket_depth_index.hpp"
+#include "../undo_history/undo_history.hpp"
+#include "../undo_journal/undo_journal.hpp"
+#include "../save_job/save_job.hpp"
+
+// the text of a buffer as it was at one modification count, see LineTextBuffer::take_snapshot
+struct TextBufferSnapshot {
+    size_t version;
+    PieceTableSnapshot text;
+};
 
 class LineTextBuffer {
   private:
-    std::vector<std::string> lines;
-    std::stack<TextModification> undo_stack;
-    std::stack<TextModification> redo_stack;
+    PieceTable lines;
+    UndoHistory undo_history;
+    // the undo history of the loaded file on disk, so it is still there the next time the file is opened
+    UndoJournal undo_journal;
+    // goes into both of the above
+    void record_undoable_modification(const TextModification &modification);
+    // changes the text without touching the undo history, undo and redo go through here directly
+    void apply_text_modification_without_recording(const TextModification &modification);
+
+    // edits that haven't been drawn yet, see take_unrendered_modifications
+    static constexpr size_t MAX_UNRENDERED_MODIFICATIONS = 256;
+    std::vector<TextModification> unrendered_modifications;
+    bool all_lines_modified_since_last_render = true;
+    void record_unrendered_modification(const TextModification &modification);
+
+    // indentation comes from how deep in curly brackets a line is, this is filled in lazily by get_indentation_level
+    mutable BracketDepthIndex bracket_depth_index;
+    // every change to the stored lines goes through these so that the index above stays in sync
+    void replace_stored_line(int line_index, std::string_view content);
+    void insert_stored_line(int line_index, std::string_view content);
+    void erase_stored_line(int line_index);
+    size_t modification_count = 0;
+
+    SaveJob save_job;
+    // the save hasn't been looked at by update_save yet
+    bool save_result_pending = false;
+    size_t version_being_saved = 0;
 
   public:
     TemporalBinarySignal edit_signal;
@@ -20,15 +57,35 @@ class LineTextBuffer {
     bool modified_without_save = false;
 
     static constexpr const std::string TAB = "    ";
+    // files at least this big get memory mapped and indexed in the background instead of being read up front
+    static constexpr size_t MEMORY_MAPPED_LOAD_THRESHOLD_BYTES = 4 * 1024 * 1024;
 
     bool load_file(const std::string &file_path);
+    // takes a snapshot of the text and writes it out in the background, edits made while it's saving don't end up in
+    // the file. Returns false if the save couldn't be started (another one is still running)
     bool save_file();
-
+    // finishes up a save once it's done, call this regularly (the renderer does it every frame), returns whether a
+    // save is still running
+    bool update_save();
+    void wait_until_saved();
+    const SaveJob &get_save_job() const { return save_job; }
+    bool is_still_indexing() const;
+
+    // NOTE: the functions returning a std::string_view don't copy anything, they point straight into the storage of
+    // the buffer. A view stays valid until the next modification of the buffer (any of the modification functions,
+    // undo, redo or load_file), if you need the text to survive an edit copy it into a std::string first.
+
+    // this copies the whole file, prefer reading line by line
     std::string get_text() const;
+    // doesn't copy the text, the snapshot shares it with the buffer and keeps reading the same text no matter what
+    // happens to the buffer afterwards, so it can be handed to another thread. The version is the modification count
+    TextBufferSnapshot take_snapshot() const;
 
     int line_count() const;
-    std::string get_line(int line_index) const;
+    std::string_view get_line(int line_index) const;
     std::string get_bounding_box_string(int start_line, int start_col, int end_line, int end_col) const;
+    // the part of each line that the range covers, one view per line
+    std::vector<std::string_view> get_line_views_from_range(const TextRange &range) const;
     std::string get_text_from_range(const TextRange &range) const;
     bool character_is_non_word_character(const std::string &c) const;
 
@@ -50,6 +107,13 @@ class LineTextBuffer {
 
     // NOTE: MODIFICATION FUNCTIONS END
 
+    // the edits made since the last call, the renderer uses these to work out which rows it has to redraw. When the
+    // whole buffer changed (a file was loaded, or too many edits piled up while nothing was drawing this buffer)
+    // all_lines_modified is set instead
+    std::vector<TextModification> take_unrendered_modifications(bool &all_lines_modified);
+    // goes up with every modification and every load, anything computed from the text is stale once this changes
+    size_t get_modification_count() const { return modification_count; }
+
     int find_rightward_index(int line_index, int col_index, char character) const;
     int find_leftward_index(int line_index, int col_index, char character) const;
     int find_rightward_index_before(int line_index, int col_index, char character) const;
@@ -71,11 +135,22 @@ class LineTextBuffer {
 
     std::vector<TextRange> find_forward_matches(int line_index, int col_index, const std::string &regex_str) const;
     std::vector<TextRange> find_backward_matches(int line_index, int col_index, const std::string &regex_str) const;
+    // same as above but with a pattern compiled by the caller, so repeated searches don't compile it again
+    std::vector<TextRange> find_forward_matches(int line_index, int col_index, const SearchPattern &pattern) const;
+    std::vector<TextRange> find_backward_matches(int line_index, int col_index, const SearchPattern &pattern) const;
 
-    std::string get_last_deleted_content() const;
+    std::string_view get_last_deleted_content() const;
 
     int get_indentation_level(int line, int col) const;
 
+    // everything done to the buffer from here on until the next call is undone in one go, without calling this every
+    // modification is undone on its own
+    void begin_undo_group();
+    void set_undo_memory_budget(size_t memory_budget_bytes);
+    // hands the undo journal records of the edits since the last call to its writer thread, call this regularly (the
+    // renderer does it every frame), until then they're only in memory
+    void submit_undo_journal();
+
     TextModification undo();
     TextModification redo();
 };
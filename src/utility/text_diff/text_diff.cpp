@@ -1,5 +1,7 @@
 #include "text_diff.hpp"
 
+#include <algorithm>
+
 TextModification create_insertion_text_modification(int line, int col, const std::string &text) {
     TextRange range(line, col, line, col);
     return TextModification(range, text, "");
@@ -44,34 +46,21 @@ bool is_newline_deletion(const TextModification &modification) {
  * @return TextModification The inverse of the original modification.
  */
 TextModification get_inverse_modification(const TextModification &modification) {
-
-    if (is_newline_insertion(modification)) {
-        // Handle the inverse of a newline insertion
-        // We need to remove the inserted newline, so we will delete the range where the newline was inserted.
-
-        // Get the position of the newline insertion
-        TextRange adjusted_range(modification.text_range_to_replace.start_line,
-                                 modification.text_range_to_replace.start_col,
-                                 modification.text_range_to_replace.start_line + 1, // One line after the insertion
-                                 modification.text_range_to_replace.start_col // Column where the newline was inserted
-        );
-
-        // The original content before the insertion (which might have been replaced with a newline) will be restored
-        return TextModification(
-            adjusted_range,
-            modification.replaced_content, // New content is the inserted newline that we want to remove
-            modification.new_content       // Revert to the original content before the newline
-        );
-    } else {
-        // Adjust range for non-newline modification (such as text replacement or deletion)
-        TextRange adjusted_range(
-            modification.text_range_to_replace.start_line, modification.text_range_to_replace.start_col,
-            modification.text_range_to_replace.start_line,
-            modification.text_range_to_replace.start_col + static_cast<int>(modification.new_content.size()));
-
-        return TextModification(adjusted_range,
-                                modification.replaced_content, // Restore original content
-                                modification.new_content       // Original content becomes replaced content
-        );
+    // the range of the inverse ends where the new content ends, which is further down when the new content spans
+    // multiple lines (a single newline inserted at column 0 ends at the start of the next line)
+    const std::string &new_content = modification.new_content;
+    int end_line = modification.text_range_to_replace.start_line;
+    int end_col = modification.text_range_to_replace.start_col + static_cast<int>(new_content.size());
+    size_t last_newline = new_content.rfind('\n');
+    if (last_newline != std::string::npos) {
+        end_line += static_cast<int>(std::count(new_content.begin(), new_content.end(), '\n'));
+        end_col = static_cast<int>(new_content.size() - last_newline - 1);
     }
+    TextRange adjusted_range(modification.text_range_to_replace.start_line, modification.text_range_to_replace.start_col,
+                             end_line, end_col);
+
+    return TextModification(adjusted_range,
+                            modification.replaced_content, // Restore original content
+                            modification.new_content       // Original content becomes replaced content
+    );
 }
@@ -0,0 +1,80 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // the thread calling run_sharded counts as one of them
+    for (size_t i = 1; i < num_threads; ++i) {
+        workers.emplace_back([this] { run_worker(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    job_available.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run_sharded(size_t num_items, size_t num_shards, const ShardFunction &shard_function) {
+    num_shards = std::max<size_t>(num_shards, 1);
+
+    // nobody to share with, skip the locking
+    if (num_shards == 1 or workers.empty()) {
+        for (size_t shard_index = 0; shard_index < num_shards; ++shard_index) {
+            shard_function(shard_index, num_items * shard_index / num_shards,
+                           num_items * (shard_index + 1) / num_shards);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job_function = &shard_function;
+    job_num_items = num_items;
+    job_num_shards = num_shards;
+    next_shard_to_take = 0;
+    num_shards_finished = 0;
+    ++job_generation;
+    job_available.notify_all();
+
+    work_on_current_job(lock);
+    job_finished.wait(lock, [&] { return num_shards_finished == job_num_shards; });
+    job_function = nullptr;
+}
+
+void ThreadPool::work_on_current_job(std::unique_lock<std::mutex> &lock) {
+    while (job_function != nullptr and next_shard_to_take < job_num_shards) {
+        size_t shard_index = next_shard_to_take++;
+        const ShardFunction &shard_function = *job_function;
+        size_t begin = job_num_items * shard_index / job_num_shards;
+        size_t end = job_num_items * (shard_index + 1) / job_num_shards;
+
+        lock.unlock();
+        shard_function(shard_index, begin, end);
+        lock.lock();
+
+        if (++num_shards_finished == job_num_shards) {
+            job_finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::run_worker() {
+    std::unique_lock<std::mutex> lock(mutex);
+    size_t last_seen_generation = 0;
+    while (true) {
+        job_available.wait(lock, [&] { return stop_requested or job_generation != last_seen_generation; });
+        if (stop_requested) {
+            return;
+        }
+        last_seen_generation = job_generation;
+        work_on_current_job(lock);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of worker threads that stay alive between jobs, so splitting work across cores doesn't pay for
+// creating threads every time.
+class ThreadPool {
+  public:
+    // zero means one thread per core
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t get_num_threads() const { return workers.size() + 1; }
+
+    using ShardFunction = std::function<void(size_t shard_index, size_t begin, size_t end)>;
+
+    // splits [0, num_items) into num_shards contiguous shards and blocks until every one of them has been processed,
+    // the calling thread works on shards too. Only one caller at a time
+    void run_sharded(size_t num_items, size_t num_shards, const ShardFunction &shard_function);
+
+  private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::condition_variable job_finished;
+    bool stop_requested = false;
+
+    // the current job, a new generation means new work
+    size_t job_generation = 0;
+    const ShardFunction *job_function = nullptr;
+    size_t job_num_items = 0;
+    size_t job_num_shards = 0;
+    size_t next_shard_to_take = 0;
+    size_t num_shards_finished = 0;
+
+    // takes shards of the current job until there are none left, the mutex must be held
+    void work_on_current_job(std::unique_lock<std::mutex> &lock);
+    void run_worker();
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,174 @@
+#include "trace_recorder.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+void TraceRecorder::start() {
+    std::lock_guard<std::mutex> lock(thread_buffers_mutex);
+    for (auto &thread_buffer : thread_buffers) {
+        std::lock_guard<std::mutex> buffer_lock(thread_buffer->mutex);
+        thread_buffer->events.clear();
+        thread_buffer->num_dropped = 0;
+    }
+    remove_buffers_of_exited_threads();
+    start_time = Clock::now();
+    trace_index.fetch_add(1, std::memory_order_relaxed);
+    recording.store(true, std::memory_order_release);
+}
+
+bool TraceRecorder::stop_and_write(const std::string &file_path) {
+    recording.store(false, std::memory_order_release);
+    auto stop_time = Clock::now();
+
+    auto to_microseconds = [&](Clock::time_point time) {
+        return std::chrono::duration<double, std::micro>(time - start_time).count();
+    };
+
+    nlohmann::json trace_events = nlohmann::json::array();
+    size_t num_dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(thread_buffers_mutex);
+        for (auto &thread_buffer : thread_buffers) {
+            std::lock_guard<std::mutex> buffer_lock(thread_buffer->mutex);
+            num_dropped += thread_buffer->num_dropped;
+            if (thread_buffer->events.empty()) {
+                continue;
+            }
+
+            trace_events.push_back({{"name", "thread_name"},
+                                    {"ph", "M"},
+                                    {"pid", 1},
+                                    {"tid", thread_buffer->thread_index},
+                                    {"args", {{"name", thread_buffer->thread_name}}}});
+
+            std::vector<const Event *> open_spans;
+            for (const Event &event : thread_buffer->events) {
+                nlohmann::json trace_event = {{"name", event.name},
+                                              {"ph", std::string(1, static_cast<char>(event.phase))},
+                                              {"ts", to_microseconds(event.time)},
+                                              {"pid", 1},
+                                              {"tid", thread_buffer->thread_index}};
+                if (event.category != nullptr) {
+                    trace_event["cat"] = event.category;
+                }
+                if (event.phase == Phase::COUNTER) {
+                    trace_event["args"] = {{"value", event.value}};
+                } else if (event.phase == Phase::BEGIN) {
+                    open_spans.push_back(&event);
+                } else if (event.phase == Phase::END and not open_spans.empty()) {
+                    open_spans.pop_back();
+                }
+                trace_events.push_back(std::move(trace_event));
+            }
+
+            // innermost first, so they still nest
+            for (auto it = open_spans.rbegin(); it != open_spans.rend(); ++it) {
+                nlohmann::json trace_event = {{"name", (*it)->name},
+                                              {"ph", std::string(1, static_cast<char>(Phase::END))},
+                                              {"ts", to_microseconds(stop_time)},
+                                              {"pid", 1},
+                                              {"tid", thread_buffer->thread_index}};
+                if ((*it)->category != nullptr) {
+                    trace_event["cat"] = (*it)->category;
+                }
+                trace_events.push_back(std::move(trace_event));
+            }
+
+            thread_buffer->events.clear();
+            thread_buffer->events.shrink_to_fit();
+        }
+        remove_buffers_of_exited_threads();
+    }
+
+    nlohmann::json trace = {{"traceEvents", std::move(trace_events)}, {"displayTimeUnit", "ms"}};
+    if (num_dropped > 0) {
+        trace["otherData"] = {{"num_dropped_events", num_dropped}};
+    }
+
+    std::ofstream file(file_path, std::ios::out | std::ios::trunc);
+    if (not file.is_open()) {
+        return false;
+    }
+    file << trace.dump();
+    return static_cast<bool>(file);
+}
+
+void TraceRecorder::begin_span(const char *name, const char *category) { record(name, category, Phase::BEGIN, 0); }
+
+void TraceRecorder::end_span(const char *name, const char *category) { record(name, category, Phase::END, 0); }
+
+void TraceRecorder::record_counter(const char *name, double value) { record(name, nullptr, Phase::COUNTER, value); }
+
+// NOTE: this doesn't make a buffer, the name is kept with the thread until it records something
+void TraceRecorder::set_current_thread_name(const std::string &name) {
+    CurrentThreadBuffer &current_thread = get_current_thread();
+    current_thread.thread_name = name;
+    if (current_thread.buffer != nullptr) {
+        std::lock_guard<std::mutex> lock(current_thread.buffer->mutex);
+        current_thread.buffer->thread_name = name;
+    }
+}
+
+void TraceRecorder::record(const char *name, const char *category, Phase phase, double value) {
+    if (not is_recording()) {
+        return;
+    }
+    auto time = Clock::now();
+    ThreadBuffer &thread_buffer = get_current_thread_buffer();
+    std::lock_guard<std::mutex> lock(thread_buffer.mutex);
+    if (thread_buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+        ++thread_buffer.num_dropped;
+        return;
+    }
+    thread_buffer.events.push_back({name, category, phase, time, value});
+}
+
+// NOTE: the buffer is found through a thread_local, so there can only be the one recorder (the global one)
+TraceRecorder::CurrentThreadBuffer &TraceRecorder::get_current_thread() {
+    thread_local CurrentThreadBuffer current_thread;
+    return current_thread;
+}
+
+TraceRecorder::ThreadBuffer &TraceRecorder::get_current_thread_buffer() {
+    CurrentThreadBuffer &current_thread = get_current_thread();
+    if (current_thread.buffer == nullptr) {
+        current_thread.buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(thread_buffers_mutex);
+        current_thread.buffer->thread_index = next_thread_index++;
+        current_thread.buffer->thread_name = current_thread.thread_name.empty()
+                                                 ? "thread " + std::to_string(current_thread.buffer->thread_index)
+                                                 : current_thread.thread_name;
+        thread_buffers.push_back(current_thread.buffer);
+    }
+    return *current_thread.buffer;
+}
+
+TraceRecorder::CurrentThreadBuffer::~CurrentThreadBuffer() {
+    if (buffer != nullptr) {
+        global_trace_recorder().release_thread_buffer(buffer);
+    }
+}
+
+// a buffer without events is dropped right away, one with events stays until they're written out or thrown away
+void TraceRecorder::release_thread_buffer(const std::shared_ptr<ThreadBuffer> &thread_buffer) {
+    std::lock_guard<std::mutex> lock(thread_buffers_mutex);
+    {
+        std::lock_guard<std::mutex> buffer_lock(thread_buffer->mutex);
+        thread_buffer->thread_exited = true;
+    }
+    remove_buffers_of_exited_threads();
+}
+
+void TraceRecorder::remove_buffers_of_exited_threads() {
+    std::erase_if(thread_buffers, [](const std::shared_ptr<ThreadBuffer> &thread_buffer) {
+        std::lock_guard<std::mutex> buffer_lock(thread_buffer->mutex);
+        return thread_buffer->thread_exited and thread_buffer->events.empty();
+    });
+}
+
+TraceRecorder &global_trace_recorder() {
+    static TraceRecorder trace_recorder;
+    return trace_recorder;
+}
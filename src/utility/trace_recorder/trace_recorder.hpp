@@ -0,0 +1,120 @@
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// spans and counters of what the editor is doing, written out as chrome trace event json which perfetto (or
+// chrome://tracing) shows as a timeline, one track per thread. Nothing is recorded until start is called and while
+// it isn't recording every call is a single relaxed load.
+//
+// every thread appends to a buffer of its own, the buffer has a mutex but the only other thread that ever takes it
+// is the one writing the trace out, so recording doesn't wait on anything in practice. A thread only gets a buffer
+// once it records something while a trace is running, and the buffer goes away with the thread (or once the trace is
+// written out if the thread still had events in it), so threads that come and go (every save runs on one) don't pile
+// up.
+//
+// spans that are still open when the trace is written out (the command that stopped the trace runs inside of a few)
+// are ended at the time the trace stopped, so every begin has an end
+//
+// NOTE: names and categories are stored as pointers, they have to be string literals
+class TraceRecorder {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // a thread stops recording once it has this many events, so a forgotten trace can't eat all the memory
+    static constexpr size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+    void start();
+    // stops recording and writes everything recorded since start to the file, returns false if that didn't work
+    bool stop_and_write(const std::string &file_path);
+    bool is_recording() const { return recording.load(std::memory_order_relaxed); }
+    // goes up every time a trace starts, so a span can tell whether it began in the trace that is running now
+    uint64_t get_trace_index() const { return trace_index.load(std::memory_order_relaxed); }
+
+    void begin_span(const char *name, const char *category);
+    void end_span(const char *name, const char *category);
+    void record_counter(const char *name, double value);
+    // shows up as the name of the track of the calling thread
+    void set_current_thread_name(const std::string &name);
+
+  private:
+    enum class Phase : char { BEGIN = 'B', END = 'E', COUNTER = 'C' };
+
+    struct Event {
+        const char *name;
+        const char *category;
+        Phase phase;
+        Clock::time_point time;
+        double value;
+    };
+
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        size_t thread_index;
+        std::string thread_name;
+        size_t num_dropped = 0;
+        // the thread is gone, the buffer is only still around for its events
+        bool thread_exited = false;
+    };
+
+    // owned by the thread, lets go of the buffer when the thread exits
+    struct CurrentThreadBuffer {
+        std::shared_ptr<ThreadBuffer> buffer;
+        std::string thread_name;
+        ~CurrentThreadBuffer();
+    };
+
+    std::atomic<bool> recording = false;
+    std::atomic<uint64_t> trace_index = 0;
+    Clock::time_point start_time;
+
+    std::mutex thread_buffers_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> thread_buffers;
+    size_t next_thread_index = 1;
+
+    static CurrentThreadBuffer &get_current_thread();
+    ThreadBuffer &get_current_thread_buffer();
+    void release_thread_buffer(const std::shared_ptr<ThreadBuffer> &thread_buffer);
+    // with the buffers mutex held
+    void remove_buffers_of_exited_threads();
+    void record(const char *name, const char *category, Phase phase, double value);
+};
+
+TraceRecorder &global_trace_recorder();
+
+// a span covering the scope it lives in, a span that started before the trace did isn't recorded at all
+class ScopedTraceSpan {
+  public:
+    ScopedTraceSpan(const char *name, const char *category) : name(name), category(category) {
+        if (global_trace_recorder().is_recording()) {
+            trace_index = global_trace_recorder().get_trace_index();
+            global_trace_recorder().begin_span(name, category);
+            began = true;
+        }
+    }
+    ~ScopedTraceSpan() {
+        // the trace it began in may have been written out (with the span ended) and another one started since
+        if (began and global_trace_recorder().get_trace_index() == trace_index) {
+            global_trace_recorder().end_span(name, category);
+        }
+    }
+
+    ScopedTraceSpan(const ScopedTraceSpan &) = delete;
+    ScopedTraceSpan &operator=(const ScopedTraceSpan &) = delete;
+
+  private:
+    const char *name;
+    const char *category;
+    bool began = false;
+    uint64_t trace_index = 0;
+};
+
+#endif // TRACE_RECORDER_HPP
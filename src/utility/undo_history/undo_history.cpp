@@ -0,0 +1,174 @@
+#include "undo_history.hpp"
+
+UndoHistory::UndoHistory(size_t memory_budget_bytes) : memory_budget_bytes(memory_budget_bytes) {}
+
+void UndoHistory::begin_group() {
+    group_is_open = true;
+    next_record_starts_group = true;
+}
+
+void UndoHistory::end_group() {
+    group_is_open = false;
+    next_record_starts_group = true;
+}
+
+size_t UndoHistory::get_num_bytes(const TextModification &modification) {
+    return sizeof(TextModification) + modification.new_content.size() + modification.replaced_content.size();
+}
+
+// only text typed or deleted on a single line gets merged, anything with newlines stays as it is because the inverse of
+// those is worked out differently (see get_inverse_modification)
+bool UndoHistory::try_to_merge(TextModification &previous, const TextModification &modification) {
+    const TextRange &previous_range = previous.text_range_to_replace;
+    const TextRange &range = modification.text_range_to_replace;
+
+    if (previous_range.start_line != range.start_line or previous_range.end_line != range.end_line or
+        range.start_line != range.end_line) {
+        return false;
+    }
+
+    auto is_single_line_insertion = [](const TextModification &m) {
+        return is_insertion(m) and m.replaced_content.empty() and m.new_content.find('\n') == std::string::npos;
+    };
+    auto is_single_line_deletion = [](const TextModification &m) {
+        return m.new_content.empty() and not m.replaced_content.empty() and
+               m.replaced_content.find('\n') == std::string::npos;
+    };
+
+    // typing, the new text starts right where the previous text ended
+    if (is_single_line_insertion(previous) and is_single_line_insertion(modification) and
+        range.start_col == previous_range.start_col + static_cast<int>(previous.new_content.size())) {
+        previous.new_content += modification.new_content;
+        return true;
+    }
+
+    if (is_single_line_deletion(previous) and is_single_line_deletion(modification)) {
+        // backspace, the deleted text ends where the previous deletion started
+        if (range.end_col == previous_range.start_col) {
+            previous.text_range_to_replace.start_col = range.start_col;
+            previous.replaced_content = modification.replaced_content + previous.replaced_content;
+            return true;
+        }
+        // delete, the text after the previous deletion slid into its place and got deleted too
+        if (range.start_col == previous_range.start_col) {
+            previous.text_range_to_replace.end_col += range.end_col - range.start_col;
+            previous.replaced_content += modification.replaced_content;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool UndoHistory::record(const TextModification &modification) {
+    drop_redoable_groups();
+
+    bool continues_last_group = group_is_open and not next_record_starts_group and not groups.empty();
+    next_record_starts_group = false;
+
+    if (continues_last_group) {
+        UndoGroup &group = groups.back();
+        TextModification &previous = group.modifications.back();
+        size_t previous_num_bytes = get_num_bytes(previous);
+        if (try_to_merge(previous, modification)) {
+            size_t merged_num_bytes = get_num_bytes(previous);
+            group.num_bytes += merged_num_bytes - previous_num_bytes;
+            num_bytes += merged_num_bytes - previous_num_bytes;
+        } else {
+            group.modifications.push_back(modification);
+            group.num_bytes += get_num_bytes(modification);
+            num_bytes += get_num_bytes(modification);
+        }
+    } else {
+        UndoGroup group;
+        group.modifications.push_back(modification);
+        group.num_bytes = get_num_bytes(modification);
+        num_bytes += group.num_bytes;
+        groups.push_back(std::move(group));
+        ++num_undoable_groups;
+    }
+
+    enforce_memory_budget();
+    return not continues_last_group;
+}
+
+const UndoGroup *UndoHistory::undo() {
+    if (not can_undo()) {
+        return nullptr;
+    }
+    // whatever comes after an undo is a new group, even in the middle of an insert session
+    next_record_starts_group = true;
+    --num_undoable_groups;
+    return &groups[num_undoable_groups];
+}
+
+const UndoGroup *UndoHistory::redo() {
+    if (not can_redo()) {
+        return nullptr;
+    }
+    next_record_starts_group = true;
+    ++num_undoable_groups;
+    return &groups[num_undoable_groups - 1];
+}
+
+const TextModification *UndoHistory::get_last_modification() const {
+    if (not can_undo()) {
+        return nullptr;
+    }
+    return &groups[num_undoable_groups - 1].modifications.back();
+}
+
+void UndoHistory::mark_saved() {
+    saved_position = num_undoable_groups;
+    saved_position_is_valid = true;
+    next_record_starts_group = true;
+}
+
+bool UndoHistory::move_to_saved_position() {
+    if (not saved_position_is_valid) {
+        return false;
+    }
+    num_undoable_groups = saved_position;
+    next_record_starts_group = true;
+    return true;
+}
+
+void UndoHistory::clear() {
+    groups.clear();
+    num_undoable_groups = 0;
+    num_bytes = 0;
+    next_record_starts_group = true;
+    saved_position_is_valid = false;
+}
+
+void UndoHistory::set_memory_budget(size_t memory_budget_bytes) {
+    this->memory_budget_bytes = memory_budget_bytes;
+    enforce_memory_budget();
+}
+
+void UndoHistory::drop_redoable_groups() {
+    while (groups.size() > num_undoable_groups) {
+        num_bytes -= groups.back().num_bytes;
+        groups.pop_back();
+    }
+    if (saved_position > groups.size()) {
+        saved_position_is_valid = false;
+    }
+}
+
+// the newest group always stays, even when it alone is over budget, otherwise the edit just made couldn't be undone
+void UndoHistory::enforce_memory_budget() {
+    while (num_bytes > memory_budget_bytes and groups.size() > 1) {
+        num_bytes -= groups.front().num_bytes;
+        groups.pop_front();
+        if (num_undoable_groups > 0) {
+            --num_undoable_groups;
+        }
+        // the state before the first group is gone now
+        if (saved_position == 0) {
+            saved_position_is_valid = false;
+        } else {
+            --saved_position;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef UNDO_HISTORY_HPP
+#define UNDO_HISTORY_HPP
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "../text_diff/text_diff.hpp"
+
+// a bunch of modifications that get undone and redone together, like everything typed in one insert mode session
+struct UndoGroup {
+    std::vector<TextModification> modifications;
+    size_t num_bytes = 0;
+};
+
+// the undo and redo history of one buffer.
+//
+// everything recorded between two calls to begin_group ends up in the same group, and inside of a group characters
+// typed one after another (or deleted one after another) are merged into a single modification, so a long insert
+// session is a handful of records instead of one per keystroke. Without begin_group every modification is its own
+// group.
+//
+// the groups live in one list, the ones before the cursor can be undone and the ones after it redone, so undo and redo
+// just move the cursor by one. Once the history takes up more memory than its budget the oldest groups are dropped.
+class UndoHistory {
+  public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET_BYTES = 64 * 1024 * 1024;
+
+    explicit UndoHistory(size_t memory_budget_bytes = DEFAULT_MEMORY_BUDGET_BYTES);
+
+    // everything recorded from here on until the next call goes into one group
+    void begin_group();
+    // the next modification starts a new group again
+    void end_group();
+
+    // throws away whatever could have been redone, returns whether the modification started a new group
+    bool record(const TextModification &modification);
+
+    bool can_undo() const { return num_undoable_groups > 0; }
+    bool can_redo() const { return num_undoable_groups < groups.size(); }
+    // the group moves over to the redo side, nullptr if there is nothing to undo. The pointer is good until the next
+    // call that changes the history
+    const UndoGroup *undo();
+    // the group moves back to the undo side, nullptr if there is nothing to redo
+    const UndoGroup *redo();
+
+    // the modification that was made last and hasn't been undone, nullptr if there is none
+    const TextModification *get_last_modification() const;
+
+    // remembers that the text as it is now is what's on disk, the next modification always starts a new group so
+    // that this stays a place the history can be moved back to
+    void mark_saved();
+    // false once the saved state has been thrown away, by new edits after undoing past it or by the memory budget
+    bool has_saved_position() const { return saved_position_is_valid; }
+    size_t get_saved_position() const { return saved_position; }
+    // moves the cursor to the saved state without changing any text, for when the text is known to be that state
+    bool move_to_saved_position();
+
+    const std::deque<UndoGroup> &get_groups() const { return groups; }
+    size_t get_num_undoable_groups() const { return num_undoable_groups; }
+
+    void clear();
+    void set_memory_budget(size_t memory_budget_bytes);
+    size_t get_memory_usage() const { return num_bytes; }
+
+  private:
+    std::deque<UndoGroup> groups;
+    size_t num_undoable_groups = 0;
+    size_t num_bytes = 0;
+    size_t memory_budget_bytes;
+
+    bool group_is_open = false;
+    bool next_record_starts_group = true;
+
+    // how many groups were undoable when the text was last saved
+    size_t saved_position = 0;
+    bool saved_position_is_valid = false;
+
+    static size_t get_num_bytes(const TextModification &modification);
+    static bool try_to_merge(TextModification &previous, const TextModification &modification);
+    void drop_redoable_groups();
+    void enforce_memory_budget();
+};
+
+#endif // UNDO_HISTORY_HPP
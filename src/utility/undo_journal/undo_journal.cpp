@@ -0,0 +1,415 @@
+#include "undo_journal.hpp"
+
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+
+#include "../mapped_file/mapped_file.hpp"
+#include "../ring_logger/ring_logger.hpp"
+
+static constexpr std::string_view JOURNAL_MAGIC = "TBXUNDO1";
+
+enum class RecordType : uint8_t {
+    MODIFICATION = 1,
+    MODIFICATION_STARTING_GROUP = 2,
+    UNDO = 3,
+    REDO = 4,
+    SAVED = 5,
+};
+
+static void write_varint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// negative numbers would take up all 10 bytes as a plain varint, this folds them in between the positive ones
+static void write_signed_varint(std::string &out, int64_t value) {
+    write_varint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+static void write_string(std::string &out, const std::string &text) {
+    write_varint(out, text.size());
+    out += text;
+}
+
+static size_t get_varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+static size_t get_signed_varint_size(int64_t value) {
+    return get_varint_size((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+static size_t get_string_size(const std::string &text) { return get_varint_size(text.size()) + text.size(); }
+
+// reads through a record, every read fails once the data runs out
+struct RecordReader {
+    const char *position;
+    const char *end;
+
+    bool read_varint(uint64_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (position == end) {
+                return false;
+            }
+            uint8_t byte = static_cast<uint8_t>(*position++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool read_signed_varint(int64_t &value) {
+        uint64_t folded;
+        if (not read_varint(folded)) {
+            return false;
+        }
+        value = static_cast<int64_t>(folded >> 1) ^ -static_cast<int64_t>(folded & 1);
+        return true;
+    }
+
+    bool read_int(int &value) {
+        int64_t wide;
+        if (not read_signed_varint(wide)) {
+            return false;
+        }
+        value = static_cast<int>(wide);
+        return true;
+    }
+
+    bool read_string(std::string &text) {
+        uint64_t size;
+        if (not read_varint(size) or size > static_cast<uint64_t>(end - position)) {
+            return false;
+        }
+        text.assign(position, size);
+        position += size;
+        return true;
+    }
+};
+
+// the payload has to be written right after this
+static void write_record_header(std::string &out, RecordType type, size_t payload_size) {
+    write_varint(out, payload_size + 1);
+    out.push_back(static_cast<char>(type));
+}
+
+// NOTE: the sizes are worked out up front so that the record can go straight into out, without the payload being put
+// together somewhere else first
+static void write_modification_record(std::string &out, const TextModification &modification, bool starts_group) {
+    const TextRange &range = modification.text_range_to_replace;
+    size_t payload_size = get_signed_varint_size(range.start_line) + get_signed_varint_size(range.start_col) +
+                          get_signed_varint_size(range.end_line) + get_signed_varint_size(range.end_col) +
+                          get_string_size(modification.new_content) + get_string_size(modification.replaced_content);
+    write_record_header(out, starts_group ? RecordType::MODIFICATION_STARTING_GROUP : RecordType::MODIFICATION,
+                        payload_size);
+    write_signed_varint(out, range.start_line);
+    write_signed_varint(out, range.start_col);
+    write_signed_varint(out, range.end_line);
+    write_signed_varint(out, range.end_col);
+    write_string(out, modification.new_content);
+    write_string(out, modification.replaced_content);
+}
+
+static void write_empty_record(std::string &out, RecordType type) { write_record_header(out, type, 0); }
+
+static void write_saved_record(std::string &out, uint64_t file_size, int64_t last_write_time) {
+    write_record_header(out, RecordType::SAVED, get_varint_size(file_size) + get_signed_varint_size(last_write_time));
+    write_varint(out, file_size);
+    write_signed_varint(out, last_write_time);
+}
+
+UndoJournal::~UndoJournal() { close(); }
+
+std::filesystem::path UndoJournal::get_journal_path(const std::string &file_path) {
+    std::filesystem::path directory;
+    const char *state_home = std::getenv("XDG_STATE_HOME");
+    const char *home = std::getenv("HOME");
+    if (state_home != nullptr and *state_home != '\0') {
+        directory = state_home;
+    } else if (home != nullptr and *home != '\0') {
+        directory = std::filesystem::path(home) / ".local" / "state";
+    } else {
+        return {};
+    }
+
+    std::error_code error_code;
+    std::string absolute_path = std::filesystem::absolute(file_path, error_code).lexically_normal().string();
+    if (error_code) {
+        return {};
+    }
+
+    // the whole path goes into the name (like vim's undodir does) so files with the same name don't share a journal
+    for (char &c : absolute_path) {
+        if (c == '/' or c == '\\' or c == ':') {
+            c = '%';
+        }
+    }
+    return directory / "tbx_edit" / "undo" / (absolute_path + ".undo");
+}
+
+bool UndoJournal::get_file_stamp(const std::string &file_path, FileStamp &stamp) {
+    std::error_code error_code;
+    auto size = std::filesystem::file_size(file_path, error_code);
+    if (error_code) {
+        return false;
+    }
+    auto last_write_time = std::filesystem::last_write_time(file_path, error_code);
+    if (error_code) {
+        return false;
+    }
+    stamp.size = size;
+    stamp.last_write_time = last_write_time.time_since_epoch().count();
+    return true;
+}
+
+// returns how many bytes of the journal were good, everything after that is either cut off or not a journal
+size_t UndoJournal::replay(const char *data, size_t size, UndoHistory &history, FileStamp &last_saved_stamp,
+                           bool &saw_saved_record) {
+    saw_saved_record = false;
+    if (size < JOURNAL_MAGIC.size() or std::string_view(data, JOURNAL_MAGIC.size()) != JOURNAL_MAGIC) {
+        return 0;
+    }
+
+    RecordReader journal{data + JOURNAL_MAGIC.size(), data + size};
+    size_t num_good_bytes = JOURNAL_MAGIC.size();
+
+    while (journal.position != journal.end) {
+        uint64_t record_size;
+        if (not journal.read_varint(record_size) or record_size == 0 or
+            record_size > static_cast<uint64_t>(journal.end - journal.position)) {
+            break;
+        }
+
+        RecordReader record{journal.position, journal.position + record_size};
+        journal.position += record_size;
+        auto type = static_cast<RecordType>(*record.position++);
+
+        if (type == RecordType::MODIFICATION or type == RecordType::MODIFICATION_STARTING_GROUP) {
+            TextModification modification = EMPTY_TEXT_DIFF;
+            TextRange &range = modification.text_range_to_replace;
+            if (not(record.read_int(range.start_line) and record.read_int(range.start_col) and
+                    record.read_int(range.end_line) and record.read_int(range.end_col) and
+                    record.read_string(modification.new_content) and
+                    record.read_string(modification.replaced_content))) {
+                break;
+            }
+            // the history makes the same grouping decisions again as long as it's told where groups started
+            if (type == RecordType::MODIFICATION_STARTING_GROUP) {
+                history.begin_group();
+            }
+            history.record(modification);
+        } else if (type == RecordType::UNDO) {
+            history.undo();
+        } else if (type == RecordType::REDO) {
+            history.redo();
+        } else if (type == RecordType::SAVED) {
+            uint64_t file_size;
+            int64_t last_write_time;
+            if (not(record.read_varint(file_size) and record.read_signed_varint(last_write_time))) {
+                break;
+            }
+            last_saved_stamp = {file_size, last_write_time};
+            saw_saved_record = true;
+            history.mark_saved();
+        } else {
+            break;
+        }
+
+        num_good_bytes = journal.position - data;
+    }
+
+    return num_good_bytes;
+}
+
+// the smallest journal that replays into this history, merged modifications are written out merged
+std::string UndoJournal::encode_history(const UndoHistory &history, const FileStamp &saved_stamp) {
+    std::string journal(JOURNAL_MAGIC);
+    const auto &groups = history.get_groups();
+    for (size_t i = 0; i < groups.size(); ++i) {
+        if (i == history.get_saved_position()) {
+            write_saved_record(journal, saved_stamp.size, saved_stamp.last_write_time);
+        }
+        bool starts_group = true;
+        for (const auto &modification : groups[i].modifications) {
+            write_modification_record(journal, modification, starts_group);
+            starts_group = false;
+        }
+    }
+    if (history.get_saved_position() >= groups.size()) {
+        write_saved_record(journal, saved_stamp.size, saved_stamp.last_write_time);
+    }
+
+    for (size_t i = history.get_num_undoable_groups(); i < groups.size(); ++i) {
+        write_empty_record(journal, RecordType::UNDO);
+    }
+    return journal;
+}
+
+bool UndoJournal::open(const std::string &file_path, UndoHistory &history) {
+    close();
+
+    std::filesystem::path journal_path = get_journal_path(file_path);
+    FileStamp current_stamp;
+    if (journal_path.empty() or not get_file_stamp(file_path, current_stamp)) {
+        return false;
+    }
+
+    bool restored = false;
+    bool journal_needs_rewrite = true;
+    {
+        std::error_code error_code;
+        MappedFile existing_journal;
+        if (std::filesystem::exists(journal_path, error_code) and existing_journal.open(journal_path.string())) {
+            FileStamp last_saved_stamp;
+            bool saw_saved_record;
+            size_t num_good_bytes = replay(existing_journal.data(), existing_journal.size(), history,
+                                           last_saved_stamp, saw_saved_record);
+
+            restored = saw_saved_record and last_saved_stamp == current_stamp and history.move_to_saved_position();
+            if (restored) {
+                // an old journal has a lot of history in it that was dropped or undone and overwritten long ago, once
+                // most of it is like that it's rewritten so that opening stays proportional to the history
+                bool mostly_dead_history = num_good_bytes > 2 * (history.get_memory_usage() + JOURNAL_MAGIC.size());
+                journal_needs_rewrite = num_good_bytes != existing_journal.size() or mostly_dead_history;
+            } else {
+                history.clear();
+            }
+        }
+    }
+
+    if (journal_needs_rewrite) {
+        if (not restored) {
+            history.mark_saved();
+        }
+        std::error_code error_code;
+        std::filesystem::create_directories(journal_path.parent_path(), error_code);
+
+        // written next to the old journal and moved over it, so dying halfway through never loses the old one
+        std::filesystem::path temporary_path = journal_path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream temporary_file(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!temporary_file.is_open()) {
+                LOG_ERROR("Unable to open undo journal {} for writing", temporary_path.string());
+                return restored;
+            }
+            std::string journal = encode_history(history, current_stamp);
+            temporary_file.write(journal.data(), journal.size());
+        }
+        std::filesystem::rename(temporary_path, journal_path, error_code);
+        if (error_code) {
+            LOG_ERROR("Unable to replace undo journal {}: {}", journal_path.string(), error_code.message());
+            return restored;
+        }
+    }
+
+    journal_file.open(journal_path, std::ios::binary | std::ios::app);
+    if (!journal_file.is_open()) {
+        LOG_ERROR("Unable to open undo journal {} for appending", journal_path.string());
+        return restored;
+    }
+
+    this->file_path = file_path;
+    this->journal_path = journal_path;
+    stop_requested = false;
+    writer_thread = std::thread(&UndoJournal::run_writer, this);
+    return restored;
+}
+
+void UndoJournal::close() {
+    if (not writer_thread.joinable()) {
+        return;
+    }
+    submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    condition.notify_all();
+    writer_thread.join();
+    journal_file.close();
+    pending_bytes.clear();
+}
+
+void UndoJournal::append_modification(const TextModification &modification, bool starts_group) {
+    if (is_open()) {
+        write_modification_record(unsubmitted_bytes, modification, starts_group);
+    }
+}
+
+void UndoJournal::append_undo() {
+    if (is_open()) {
+        write_empty_record(unsubmitted_bytes, RecordType::UNDO);
+    }
+}
+
+void UndoJournal::append_redo() {
+    if (is_open()) {
+        write_empty_record(unsubmitted_bytes, RecordType::REDO);
+    }
+}
+
+void UndoJournal::append_saved() {
+    FileStamp stamp;
+    if (not is_open() or not get_file_stamp(file_path, stamp)) {
+        return;
+    }
+    write_saved_record(unsubmitted_bytes, stamp.size, stamp.last_write_time);
+}
+
+void UndoJournal::submit() {
+    if (unsubmitted_bytes.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending_bytes.empty()) {
+            std::swap(pending_bytes, unsubmitted_bytes);
+        } else {
+            pending_bytes += unsubmitted_bytes;
+        }
+    }
+    unsubmitted_bytes.clear();
+    condition.notify_all();
+}
+
+void UndoJournal::flush() {
+    submit();
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&] { return (pending_bytes.empty() and not writing) or not writer_thread.joinable(); });
+}
+
+// everything that piled up since the last write goes out in one go, while typing fast that's many records per write
+void UndoJournal::run_writer() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        condition.wait(lock, [&] { return stop_requested or not pending_bytes.empty(); });
+        if (pending_bytes.empty()) {
+            break;
+        }
+
+        std::swap(bytes_being_written, pending_bytes);
+        writing = true;
+        lock.unlock();
+
+        journal_file.write(bytes_being_written.data(), bytes_being_written.size());
+        journal_file.flush();
+        bytes_being_written.clear();
+
+        lock.lock();
+        writing = false;
+        condition.notify_all();
+    }
+}
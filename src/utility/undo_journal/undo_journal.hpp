@@ -0,0 +1,99 @@
+#ifndef UNDO_JOURNAL_HPP
+#define UNDO_JOURNAL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../text_diff/text_diff.hpp"
+#include "../undo_history/undo_history.hpp"
+
+// keeps the undo history of a file on disk so that it survives closing the editor (or the editor crashing).
+//
+// the journal is append only, every change to the history (a recorded modification, an undo, a redo or a save) is
+// encoded into a few bytes and handed to a writer thread, so the input thread never waits on the disk. Records are
+// encoded straight into a buffer that's reused and only handed over on submit (once a frame), so a key press doesn't
+// allocate or take a lock. Opening a file
+// maps its journal and replays it into an UndoHistory, which takes time proportional to the history and not to the
+// file. The journal only gets used when the file on disk is still exactly what was last saved, otherwise the edits in
+// it no longer line up with the text and it is thrown away.
+//
+// a journal looks like this, every number is a varint:
+//
+//     "TBXUNDO1" record*
+//     record: payload_size type payload
+//
+// a record that was cut off (because the editor died halfway through writing it) ends the journal.
+class UndoJournal {
+  public:
+    UndoJournal() = default;
+    ~UndoJournal();
+
+    UndoJournal(const UndoJournal &) = delete;
+    UndoJournal &operator=(const UndoJournal &) = delete;
+
+    // where the journal of a file lives, empty when there is nowhere to put journals
+    static std::filesystem::path get_journal_path(const std::string &file_path);
+
+    // restores the history of the file from its journal into the (empty) history, and from then on everything below
+    // gets appended to that journal. Returns whether there was a history to restore, the history is left at the saved
+    // state because that's what the text on disk is, anything done after the last save can be redone
+    bool open(const std::string &file_path, UndoHistory &history);
+    void close();
+    bool is_open() const { return writer_thread.joinable(); }
+
+    void append_modification(const TextModification &modification, bool starts_group);
+    void append_undo();
+    void append_redo();
+    // call right after the file was written
+    void append_saved();
+
+    // hands everything appended since the last call to the writer thread, records that were never submitted are lost
+    // if the editor dies
+    void submit();
+    // blocks until everything appended so far is on disk
+    void flush();
+
+  private:
+    // what the file on disk looked like when it was last saved, if it looks any different now it was changed by
+    // something other than us
+    struct FileStamp {
+        uint64_t size = 0;
+        int64_t last_write_time = 0;
+
+        bool operator==(const FileStamp &other) const {
+            return size == other.size and last_write_time == other.last_write_time;
+        }
+    };
+
+    static bool get_file_stamp(const std::string &file_path, FileStamp &stamp);
+    static size_t replay(const char *data, size_t size, UndoHistory &history, FileStamp &last_saved_stamp,
+                         bool &saw_saved_record);
+    static std::string encode_history(const UndoHistory &history, const FileStamp &saved_stamp);
+
+    std::string file_path;
+    std::filesystem::path journal_path;
+    std::ofstream journal_file;
+
+    // records appended since the last submit, only ever touched by the thread appending
+    std::string unsubmitted_bytes;
+
+    // bytes waiting for the writer thread, the three buffers get swapped around instead of copied so their memory is
+    // reused
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::string pending_bytes;
+    bool writing = false;
+    bool stop_requested = false;
+    std::thread writer_thread;
+    // only touched by the writer thread
+    std::string bytes_being_written;
+
+    void run_writer();
+};
+
+#endif // UNDO_JOURNAL_HPP